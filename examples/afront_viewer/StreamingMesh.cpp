@@ -3,6 +3,7 @@
 #include <AntTweakBar.h>
 
 #include <ugl/ErrorCheck.hpp>
+#include <ugl/GLState.hpp>
 
 #include <sstream>
 
@@ -46,20 +47,20 @@ bool StreamingMesh::initGL()
 
     // Init buffers
     glGenVertexArrays(1, &this->vertexArray);
-    glBindVertexArray(this->vertexArray);
+    ugl::GLState::getInstance().bindVertexArray(this->vertexArray);
 
     glGenBuffers(1, &this->vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
     glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
 
     glGenBuffers(1, &this->normalBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, this->normalBuffer);
+    ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->normalBuffer);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
     glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
+    ugl::GLState::getInstance().bindVertexArray(0);
 
     glGenBuffers(1, &this->triangleBuffer);
     this->triangleCount = 0;
@@ -97,7 +98,7 @@ void StreamingMesh::draw(const ugl::StateSet& s)
 
     uniforms.set("alpha", this->alpha);
 
-    glBindVertexArray(this->vertexArray);
+    ugl::GLState::getInstance().bindVertexArray(this->vertexArray);
 
     if (this->drawSurface)
     {
@@ -105,7 +106,7 @@ void StreamingMesh::draw(const ugl::StateSet& s)
 
         state.apply(this->program);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->triangleBuffer);
+        ugl::GLState::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->triangleBuffer);
         glDrawElements(GL_TRIANGLES, this->triangleCount, GL_UNSIGNED_INT, nullptr);
     }
 
@@ -115,11 +116,11 @@ void StreamingMesh::draw(const ugl::StateSet& s)
 
         state.apply(this->program);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->edgeBuffer);
+        ugl::GLState::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->edgeBuffer);
         glDrawElements(GL_LINES, this->edgeCount, GL_UNSIGNED_INT, nullptr);
     }
 
-    glBindVertexArray(0);
+    ugl::GLState::getInstance().bindVertexArray(0);
 
     checkGLError();
 }
@@ -131,8 +132,6 @@ void StreamingMesh::draw(const ugl::StateSet& s)
  */
 ugl::BoundingBox StreamingMesh::getBoundingBox() const
 {
-    std::cout << this->boundingBox.getMin().x << ", " << this->boundingBox.getMin().y << ", " << this->boundingBox.getMin().z << " / " << this->boundingBox.getMax().x << ", " << this->boundingBox.getMax().y << ", " << this->boundingBox.getMax().z << std::endl;
-
     return this->boundingBox;
 }
 
@@ -197,7 +196,7 @@ void StreamingMesh::updateData()
         if (numVertices > 0)
         {
             // Update vertex buffer
-            glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+            ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
             glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(glm::vec3), &this->vertices[0], GL_DYNAMIC_DRAW);
         }
 
@@ -217,11 +216,11 @@ void StreamingMesh::updateData()
         for (glm::vec3& n : normals)
             n = glm::normalize(n);
 
-        glBindBuffer(GL_ARRAY_BUFFER, this->normalBuffer);
+        ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->normalBuffer);
         glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &normals[0], GL_DYNAMIC_DRAW);
 
         // Update triangle buffer
-        glBindBuffer(GL_ARRAY_BUFFER, this->triangleBuffer);
+        ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->triangleBuffer);
         glBufferData(GL_ARRAY_BUFFER, this->triangles.size() * sizeof(glm::uvec3), &this->triangles[0], GL_DYNAMIC_DRAW);
         this->triangleCount = this->triangles.size() * 3;
 
@@ -235,10 +234,10 @@ void StreamingMesh::updateData()
             edges.push_back(glm::uvec2(t.z, t.x));
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, this->edgeBuffer);
+        ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, this->edgeBuffer);
         glBufferData(GL_ARRAY_BUFFER, edges.size() * sizeof(glm::uvec2), &edges[0], GL_DYNAMIC_DRAW);
         this->edgeCount = edges.size() * 2;
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0);
     }
 }
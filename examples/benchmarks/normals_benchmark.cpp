@@ -0,0 +1,130 @@
+#include <ugl/MeshData.hpp>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+
+/**
+ * @brief Builds a wavy grid with about the given number of triangles.
+ */
+static void buildGrid(size_t triangleCount, std::vector<glm::vec3>& points, std::vector<glm::uvec3>& triangles)
+{
+    const GLuint size = (GLuint) std::ceil(std::sqrt(triangleCount / 2.0)) + 1u;
+
+    points.resize(size * size);
+    for (GLuint y = 0; y < size; ++y)
+        for (GLuint x = 0; x < size; ++x)
+            points[y * size + x] = glm::vec3(x, y, std::sin(0.1f * x) * std::cos(0.1f * y));
+
+    triangles.clear();
+    triangles.reserve(2 * (size - 1) * (size - 1));
+    for (GLuint y = 0; y + 1 < size; ++y)
+        for (GLuint x = 0; x + 1 < size; ++x)
+        {
+            const GLuint p = y * size + x;
+            triangles.push_back(glm::uvec3(p, p + 1, p + size));
+            triangles.push_back(glm::uvec3(p + 1, p + size + 1, p + size));
+        }
+}
+
+
+/**
+ * @brief The former serial scatter-add: each triangle adds its normal to its
+ * three points, then all normals are normalized.
+ */
+static void scatterNormals(const std::vector<glm::vec3>& points, const std::vector<glm::uvec3>& triangles,
+                           std::vector<glm::vec3>& normals)
+{
+    normals.assign(points.size(), glm::vec3(0.0f));
+
+    for (std::vector<glm::uvec3>::const_iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+    {
+        const glm::vec3& p0 = points[triangle->x];
+        const glm::vec3 normal = glm::cross(points[triangle->y] - p0, points[triangle->z] - p0);
+
+        normals[triangle->x] += normal;
+        normals[triangle->y] += normal;
+        normals[triangle->z] += normal;
+    }
+
+    for (std::vector<glm::vec3>::iterator normal = normals.begin(); normal != normals.end(); ++normal)
+        if (glm::dot(*normal, *normal) > 0.0f)
+            *normal = glm::normalize(*normal);
+}
+
+
+static double millisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * Compares MeshData::recomputeVertexNormals() (parallel gather over the point
+ * to triangle adjacency) with a serial scatter-add.
+ *
+ * Usage: normals_benchmark [triangles in millions ...], default 1 10 50.
+ */
+int main(int argc, char* argv[])
+{
+    std::vector<double> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::atof(argv[i]));
+    if (sizes.empty())
+    {
+        sizes.push_back(1.0);
+        sizes.push_back(10.0);
+        sizes.push_back(50.0);
+    }
+
+    const int repetitions = 3;
+
+    for (std::vector<double>::const_iterator size = sizes.begin(); size != sizes.end(); ++size)
+    {
+        std::vector<glm::vec3>  points;
+        std::vector<glm::uvec3> triangles;
+        buildGrid((size_t) (*size * 1e6), points, triangles);
+
+        ugl::MeshData data;
+        data.setPoints(points);
+        data.setTriangles(triangles);
+
+        // the adjacency is built once per topology and timed separately
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        data.recomputePointTriangles();
+        const double adjacency = millisecondsSince(start);
+
+        std::vector<glm::vec3> reference;
+        double scatter = 1e30, gather = 1e30;
+
+        for (int repetition = 0; repetition < repetitions; ++repetition)
+        {
+            start = std::chrono::steady_clock::now();
+            scatterNormals(points, triangles, reference);
+            scatter = std::min(scatter, millisecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            data.recomputeVertexNormals();
+            gather = std::min(gather, millisecondsSince(start));
+        }
+
+        float maxError = 0.0f;
+        for (size_t pointId = 0; pointId < points.size(); ++pointId)
+            maxError = std::max(maxError, glm::length(data.getVertexNormal(pointId) - reference[pointId]));
+
+        std::cout << triangles.size() << " triangles: "
+                  << "serial scatter " << scatter << " ms, "
+                  << "parallel gather " << gather << " ms "
+                  << "(+ adjacency " << adjacency << " ms), "
+                  << "speedup " << scatter / gather << ", "
+                  << "max difference " << maxError << std::endl;
+    }
+
+    return 0;
+}
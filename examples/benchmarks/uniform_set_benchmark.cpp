@@ -0,0 +1,117 @@
+#include <ugl/UniformSet.hpp>
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+
+static size_t allocationCount = 0;
+
+/// number of measurements which allocated after the warm-up
+static int failures = 0;
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+
+    if (void* out = std::malloc(size ? size : 1))
+        return out;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+/**
+ * @brief Runs fn for the given number of iterations after a few warm-up runs
+ * and reports the allocations and time per iteration. Any allocation after
+ * the warm-up counts as a failure.
+ */
+template<typename Function>
+static void measure(const char* label, int iterations, Function fn)
+{
+    for (int i = 0; i < 3; ++i)
+        fn(i);
+
+    const size_t allocations = allocationCount;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+        fn(i);
+
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t steadyAllocations = allocationCount - allocations;
+
+    std::cout << label << ": "
+              << steadyAllocations << " allocations, "
+              << nanoseconds / iterations << " ns per set()"
+              << (steadyAllocations > 0 ? " FAILED" : "") << std::endl;
+
+    if (steadyAllocations > 0)
+        ++failures;
+}
+
+
+/**
+ * Shows that repeated UniformSet::set() calls do not allocate once each value
+ * has its slot, also for arrays which change their size. Exits with status 1
+ * if any measurement allocated.
+ */
+int main()
+{
+    const int iterations = 1000000;
+
+    ugl::UniformSet uniforms;
+
+    const std::string alphaName("alpha");
+    const std::string matrixName("matrix");
+    const std::string weightsName("weights");
+
+    std::vector<float> small(8, 1.0f), large(256, 1.0f), larger(1024, 1.0f);
+
+    measure("float by name", iterations, [&](int i)
+    {
+        uniforms.set(alphaName, (float) i);
+    });
+
+    measure("mat4 by name", iterations, [&](int)
+    {
+        uniforms.set(matrixName, glm::mat4(1.0f));
+    });
+
+    ugl::UniformHandle<glm::mat4> matrix = uniforms.handle(matrixName);
+
+    measure("mat4 by handle", iterations, [&](int)
+    {
+        uniforms.set(matrix, glm::mat4(1.0f));
+    });
+
+    measure("array of 256 floats", iterations, [&](int)
+    {
+        uniforms.set(weightsName, large);
+    });
+
+    // the region of the largest size is kept for the smaller values
+    measure("array of 8, 256 or 1024 floats", iterations, [&](int i)
+    {
+        uniforms.set(weightsName, i % 3 == 0 ? small : i % 3 == 1 ? large : larger);
+    });
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " steady-state measurements allocated" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
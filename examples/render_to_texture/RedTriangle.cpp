@@ -1,5 +1,7 @@
 #include "RedTriangle.hpp"
 
+#include <ugl/GLState.hpp>
+
 /**
  * @brief Constructor.
  */
@@ -11,15 +13,15 @@ RedTriangle::RedTriangle()
     this->vertices[2] = glm::vec3(0.0f, 1.0f, 0.0f);
 
     glGenVertexArrays(1, &this->vao);
-    glBindVertexArray(this->vao);
+    ugl::GLState::getInstance().bindVertexArray(this->vao);
     GLuint vbo;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    ugl::GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, 9 * sizeof(float), this->vertices, GL_STATIC_DRAW);
     glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
     glEnableVertexAttribArray( 0u );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
-    glBindVertexArray(0u);
+    ugl::GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
+    ugl::GLState::getInstance().bindVertexArray(0u);
 
     // Init fullscreen quad
     glGenVertexArrays(1, &this->fullScreenQuadVAO);
@@ -57,7 +59,7 @@ void RedTriangle::draw(const ugl::StateSet& state)
     this->framebuffer.checkCompleteness();
 
     // Bind offscreen buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer.getFramebuffer());
+    ugl::GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, this->framebuffer.getFramebuffer());
 
     // Clear it
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -66,12 +68,12 @@ void RedTriangle::draw(const ugl::StateSet& state)
 
     // Render triangle
     myState.apply(this->triangleProgram);
-    glBindVertexArray(this->vao);
+    ugl::GLState::getInstance().bindVertexArray(this->vao);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
 
     // Restore previous draw buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, previousDrawBuffer);
+    ugl::GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, previousDrawBuffer);
 
     // Set uniforms
     myState.getOrCreateUniforms().setTexture("colorTexture", GL_TEXTURE_RECTANGLE, this->framebuffer.getColorTexture());
@@ -80,9 +82,9 @@ void RedTriangle::draw(const ugl::StateSet& state)
     // Render fullscreen quad
     myState.apply(this->displayProgram);
 
-    glBindVertexArray(this->fullScreenQuadVAO);
+    ugl::GLState::getInstance().bindVertexArray(this->fullScreenQuadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    ugl::GLState::getInstance().bindVertexArray(0);
 }
 
 
@@ -1,5 +1,7 @@
 #include "SkullVolume.hpp"
 
+#include <ugl/GLState.hpp>
+
 
 // init the 1 dimentional texture for transfer function
 GLuint initTFF1DTex(const char* filename)
@@ -33,7 +35,7 @@ GLuint initTFF1DTex(const char* filename)
     GLuint tff1DTex;
 
     glGenTextures(1, &tff1DTex);
-    glBindTexture(GL_TEXTURE_1D_ARRAY, tff1DTex);
+    ugl::GLState::getInstance().bindTexture(GL_TEXTURE_1D_ARRAY, tff1DTex);
 
     int n = 256;
     int numTransferFunctions = 1;
@@ -45,7 +47,7 @@ GLuint initTFF1DTex(const char* filename)
     glTexParameteri(GL_TEXTURE_1D_ARRAY,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_1D_ARRAY,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
 
-    glBindTexture(GL_TEXTURE_1D_ARRAY, 0);
+    ugl::GLState::getInstance().bindTexture(GL_TEXTURE_1D_ARRAY, 0);
 
     free(tff);
     return tff1DTex;
@@ -81,7 +83,7 @@ GLuint initVol3DTex(const char* filename, GLuint w, GLuint h, GLuint d)
     GLuint volTex;
     glGenTextures(1, &volTex);
     // bind 3D texture target
-    glBindTexture(GL_TEXTURE_3D, volTex);
+    ugl::GLState::getInstance().bindTexture(GL_TEXTURE_3D, volTex);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -115,8 +117,8 @@ SkullVolume::SkullVolume(const ugl::BoundingBox& boundingBox, const std::string&
  */
 SkullVolume::~SkullVolume()
 {
-    glDeleteTextures(1, &this->intensityTexture3D);
-    glDeleteTextures(1, &this->transferTexture1D);
+    ugl::GLState::getInstance().deleteTextures(1, &this->intensityTexture3D);
+    ugl::GLState::getInstance().deleteTextures(1, &this->transferTexture1D);
 }
 
 
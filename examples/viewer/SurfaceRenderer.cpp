@@ -4,6 +4,8 @@
 
 #include "SurfaceRenderer.hpp"
 
+#include <ugl/GLState.hpp>
+
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -65,7 +67,7 @@ GLuint prepareStaticBuffer( const std::vector<T>& data )
     GLuint buffer;
 
     glGenBuffers( 1, &buffer );
-    glBindBuffer( GL_ARRAY_BUFFER, buffer );
+    ugl::GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, buffer );
 
     glBufferData( GL_ARRAY_BUFFER, sizeof(T)*data.size(), &data[0], GL_STATIC_DRAW );
 
@@ -140,28 +142,28 @@ void SurfaceRenderer::prepareVertexArrays( const SurfaceVectorData& svd )
 
     // set up the vertex array and attribute bindings
     glGenVertexArrays( 1, &m_vertexArray );
-    glBindVertexArray( m_vertexArray );
+    ugl::GLState::getInstance().bindVertexArray( m_vertexArray );
 
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffer );
+    ugl::GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_vertexBuffer );
     glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 0, NULL );
     glEnableVertexAttribArray( 0 );
 
-    glBindBuffer( GL_ARRAY_BUFFER, m_vectorBuffer );
+    ugl::GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_vectorBuffer );
     glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, 0, NULL );
     glEnableVertexAttribArray( 1 );
 
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexNormalBuffer );
+    ugl::GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_vertexNormalBuffer );
     glVertexAttribPointer( 2, 3, GL_FLOAT, GL_FALSE, 0, NULL );
     glEnableVertexAttribArray( 2 );
 
-    glBindVertexArray( 0 );
+    ugl::GLState::getInstance().bindVertexArray( 0 );
 
     // NOTE: we do not bind an ELEMENT_ARRAY here, since we will switch
     // on the fly between triangle and edge indices depending on render mode
 
     // set up buffer texture for face normals
     glGenTextures( 1, &m_faceNormalTex );
-    glBindTexture( GL_TEXTURE_BUFFER, m_faceNormalTex );
+    ugl::GLState::getInstance().bindTexture( GL_TEXTURE_BUFFER, m_faceNormalTex );
     glTexBuffer( GL_TEXTURE_BUFFER, GL_RGB32F, m_faceNormalBuffer );
     // assign buffer texture
     m_stateSet.getOrCreateUniforms().setTexture( "faceNormal",
@@ -182,7 +184,7 @@ void SurfaceRenderer::draw( const ugl::StateSet &state )
     modes.setOrClear( "SHOW_VECTORS",      m_showVectors );
 
     // set render modes and issue draw calls
-    glBindVertexArray( m_vertexArray );
+    ugl::GLState::getInstance().bindVertexArray( m_vertexArray );
 
     if( m_drawSurface )
     {
@@ -192,12 +194,12 @@ void SurfaceRenderer::draw( const ugl::StateSet &state )
         m_stateSet.apply(m_program);
 
         glPolygonOffset( 1.0, 2.0 );
-        glEnable( GL_POLYGON_OFFSET_FILL );
+        ugl::GLState::getInstance().enable( GL_POLYGON_OFFSET_FILL );
 
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_triIndexBuffer );
+        ugl::GLState::getInstance().bindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_triIndexBuffer );
         glDrawElements( GL_TRIANGLES, m_triIndexSize, GL_UNSIGNED_INT, (GLvoid*)0 );
 
-        glDisable( GL_POLYGON_OFFSET_FILL );
+        ugl::GLState::getInstance().disable( GL_POLYGON_OFFSET_FILL );
     }
 
     if( m_drawEdges )
@@ -211,20 +213,20 @@ void SurfaceRenderer::draw( const ugl::StateSet &state )
         {
             glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
             glDepthMask( GL_FALSE );
-            glEnable( GL_BLEND );
+            ugl::GLState::getInstance().enable( GL_BLEND );
         }
 
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_edgeIndexBuffer );
+        ugl::GLState::getInstance().bindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_edgeIndexBuffer );
         glDrawElements( GL_LINES, m_edgeIndexSize, GL_UNSIGNED_INT, (GLvoid*)0 );
 
         if( modes.exists( "DEPTH_PEELING" ) )
         {
             glDepthMask( GL_TRUE );
-            glDisable( GL_BLEND );
+            ugl::GLState::getInstance().disable( GL_BLEND );
         }
     }
 
-    glBindVertexArray( 0 );
+    ugl::GLState::getInstance().bindVertexArray( 0 );
     // done drawing
 }
 
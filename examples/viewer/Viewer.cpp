@@ -33,6 +33,13 @@ void Viewer::initGL()
     lightGlossiness = 16.0;
     defaultColor    = glm::vec3( 1.0, 0.8, 0.2 );
 
+    // resolve the uniforms which change every frame only once
+    ugl::UniformSet& uniforms = stateSet.getOrCreateUniforms();
+    projectionMatrixHandle        = uniforms.handle( "globals.projectionMatrix" );
+    modelviewMatrixHandle         = uniforms.handle( "globals.modelviewMatrix" );
+    normalMatrixHandle            = uniforms.handle( "globals.normalMatrix" );
+    projectionMatrixInverseHandle = uniforms.handle( "globals.projectionMatrixInverse" );
+    modelviewMatrixInverseHandle  = uniforms.handle( "globals.modelviewMatrixInverse" );
 
     TwInit( TW_OPENGL_CORE, NULL );
 
@@ -101,12 +108,12 @@ void Viewer::drawGL()
     glm::mat4 projectionMatrix = viewCtrl.projection();
     glm::mat4 modelviewMatrix = viewCtrl.transform();
 
-    uniforms.set( "globals.projectionMatrix", projectionMatrix );
-    uniforms.set( "globals.modelviewMatrix",  modelviewMatrix );
-    uniforms.set( "globals.normalMatrix",     viewCtrl.rotation() );
+    uniforms.set( projectionMatrixHandle, projectionMatrix );
+    uniforms.set( modelviewMatrixHandle,  modelviewMatrix );
+    uniforms.set( normalMatrixHandle,     viewCtrl.rotation() );
 
-    uniforms.set( "globals.projectionMatrixInverse", glm::inverse(projectionMatrix));
-    uniforms.set( "globals.modelviewMatrixInverse",  glm::inverse(modelviewMatrix));
+    uniforms.set( projectionMatrixInverseHandle, glm::inverse(projectionMatrix));
+    uniforms.set( modelviewMatrixInverseHandle,  glm::inverse(modelviewMatrix));
 
     uniforms.set("globals.viewport", glm::ivec4(0, 0, size.x, size.y));
 
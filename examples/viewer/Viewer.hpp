@@ -36,6 +36,12 @@ private:
     ugl::TransparentRenderStage* transparentRenderStage;
 
     ugl::StateSet stateSet;
+    ugl::UniformHandle<glm::mat4> projectionMatrixHandle;
+    ugl::UniformHandle<glm::mat4> modelviewMatrixHandle;
+    ugl::UniformHandle<glm::mat3> normalMatrixHandle;
+    ugl::UniformHandle<glm::mat4> projectionMatrixInverseHandle;
+    ugl::UniformHandle<glm::mat4> modelviewMatrixInverseHandle;
+
     glm::vec3 lightDirection;
     float lightGlossiness;
     glm::vec3 defaultColor;
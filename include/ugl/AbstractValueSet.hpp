@@ -22,8 +22,10 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #ifndef _ABSTRACTVALUESET_HPP_
 #define _ABSTRACTVALUESET_HPP_
 
+#include "Utils.hpp"
+
+#include <algorithm>
 #include <map>
-#include <stack>
 #include <string>
 
 namespace ugl
@@ -36,9 +38,13 @@ namespace ugl
  * name (as string).
  *
  * If the value is not found in the current ValueSet, its parents are
- * recursively visited to look for the value.
+ * recursively visited to look for the value. Both the set a name resolves to
+ * and the merged view of the hierarchy (see getMergedMap()) are cached and
+ * only rebuilt if a set in the chain changed or the parent was replaced, which
+ * is detected through the generation counter each set carries (see
+ * nextGeneration()).
  *
- * Used as the base class for ModeSet and UniformSet.
+ * Used as the base class for ModeSet.
  */
 template <typename T>
 class AbstractValueSet
@@ -54,6 +60,8 @@ public:
 
     void setParent(const AbstractValueSet* parent);
 
+    unsigned long getGeneration() const;
+
 protected:
 
     typedef std::map< std::string, T > named_value_map;
@@ -62,14 +70,34 @@ protected:
 
     const AbstractValueSet* m_parent;
 
-    named_value_map getMergedMap() const;
+    /// generation of the last change of this set (not of its parents)
+    unsigned long m_generation;
+
+    void setValue( const std::string& name, const T& value );
+
+    const named_value_map& getMergedMap() const;
+
+private:
+    mutable named_value_map         m_merged;
+    mutable unsigned long           m_mergedGeneration;
+    mutable const AbstractValueSet* m_mergedOwner;
+
+    /// resolved names, pointing into m_values of the set holding the value
+    mutable std::map< std::string, const T* > m_resolved;
+    mutable unsigned long           m_resolvedGeneration;
+    mutable const AbstractValueSet* m_resolvedOwner;
 };
 
 // -------------------------------------------------------------------------
 
 template <typename T>
 AbstractValueSet<T>::AbstractValueSet() :
-    m_parent(nullptr)
+    m_parent(nullptr),
+    m_generation(nextGeneration()),
+    m_mergedGeneration(0u),
+    m_mergedOwner(nullptr),
+    m_resolvedGeneration(0u),
+    m_resolvedOwner(nullptr)
 {
 }
 
@@ -81,7 +109,10 @@ void AbstractValueSet<T>::clear( const std::string& name )
     typename named_value_map::iterator it = m_values.find( name );
 
     if( it != m_values.end() )
+    {
         m_values.erase( it );
+        m_generation = nextGeneration();
+    }
 }
 
 // -------------------------------------------------------------------------
@@ -89,7 +120,11 @@ void AbstractValueSet<T>::clear( const std::string& name )
 template <typename T>
 void AbstractValueSet<T>::clear()
 {
-    m_values.clear();
+    if( !m_values.empty() )
+    {
+        m_values.clear();
+        m_generation = nextGeneration();
+    }
 }
 
 // -------------------------------------------------------------------------
@@ -102,22 +137,40 @@ bool AbstractValueSet<T>::exists( const std::string& name ) const
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Looks up a value in this set and its parents. The resolution of each
+ * found name is cached until a set in the chain changes.
+ * @return A pointer into the set holding the value, valid until the value is
+ * cleared there, or null.
+ */
 template <typename T>
 const T* AbstractValueSet<T>::get( const std::string& name ) const
 {
-    const AbstractValueSet* valueSet = this;
+    const unsigned long generation = getGeneration();
 
-    do
+    // the owner check catches caches copied along with the set
+    if (m_resolvedOwner != this || m_resolvedGeneration != generation)
     {
-        typename named_value_map::const_iterator it =
-                valueSet->m_values.find(name);
+        m_resolved.clear();
+        m_resolvedGeneration = generation;
+        m_resolvedOwner      = this;
+    }
+
+    typename std::map< std::string, const T* >::const_iterator resolved = m_resolved.find(name);
+    if (resolved != m_resolved.end())
+        return resolved->second;
+
+    // values are updated in place, so the pointers stay valid until the
+    // generation changes; missing names are not cached
+    for (const AbstractValueSet* valueSet = this; valueSet; valueSet = valueSet->m_parent)
+    {
+        typename named_value_map::const_iterator it = valueSet->m_values.find(name);
         if (it != valueSet->m_values.end())
         {
+            m_resolved.insert(std::make_pair(name, &(it->second)));
             return &(it->second);
         }
-
-        valueSet = valueSet->m_parent;
-    } while (valueSet);
+    }
 
     return nullptr;
 }
@@ -127,39 +180,71 @@ const T* AbstractValueSet<T>::get( const std::string& name ) const
 template <typename T>
 inline void AbstractValueSet<T>::setParent(const AbstractValueSet* parent)
 {
-    m_parent = parent;
+    if (m_parent != parent)
+    {
+        m_parent = parent;
+        m_generation = nextGeneration();
+    }
 }
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Returns the newest generation of this set and its parents, i.e. the
+ * value changes whenever any set in the chain is modified.
+ */
 template <typename T>
-typename AbstractValueSet<T>::named_value_map
-        AbstractValueSet<T>::getMergedMap() const
+unsigned long AbstractValueSet<T>::getGeneration() const
 {
-    std::stack<const AbstractValueSet*> parents;
-    const AbstractValueSet* valueSet = this;
+    unsigned long out = 0u;
 
-    // Walk to top, push all ValueSets on stack.
-    do
-    {
-        parents.push(valueSet);
-        valueSet = valueSet->m_parent;
-    } while (valueSet);
-
-    // Merge all value maps from top to bottom
-    named_value_map out(parents.top()->m_values);
-    parents.pop();
-    while (!parents.empty())
-    {
-        valueSet = parents.top();
-        out.insert(valueSet->m_values.begin(), valueSet->m_values.end());
-        parents.pop();
-    }
+    for (const AbstractValueSet* valueSet = this; valueSet; valueSet = valueSet->m_parent)
+        out = std::max(out, valueSet->m_generation);
 
     return out;
 }
 
 // -------------------------------------------------------------------------
 
+template <typename T>
+void AbstractValueSet<T>::setValue( const std::string& name, const T& value )
+{
+    typename named_value_map::iterator it = m_values.find( name );
+
+    if( it == m_values.end() )
+        m_values.insert( std::make_pair(name, value) );
+    else if( !(it->second == value) )
+        it->second = value;
+    else
+        return;
+
+    m_generation = nextGeneration();
+}
+
+// -------------------------------------------------------------------------
+
+template <typename T>
+const typename AbstractValueSet<T>::named_value_map&
+        AbstractValueSet<T>::getMergedMap() const
+{
+    const unsigned long generation = getGeneration();
+
+    // the owner check catches caches copied along with the set
+    if (m_mergedOwner == this && m_mergedGeneration == generation)
+        return m_merged;
+
+    // Merge all value maps from bottom to top, values further down win
+    m_merged = m_values;
+    for (const AbstractValueSet* valueSet = m_parent; valueSet; valueSet = valueSet->m_parent)
+        m_merged.insert(valueSet->m_values.begin(), valueSet->m_values.end());
+
+    m_mergedGeneration = generation;
+    m_mergedOwner      = this;
+
+    return m_merged;
+}
+
+// -------------------------------------------------------------------------
+
 } // namespace ugl
 #endif
@@ -44,6 +44,8 @@ public:
     glm::vec3 normalizePosition(const glm::vec3& position) const;
 
     float diagonal() const;
+    bool isEmpty() const;
+    bool contains(const BoundingBox& other) const;
 
     const BoundingBox &add(const BoundingBox& other);
     const BoundingBox &add(const glm::vec3& v);
@@ -78,6 +80,24 @@ inline glm::vec3 BoundingBox::normalizePosition(const glm::vec3& position) const
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Returns whether nothing was added to the box yet, i.e. min > max.
+ */
+inline bool BoundingBox::isEmpty() const
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool BoundingBox::contains(const BoundingBox& other) const
+{
+    return other.min.x >= min.x && other.min.y >= min.y && other.min.z >= min.z
+        && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+}
+
+// -------------------------------------------------------------------------
+
 inline void BoundingBox::clear(glm::vec3 v) //Default: (0,0,0)
 {
     this->min = v;
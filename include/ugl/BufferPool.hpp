@@ -0,0 +1,205 @@
+/** @file BufferPool.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _BUFFERPOOL_HPP_
+#define _BUFFERPOOL_HPP_
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Suballocates static vertex, index and texture buffer data from a few large
+ * GL buffers ("pages") instead of creating one buffer object per array.
+ *
+ * Each page keeps a free list of offset-sorted blocks which are coalesced on
+ * release; allocations are placed first-fit and aligned to ALIGNMENT bytes,
+ * which satisfies vertex attribute as well as texture buffer offsets. Requests
+ * larger than the page size get a page of their own.
+ *
+ * Allocations are referred to by handles and remember an owner (usually the
+ * drawable), so all allocations of a drawable can be released at once.
+ *
+ * compact() moves all allocations to the front of freshly allocated pages and
+ * releases the old ones. Since offsets and buffers change, owners have to
+ * re-specify their attribute pointers whenever getGeneration() changed.
+ *
+ * The pool does not delete its buffers on destruction (the context may be gone
+ * by then); call clear() while the context is current if needed.
+ */
+class BufferPool
+{
+public:
+    typedef GLuint Handle;
+
+    /// refers to no allocation
+    static const Handle INVALID_HANDLE = ~0u;
+
+    /// alignment of all offsets in bytes
+    static const GLsizeiptr ALIGNMENT = 256;
+
+    struct Allocation
+    {
+        GLuint      buffer;
+        GLintptr    offset;
+        GLsizeiptr  size;
+        GLsizeiptr  capacity;   ///< aligned size of the block, 0 for unused handles
+        GLuint      page;
+        const void* owner;
+    };
+
+    struct Statistics
+    {
+        size_t pages;
+        size_t allocations;
+        size_t capacity;            ///< bytes in all pages
+        size_t used;                ///< bytes in allocations (incl. alignment)
+        size_t freeBlocks;
+        size_t largestFreeBlock;
+
+        /// 1 - largestFreeBlock / free bytes, 0 if the free space is contiguous
+        float  fragmentation;
+    };
+
+    static BufferPool& getInstance()
+    {
+        static BufferPool instance;
+        return instance;
+    }
+
+    Handle allocate(GLsizeiptr size, const GLvoid* data, const void* owner);
+
+    template <typename T>
+    Handle allocate(const std::vector<T>& data, const void* owner);
+
+    void upload(Handle handle, GLintptr offset, GLsizeiptr size, const GLvoid* data);
+    void download(Handle handle, GLintptr offset, GLsizeiptr size, GLvoid* data) const;
+
+    void release(Handle handle);
+    void releaseAll(const void* owner);
+
+    const Allocation& get(Handle handle) const;
+    const GLvoid* getOffsetPointer(Handle handle) const;
+    size_t getOwnerBytes(const void* owner) const;
+
+    Statistics getStatistics() const;
+    unsigned long getGeneration() const;
+
+    void compact();
+    void clear();
+
+    void setPageSize(GLsizeiptr pageSize);
+    GLsizeiptr getPageSize() const;
+
+private:
+    BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    void operator=(const BufferPool&) = delete;
+
+    struct Page
+    {
+        GLuint                          buffer;
+        GLsizeiptr                      size;
+        GLsizeiptr                      used;
+        std::map<GLintptr, GLsizeiptr>  freeBlocks;  ///< offset -> size
+    };
+
+    GLuint createPage(GLsizeiptr size);
+    bool allocateInPage(GLuint page, GLsizeiptr size, GLintptr* offset);
+    void releaseInPage(GLuint page, GLintptr offset, GLsizeiptr size);
+    Handle createHandle(const Allocation& allocation);
+
+    static GLsizeiptr align(GLsizeiptr size);
+
+    std::vector<Page>         m_pages;
+    std::vector<Allocation>   m_allocations;
+    std::vector<Handle>       m_freeHandles;
+
+    GLsizeiptr                m_pageSize;
+    unsigned long             m_generation;
+};
+
+// -------------------------------------------------------------------------
+
+template <typename T>
+inline BufferPool::Handle BufferPool::allocate(const std::vector<T>& data, const void* owner)
+{
+    return allocate(data.size() * sizeof(T), data.empty() ? nullptr : &data[0], owner);
+}
+
+// -------------------------------------------------------------------------
+
+inline const BufferPool::Allocation& BufferPool::get(Handle handle) const
+{
+    return m_allocations[handle];
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the offset of an allocation as pointer, as expected by
+ * glVertexAttribPointer and glDrawElements.
+ */
+inline const GLvoid* BufferPool::getOffsetPointer(Handle handle) const
+{
+    return (const GLvoid*) m_allocations[handle].offset;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns a generation which changes whenever allocations are moved,
+ * see compact().
+ */
+inline unsigned long BufferPool::getGeneration() const
+{
+    return m_generation;
+}
+
+// -------------------------------------------------------------------------
+
+inline void BufferPool::setPageSize(GLsizeiptr pageSize)
+{
+    m_pageSize = align(pageSize);
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizeiptr BufferPool::getPageSize() const
+{
+    return m_pageSize;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizeiptr BufferPool::align(GLsizeiptr size)
+{
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+} // namespace ugl
+#endif // _BUFFERPOOL_HPP_
@@ -35,10 +35,23 @@ namespace ugl
 
 /**
  * Data class for multiple curves of different lengths.
+ *
+ * Simplified versions of all curves can be precomputed for level of detail
+ * rendering, see computeSimplifiedLevels(). They only select points, so
+ * per-point values apply to every level. Adding points discards them.
  */
 class CurvesData
 {
 public:
+    /// a subset of the points of each curve, see computeSimplifiedLevels()
+    struct SimplifiedLevel
+    {
+        float                   tolerance;
+        std::vector<GLuint>     pointIds;       ///< kept points of all curves
+        std::vector<GLint>      startIndices;   ///< first entry of each curve in pointIds
+        std::vector<GLsizei>    pointCounts;
+    };
+
     CurvesData();
 
     GLsizei                         getCurveCount() const;
@@ -62,6 +75,10 @@ public:
     const std::vector<GLint>&       getAllCurveIdsOfPointIds();
     void                            recomputeCurveIdsOfPointIds();
 
+    void                            computeSimplifiedLevels(const std::vector<float>& tolerances);
+    GLsizei                         getSimplifiedLevelCount() const;
+    const SimplifiedLevel&          getSimplifiedLevel(GLint level) const;
+
 private:
     std::vector<glm::vec3>  m_points;
     std::vector<GLint>      m_startPointIds;
@@ -72,6 +89,8 @@ private:
 
     bool                    m_curveIdsOfPointIdsValid;
     std::vector<GLint>      m_curveIdsOfPointIds;
+
+    std::vector<SimplifiedLevel> m_simplifiedLevels;
 };
 
 // -------------------------------------------------------------------------
@@ -170,5 +189,19 @@ inline const std::vector<GLint>& CurvesData::getAllCurveIdsOfPointIds()
     return m_curveIdsOfPointIds;
 }
 
+// -------------------------------------------------------------------------
+
+inline GLsizei CurvesData::getSimplifiedLevelCount() const
+{
+    return m_simplifiedLevels.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline const CurvesData::SimplifiedLevel& CurvesData::getSimplifiedLevel(GLint level) const
+{
+    return m_simplifiedLevels[level];
+}
+
 } // namespace ugl
 #endif // _CURVESDATA_HPP_
@@ -27,6 +27,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #include <GL/glew.h>
 
 #include "BoundingBox.hpp"
+#include "BufferPool.hpp"
 #include "CurvesData.hpp"
 #include "Drawable.hpp"
 #include "StateSet.hpp"
@@ -52,6 +53,22 @@ namespace ugl
  *     `Minimum Color` (default red) for small values and `Maximum Color`
  *     (default green) for big values. These modes and colors can be changed in
  *     the `Curves` TweakBar.
+ *
+ * Vertex data and curve colors are suballocated from the BufferPool; the curve
+ * colors get a buffer of their own if ARB_texture_buffer_range is missing.
+ *
+ * The shader takes the curve id for the color lookup from gl_DrawIDARB of the
+ * glMultiDrawArrays call. Without ARB_shader_draw_parameters, each curve is
+ * an indirect draw command whose base instance selects the curve id from a
+ * per-curve instanced attribute. Contexts without indirect draws (before
+ * OpenGL 4.3 and without ARB_multi_draw_indirect) fall back to one curve id
+ * per point (see CurvesData::getAllCurveIdsOfPointIds()).
+ *
+ * If the CurvesData has simplified levels (see
+ * CurvesData::computeSimplifiedLevels()), their point ids are uploaded as
+ * index buffers. Each frame the coarsest level whose tolerance projects to
+ * at most getPixelTolerance() pixels (at the point of the bounding sphere
+ * closest to the camera) is drawn; level 0 is the full data.
  */
 class CurvesDrawable : public Drawable
 {
@@ -64,6 +81,18 @@ public:
 
     void getTweakableParameters(bool** colorCurves, float** alpha);
 
+    /// 1 + number of simplified levels
+    GLsizei getLevelCount() const;
+
+    /// level drawn last
+    GLint getCurrentLevel() const;
+
+    /// -1 selects by projected error, otherwise the level to draw
+    void setForcedLevel( GLint level );
+
+    void setPixelTolerance( float pixels );
+    float getPixelTolerance() const;
+
 protected:
     /**
      * Set up shader program.
@@ -71,17 +100,71 @@ protected:
     void prepareShaderProgram();
 
     void prepareVertexArrays( CurvesData& data );
+    void bindVertexBuffers();
+
+    void prepareLevels( CurvesData& data );
+    void uploadLevelCommands();
+    GLint selectLevel( const StateSet& state ) const;
+
+    /// where the shader takes the curve id from
+    enum CurveIdSource
+    {
+        DRAW_ID,            ///< gl_DrawIDARB
+        BASE_INSTANCE,      ///< per-curve attribute, indirect draws
+        VERTEX_ATTRIBUTE    ///< per-point attribute
+    };
+
+    static CurveIdSource getCurveIdSource();
+
+    /// struct of glMultiDrawArraysIndirect commands
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    /// struct of glMultiDrawElementsIndirect commands
+    struct DrawElementsCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    /// a simplified level, drawn with glMultiDrawElements (indirect for BASE_INSTANCE)
+    struct Level
+    {
+        float                      tolerance;
+        BufferPool::Handle         indices;
+        BufferPool::Handle         commands;    ///< BASE_INSTANCE only
+        std::vector<GLint>         startIndices;
+        std::vector<GLsizei>       indexCounts;
+        std::vector<const GLvoid*> offsets;     ///< start indices as pool offsets
+    };
 
     VariantProgram          m_program;
     StateSet                m_stateSet;
 
     GLuint                  m_vertexArray;
-    GLuint                  m_vertexPositionBuffer;
-    GLuint                  m_vertexCurveIdBuffer;
-    GLuint                  m_curveColorBuffer;
+    BufferPool::Handle      m_vertexPositionBuffer;
+    const CurveIdSource     m_curveIdSource;
+    BufferPool::Handle      m_curveIdBuffer;        ///< per curve or per point, fallback only
+    BufferPool::Handle      m_commandBuffer;        ///< BASE_INSTANCE only
+    BufferPool::Handle      m_curveColorBuffer;     ///< invalid if not pooled
+    GLuint                  m_curveColorOwnBuffer;  ///< without ARB_texture_buffer_range
     GLuint                  m_curveColorTex;
+    unsigned long           m_bufferGeneration;
     std::vector<GLint>      m_startIndices;
     std::vector<GLsizei>    m_indexCounts;
+    std::vector<Level>      m_levels;
+
+    GLint                   m_currentLevel;
+    GLint                   m_forcedLevel;
+    float                   m_pixelTolerance;
 
     Values*                 m_values;
 
@@ -93,16 +176,44 @@ protected:
 
 // -------------------------------------------------------------------------
 
-inline CurvesDrawable::~CurvesDrawable()
+inline BoundingBox CurvesDrawable::getBoundingBox() const
 {
-    delete m_values;
+    return m_boundingBox;
 }
 
 // -------------------------------------------------------------------------
 
-inline BoundingBox CurvesDrawable::getBoundingBox() const
+inline GLsizei CurvesDrawable::getLevelCount() const
 {
-    return m_boundingBox;
+    return m_levels.size() + 1;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLint CurvesDrawable::getCurrentLevel() const
+{
+    return m_currentLevel;
+}
+
+// -------------------------------------------------------------------------
+
+inline void CurvesDrawable::setForcedLevel( GLint level )
+{
+    m_forcedLevel = level;
+}
+
+// -------------------------------------------------------------------------
+
+inline void CurvesDrawable::setPixelTolerance( float pixels )
+{
+    m_pixelTolerance = pixels;
+}
+
+// -------------------------------------------------------------------------
+
+inline float CurvesDrawable::getPixelTolerance() const
+{
+    return m_pixelTolerance;
 }
 
 } // namespace ugl
@@ -0,0 +1,212 @@
+/** @file CurvesIndex.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _CURVESINDEX_HPP_
+#define _CURVESINDEX_HPP_
+
+#include "BoundingBox.hpp"
+#include "CurvesData.hpp"
+#include "Frustum.hpp"
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Spatial index over the line segments of a CurvesData for selection and
+ * brushing on the CPU.
+ *
+ * Consecutive curves are collected into groups of about GROUP_SEGMENTS
+ * segments, each with a bounding box and a small bounding volume hierarchy
+ * (median splits) over its segments. Since curves are only appended to a
+ * CurvesData, update() adds the new curves to the last group or opens new
+ * ones and rebuilds just the groups it touched.
+ *
+ * Queries test the group boxes first, so the groups also serve for frustum
+ * culling of curve ranges. A segment is identified by the id of its first
+ * point.
+ */
+class CurvesIndex
+{
+public:
+    struct Hit
+    {
+        GLint curveId;
+        GLint pointId;          ///< point of the segment closest to the ray
+        float distance;         ///< between ray and curve
+        float rayDistance;      ///< in multiples of the ray direction
+    };
+
+    static const GLsizei GROUP_SEGMENTS = 4096;
+    static const GLsizei LEAF_SIZE      = 8;
+
+    CurvesIndex();
+
+    void update(const CurvesData& data);
+    void clear();
+
+    bool nearest(const CurvesData& data, const glm::vec3& origin, const glm::vec3& direction,
+                 float radius, Hit* hit) const;
+    bool nearest(const CurvesData& data, const glm::mat4& projection, const glm::mat4& modelview,
+                 const glm::vec2& position, float radius, Hit* hit) const;
+
+    void findCurves(const CurvesData& data, const BoundingBox& box, std::vector<GLint>& curveIds) const;
+    void findCurves(const CurvesData& data, const glm::vec3& center, float radius,
+                    std::vector<GLint>& curveIds) const;
+
+    void cullGroups(const Frustum& frustum, std::vector<GLint>& groups) const;
+
+    GLsizei getGroupCount() const;
+    const BoundingBox& getGroupBoundingBox(GLint group) const;
+    GLint getGroupFirstCurve(GLint group) const;
+    GLsizei getGroupCurveCount(GLint group) const;
+
+    GLsizei getIndexedCurveCount() const;
+
+private:
+    /// a leaf if count > 0, else its children are at index + 1 and right
+    struct Node
+    {
+        BoundingBox box;
+        GLuint      first;
+        GLuint      count;
+        GLuint      right;
+    };
+
+    struct Group
+    {
+        BoundingBox         box;
+        GLint               firstCurve;
+        GLsizei             curveCount;
+        std::vector<GLuint> segments;   ///< first point of each segment
+        std::vector<Node>   nodes;
+    };
+
+    void buildGroup(const CurvesData& data, Group& group) const;
+    GLuint buildNode(const std::vector<glm::vec3>& points, Group& group, GLuint first, GLuint count) const;
+    GLint getCurveOfPoint(const CurvesData& data, const Group& group, GLuint pointId) const;
+
+    template <typename NodeTest, typename SegmentVisitor>
+    void traverse(const Group& group, NodeTest nodeTest, SegmentVisitor visitor) const;
+
+    std::vector<Group> m_groups;
+
+    GLsizei            m_indexedCurves;
+    GLsizei            m_indexedPoints;     ///< of the last indexed curve
+};
+
+// -------------------------------------------------------------------------
+
+inline CurvesIndex::CurvesIndex() :
+    m_indexedCurves(0),
+    m_indexedPoints(0)
+{
+}
+
+// -------------------------------------------------------------------------
+
+inline void CurvesIndex::clear()
+{
+    m_groups.clear();
+    m_indexedCurves = 0;
+    m_indexedPoints = 0;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei CurvesIndex::getGroupCount() const
+{
+    return m_groups.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline const BoundingBox& CurvesIndex::getGroupBoundingBox(GLint group) const
+{
+    return m_groups[group].box;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLint CurvesIndex::getGroupFirstCurve(GLint group) const
+{
+    return m_groups[group].firstCurve;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei CurvesIndex::getGroupCurveCount(GLint group) const
+{
+    return m_groups[group].curveCount;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei CurvesIndex::getIndexedCurveCount() const
+{
+    return m_indexedCurves;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Depth-first traversal of the nodes of a group which pass nodeTest;
+ * calls visitor with the first point of each segment in passing leaves.
+ */
+template <typename NodeTest, typename SegmentVisitor>
+void CurvesIndex::traverse(const Group& group, NodeTest nodeTest, SegmentVisitor visitor) const
+{
+    if (group.nodes.empty())
+        return;
+
+    GLuint stack[64];
+    int    size = 0;
+
+    stack[size++] = 0u;
+
+    while (size > 0)
+    {
+        const Node& node = group.nodes[stack[--size]];
+        const GLuint index = &node - group.nodes.data();
+
+        if (!nodeTest(node.box))
+            continue;
+
+        if (node.count > 0u)
+        {
+            for (GLuint slot = node.first; slot < node.first + node.count; ++slot)
+                visitor(group.segments[slot]);
+        }
+        else
+        {
+            stack[size++] = node.right;
+            stack[size++] = index + 1u;
+        }
+    }
+}
+
+} // namespace ugl
+#endif // _CURVESINDEX_HPP_
@@ -25,6 +25,9 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #include <GL/glew.h>
 
 #include "Drawable.hpp"
+#include "DrawableHierarchy.hpp"
+#include "Frustum.hpp"
+#include "RenderQueue.hpp"
 #include "ShaderProgram.hpp"
 #include "StateSet.hpp"
 
@@ -36,6 +39,13 @@ namespace ugl
 /**
  * Renders its \ref Drawable "Drawables" straight into the
  * framebuffer.
+ *
+ * Drawables outside the view frustum are culled (see DrawableHierarchy). The
+ * frustum is taken from the projection and modelview matrices of the StateSet
+ * unless a camera is set explicitly.
+ *
+ * With recording enabled, drawables which support Drawable::record() are
+ * drawn through a RenderQueue sorted by state; the others are drawn after it.
  */
 class DefaultRenderStage
 {
@@ -55,11 +65,30 @@ public:
 
     int getNumVisibleDrawables();
 
+    void setRecordingEnabled( bool enabled );
+    bool isRecordingEnabled() const;
+    const RenderQueue& getRenderQueue() const;
+
+    void setCullingEnabled( bool enabled );
+    bool isCullingEnabled() const;
+    void setCamera( const glm::mat4& projection, const glm::mat4& modelview );
+    void clearCamera();
+    const DrawableHierarchy::Statistics& getCullingStatistics() const;
+
 protected:
 
     std::vector<Drawable*>  m_drawables;
     StateSet                m_stateSet;
 
+    bool                    m_recording;
+    RenderQueue             m_queue;
+
+    bool                    m_culling;
+    bool                    m_hasCamera;
+    Frustum                 m_camera;
+    DrawableHierarchy       m_hierarchy;
+    std::vector<Drawable*>  m_visibleDrawables;
+
     //background
     GLuint m_bgVAO;
     VariantProgram m_bgProgram;
@@ -79,6 +108,50 @@ inline int DefaultRenderStage::getNumVisibleDrawables()
     return numVisD;
 }
 
+inline void DefaultRenderStage::setRecordingEnabled( bool enabled )
+{
+    m_recording = enabled;
+}
+
+inline bool DefaultRenderStage::isRecordingEnabled() const
+{
+    return m_recording;
+}
+
+inline const RenderQueue& DefaultRenderStage::getRenderQueue() const
+{
+    return m_queue;
+}
+
+inline void DefaultRenderStage::setCullingEnabled( bool enabled )
+{
+    m_culling = enabled;
+}
+
+inline bool DefaultRenderStage::isCullingEnabled() const
+{
+    return m_culling;
+}
+
+/**
+ * @brief Culls against the given camera instead of the matrices of the StateSet.
+ */
+inline void DefaultRenderStage::setCamera( const glm::mat4& projection, const glm::mat4& modelview )
+{
+    m_camera.set( projection, modelview );
+    m_hasCamera = true;
+}
+
+inline void DefaultRenderStage::clearCamera()
+{
+    m_hasCamera = false;
+}
+
+inline const DrawableHierarchy::Statistics& DefaultRenderStage::getCullingStatistics() const
+{
+    return m_hierarchy.getStatistics();
+}
+
 } // namespace ugl
 
 #endif // __DefaultRenderStage_hpp
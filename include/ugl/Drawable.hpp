@@ -28,9 +28,15 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 namespace ugl
 {
 
+class RenderQueue;
+
 /**
  * Every node in the scene graph should be of type Drawable and thus provide a
  * draw() method which is called by the RenderStage on each render pass.
+ *
+ * Drawables may additionally implement record(), which emits their draw calls
+ * into a RenderQueue instead of issuing them. Render stages with recording
+ * enabled use it to sort the draw calls of all drawables by state.
  */
 class Drawable
 {
@@ -39,10 +45,11 @@ public:
     virtual ~Drawable();
 
     virtual void draw( const StateSet& state ) = 0;
+    virtual bool record( const StateSet& state, RenderQueue& queue );
     virtual BoundingBox getBoundingBox() const = 0;
 
     void setVisible(bool visible);
-    bool isVisible();
+    bool isVisible() const;
 
 private:
     bool visible;
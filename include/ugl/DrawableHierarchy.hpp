@@ -0,0 +1,107 @@
+/** @file DrawableHierarchy.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _DRAWABLEHIERARCHY_HPP_
+#define _DRAWABLEHIERARCHY_HPP_
+
+#include "BoundingBox.hpp"
+#include "Drawable.hpp"
+#include "Frustum.hpp"
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Culls the \ref Drawable "Drawables" of a render stage against a Frustum.
+ *
+ * From MIN_DRAWABLES drawables on, a bounding volume hierarchy over their
+ * bounding boxes is used. Its topology is built when the drawables change
+ * (see invalidate()) and its boxes are refit on every cull(), so drawables may
+ * move or grow without a rebuild.
+ */
+class DrawableHierarchy
+{
+public:
+    struct Statistics
+    {
+        unsigned int drawn;     ///< visible and inside the frustum
+        unsigned int culled;    ///< visible but outside the frustum
+    };
+
+    /// below this number of drawables, each box is tested on its own
+    static const size_t MIN_DRAWABLES = 32u;
+
+    DrawableHierarchy();
+
+    void invalidate();
+
+    void cull(const std::vector<Drawable*>& drawables, const Frustum& frustum,
+              std::vector<Drawable*>& visible);
+
+    const Statistics& getStatistics() const;
+
+private:
+    /// a leaf if count > 0, else its children are at index + 1 and right
+    struct Node
+    {
+        BoundingBox box;
+        int         first;
+        int         count;
+        int         right;
+    };
+
+    static const int LEAF_SIZE = 4;
+
+    void build(const std::vector<Drawable*>& drawables);
+    int buildNode(int first, int count);
+    void refit(const std::vector<Drawable*>& drawables);
+
+    bool                      m_valid;
+    std::vector<int>          m_order;    ///< drawable index per leaf slot
+    std::vector<BoundingBox>  m_boxes;    ///< per drawable index
+    std::vector<Node>         m_nodes;
+    std::vector<char>         m_inside;   ///< per drawable index
+
+    Statistics                m_statistics;
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Forces a rebuild of the hierarchy, to be called when drawables are
+ * added or removed.
+ */
+inline void DrawableHierarchy::invalidate()
+{
+    m_valid = false;
+}
+
+// -------------------------------------------------------------------------
+
+inline const DrawableHierarchy::Statistics& DrawableHierarchy::getStatistics() const
+{
+    return m_statistics;
+}
+
+} // namespace ugl
+#endif // _DRAWABLEHIERARCHY_HPP_
@@ -22,14 +22,48 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #ifndef ERRORCHECK_HPP
 #define ERRORCHECK_HPP
 
+#include <GL/glew.h>
+
 #include <string>
 
 namespace ugl
 {
-void checkAndPrintGLError(std::string label, const char* file, int line);
 
+/**
+ * Reporting of OpenGL errors through KHR_debug (see setGLDebugLevel()):
+ *
+ * - Off:         no debug output; checkGLError() polls glGetError
+ * - Async:       the driver reports errors and warnings through a callback,
+ *                possibly some time after the offending call
+ * - Synchronous: the callback runs inside the offending call and the
+ *                messages name the debug groups active at that time
+ *
+ * While debug output is enabled, checkGLError() does not poll. In release
+ * builds (NDEBUG) the checkGLError() macros are compiled out entirely.
+ */
+enum class GLDebugLevel
+{
+    Off,
+    Async,
+    Synchronous
+};
+
+bool setGLDebugLevel(GLDebugLevel level);
+GLDebugLevel getGLDebugLevel();
+
+void pushGLDebugGroup(const char* label);
+void popGLDebugGroup();
+void labelGLObject(GLenum identifier, GLuint name, const std::string& label);
+
+void checkAndPrintGLError(const std::string& label, const char* file, int line);
+
+#ifdef NDEBUG
+#define checkGLError() {}
+#define checkGLErrorLabel(label) {}
+#else
 #define checkGLError() { ugl::checkAndPrintGLError("",  __FILE__, __LINE__ ); }
 #define checkGLErrorLabel(label) { ugl::checkAndPrintGLError(label,  __FILE__, __LINE__ ); }
+#endif
 }
 
 #endif // ERRORCHECK_HPP
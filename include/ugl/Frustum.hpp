@@ -0,0 +1,90 @@
+/** @file Frustum.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _FRUSTUM_HPP_
+#define _FRUSTUM_HPP_
+
+#include "BoundingBox.hpp"
+
+#include <glm/glm.hpp>
+
+namespace ugl
+{
+
+class StateSet;
+
+/**
+ * A view frustum given by six planes in object space, extracted from a
+ * combined projection and modelview matrix.
+ *
+ * Empty bounding boxes (see BoundingBox::isEmpty()) are never culled, since
+ * they usually belong to drawables which do not know their extent yet.
+ */
+class Frustum
+{
+public:
+    Frustum();
+    Frustum(const glm::mat4& projection, const glm::mat4& modelview);
+
+    void set(const glm::mat4& projection, const glm::mat4& modelview);
+    bool setFromStateSet(const StateSet& state);
+
+    static bool getViewMatrices(const StateSet& state,
+                                glm::mat4* projection, glm::mat4* modelview);
+
+    bool intersects(const BoundingBox& box) const;
+
+private:
+    /// left, right, bottom, top, near, far; inside where dot(plane, p) >= 0
+    glm::vec4 planes[6];
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Tests the box against each plane using the corner furthest along
+ * the plane normal.
+ * @return False only if the box lies completely outside the frustum.
+ */
+inline bool Frustum::intersects(const BoundingBox& box) const
+{
+    if (box.isEmpty())
+        return true;
+
+    const glm::vec3& min = box.getMin();
+    const glm::vec3& max = box.getMax();
+
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        const glm::vec4& p = planes[plane];
+        const glm::vec3 corner(p.x >= 0.0f ? max.x : min.x,
+                               p.y >= 0.0f ? max.y : min.y,
+                               p.z >= 0.0f ? max.z : min.z);
+
+        if (glm::dot(glm::vec3(p), corner) + p.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace ugl
+#endif // _FRUSTUM_HPP_
@@ -24,6 +24,8 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include <GL/glew.h>
 
+#include "GLState.hpp"
+
 #include <vector>
 
 namespace ugl
@@ -53,10 +55,10 @@ GLuint GLHelper::prepareStaticBuffer(const std::vector<T>& data)
     GLuint buffer;
     glGenBuffers( 1, &buffer );
 
-    glBindBuffer( GL_ARRAY_BUFFER, buffer );
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, buffer );
     glBufferData( GL_ARRAY_BUFFER, data.size() * sizeof(T), &data[0],
                   GL_STATIC_DRAW );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
 
     return buffer;
 }
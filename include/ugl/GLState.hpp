@@ -0,0 +1,322 @@
+/** @file GLState.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _GLSTATE_HPP_
+#define _GLSTATE_HPP_
+
+#include <GL/glew.h>
+
+#include <map>
+#include <utility>
+
+namespace ugl
+{
+
+/**
+ * Shadows the OpenGL binding state (program, vertex array, buffers, textures,
+ * image units, framebuffers and enabled capabilities) and drops calls which
+ * would not change it.
+ *
+ * All binding calls of ugl go through this class; application code which
+ * mixes in raw GL calls has to go through it as well or call invalidate()
+ * afterwards. CoreApplication::uglDraw() calls beginFrame(), so state changed
+ * by GUI toolkits between frames is never trusted.
+ *
+ * Deleting objects through the delete*() methods keeps the shadow state
+ * consistent when names are reused by the driver.
+ *
+ * If enabled with setBindlessTexturesEnabled() and ARB_bindless_texture is
+ * available, textures are referenced by resident handles instead of texture
+ * units (see getTextureHandle()). Handles are made non-resident when the
+ * texture is deleted through deleteTextures().
+ *
+ * With validation enabled (default if UGL_VALIDATE_GL_STATE is defined) the
+ * shadow state is compared against glGet after every call and mismatches are
+ * printed to stderr.
+ */
+class GLState
+{
+public:
+    struct Counters
+    {
+        unsigned long issued;   ///< calls passed on to OpenGL
+        unsigned long elided;   ///< redundant calls which were dropped
+    };
+
+    static GLState& getInstance()
+    {
+        static GLState instance;
+        return instance;
+    }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    void bindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void setEnabled(GLenum capability, bool enabled);
+
+    void deleteBuffers(GLsizei n, const GLuint* buffers);
+    void deleteTextures(GLsizei n, const GLuint* textures);
+    void deleteVertexArrays(GLsizei n, const GLuint* vertexArrays);
+    void deleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+
+    bool setBindlessTexturesEnabled(bool enabled);
+    bool isBindlessTexturesEnabled() const;
+    GLuint64 getTextureHandle(GLuint texture);
+    bool hasTextureHandle(GLuint texture) const;
+
+    void invalidate();
+    void beginFrame();
+
+    const Counters& getCounters() const;
+    const Counters& getLastFrameCounters() const;
+
+    void setValidationEnabled(bool enabled);
+    bool isValidationEnabled() const;
+    bool validate() const;
+
+private:
+    GLState();
+
+    GLState(const GLState&) = delete;
+    void operator=(const GLState&) = delete;
+
+    bool elide(bool redundant);
+
+    /// marks a shadow binding as unknown
+    static const GLuint UNKNOWN = ~0u;
+
+    struct ImageUnit
+    {
+        GLuint    texture;
+        GLint     level;
+        GLboolean layered;
+        GLint     layer;
+        GLenum    access;
+        GLenum    format;
+    };
+
+    typedef std::pair<GLenum, GLuint> IndexedTarget;
+    typedef std::pair<GLuint, GLenum> TextureTarget;
+
+    GLuint                              m_program;
+    GLuint                              m_vertexArray;
+    GLuint                              m_activeTexture;
+    GLuint                              m_drawFramebuffer;
+    GLuint                              m_readFramebuffer;
+    std::map<GLenum, GLuint>            m_buffers;
+    std::map<IndexedTarget, GLuint>     m_indexedBuffers;
+    std::map<TextureTarget, GLuint>     m_textures;
+    std::map<GLuint, ImageUnit>         m_imageUnits;
+    std::map<GLenum, bool>              m_capabilities;
+
+    Counters m_counters;
+    Counters m_lastFrameCounters;
+
+    bool m_validate;
+
+    bool                                m_bindlessTextures;
+    std::map<GLuint, GLuint64>          m_residentTextures;
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Counts a call as elided or issued.
+ * @return Whether the call has to be dropped.
+ */
+inline bool GLState::elide(bool redundant)
+{
+    if (redundant)
+        ++m_counters.elided;
+    else
+        ++m_counters.issued;
+
+    return redundant;
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::useProgram(GLuint program)
+{
+    if (elide(m_program == program))
+        return;
+
+    glUseProgram(program);
+    m_program = program;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::bindVertexArray(GLuint vertexArray)
+{
+    if (elide(m_vertexArray == vertexArray))
+        return;
+
+    glBindVertexArray(vertexArray);
+    m_vertexArray = vertexArray;
+
+    // the element array binding is part of the vertex array state
+    m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::activeTexture(GLenum unit)
+{
+    const GLuint index = unit - GL_TEXTURE0;
+
+    if (elide(m_activeTexture == index))
+        return;
+
+    glActiveTexture(unit);
+    m_activeTexture = index;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Binds a texture to the active texture unit (like glBindTexture).
+ */
+inline void GLState::bindTexture(GLenum target, GLuint texture)
+{
+    if (m_activeTexture == UNKNOWN)
+        activeTexture(GL_TEXTURE0);
+
+    bindTexture(m_activeTexture, target, texture);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Binds a texture to the given texture unit, switching the active unit
+ * only if the binding changes.
+ */
+inline void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    GLuint& bound = m_textures.insert(
+            std::make_pair(TextureTarget(unit, target), UNKNOWN)).first->second;
+
+    if (elide(bound == texture))
+        return;
+
+    activeTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, texture);
+    bound = texture;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+inline bool GLState::isBindlessTexturesEnabled() const
+{
+    return m_bindlessTextures;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the resident bindless handle of a texture, creating it on
+ * first use. The sampling state of the texture must not change afterwards.
+ */
+inline GLuint64 GLState::getTextureHandle(GLuint texture)
+{
+    std::map<GLuint, GLuint64>::const_iterator it = m_residentTextures.find(texture);
+    if (it != m_residentTextures.end())
+        return it->second;
+
+    const GLuint64 handle = glGetTextureHandleARB(texture);
+    glMakeTextureHandleResidentARB(handle);
+    m_residentTextures.insert(std::make_pair(texture, handle));
+
+    return handle;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Whether a bindless handle was created for the texture, which makes
+ * its storage and sampling state immutable until it is deleted.
+ */
+inline bool GLState::hasTextureHandle(GLuint texture) const
+{
+    return m_residentTextures.find(texture) != m_residentTextures.end();
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::enable(GLenum capability)
+{
+    setEnabled(capability, true);
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::disable(GLenum capability)
+{
+    setEnabled(capability, false);
+}
+
+// -------------------------------------------------------------------------
+
+inline const GLState::Counters& GLState::getCounters() const
+{
+    return m_counters;
+}
+
+// -------------------------------------------------------------------------
+
+inline const GLState::Counters& GLState::getLastFrameCounters() const
+{
+    return m_lastFrameCounters;
+}
+
+// -------------------------------------------------------------------------
+
+inline void GLState::setValidationEnabled(bool enabled)
+{
+    m_validate = enabled;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool GLState::isValidationEnabled() const
+{
+    return m_validate;
+}
+
+} // namespace ugl
+#endif // _GLSTATE_HPP_
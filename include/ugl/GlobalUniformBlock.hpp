@@ -0,0 +1,89 @@
+/** @file GlobalUniformBlock.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _GLOBALUNIFORMBLOCK_HPP_
+#define _GLOBALUNIFORMBLOCK_HPP_
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * CPU-side staging area for the std140 uniform block `Globals` declared in
+ * globals.glsl.
+ *
+ * UniformSet routes all values named "globals.*" into this block instead of
+ * uploading them into every program on every apply. The block is copied into
+ * a uniform buffer object only if its contents changed and is bound to
+ * BINDING_POINT, which is shared by all programs.
+ *
+ * Members which are not set in a block are taken from the block of the next
+ * UniformSet up in the hierarchy (the base block).
+ */
+class GlobalUniformBlock
+{
+public:
+    /// uniform buffer binding point of the `Globals` block in all programs
+    static const GLuint BINDING_POINT = 0u;
+
+    GlobalUniformBlock();
+    GlobalUniformBlock(const GlobalUniformBlock& other);
+    ~GlobalUniformBlock();
+
+    GlobalUniformBlock& operator=(const GlobalUniformBlock& other);
+
+    static GLint findMember(const std::string& name);
+
+    void set(GLint member, GLenum type, GLsizei size, const GLvoid* data);
+    void clear(GLint member);
+    void clear();
+    bool isEmpty() const;
+
+    void update(const GlobalUniformBlock* base) const;
+    void bind() const;
+
+    static void bindProgram(GLuint program);
+
+private:
+    std::vector<GLubyte>    m_values;
+    GLuint                  m_mask;
+
+    mutable bool                     m_dirty;
+    mutable std::vector<GLubyte>     m_composed;
+    mutable unsigned long            m_composedGeneration;
+    mutable const GlobalUniformBlock* m_composedBase;
+    mutable unsigned long            m_composedBaseGeneration;
+    mutable GLuint                   m_buffer;
+};
+
+// -------------------------------------------------------------------------
+
+inline bool GlobalUniformBlock::isEmpty() const
+{
+    return m_mask == 0u;
+}
+
+} // namespace ugl
+#endif // _GLOBALUNIFORMBLOCK_HPP_
@@ -0,0 +1,126 @@
+/** @file InstancedMeshDrawable.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _INSTANCEDMESHDRAWABLE_HPP_
+#define _INSTANCEDMESHDRAWABLE_HPP_
+
+#include <GL/glew.h>
+
+#include "BoundingBox.hpp"
+#include "MeshData.hpp"
+#include "MeshDrawable.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Per-instance attributes of an InstancedMeshDrawable, see instance.vert.
+ */
+struct MeshInstance
+{
+    glm::mat4 transform;
+    glm::vec4 color;
+    float     scalar;   ///< mapped to a color with setColorByScalar()
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * Renders many copies of one mesh with a single glDrawElementsInstanced call
+ * per variant (surface and edges).
+ *
+ * The instances live in a client-side array which is mirrored into an
+ * instance buffer. Changes made through setInstance() or setInstances() are
+ * collected into one dirty range and uploaded with a single glBufferSubData
+ * on the next draw; the buffer is only reallocated when it has to grow.
+ *
+ * Normals are transformed by the upper 3x3 of the instance transform, which
+ * is exact for rotations and uniform scaling.
+ */
+class InstancedMeshDrawable : public MeshDrawable
+{
+public:
+    explicit InstancedMeshDrawable( MeshData& data, const MeshVertexFormat& format = MeshVertexFormat() );
+    virtual ~InstancedMeshDrawable();
+
+    virtual void draw( const StateSet& state );
+    virtual bool record( const StateSet& state, RenderQueue& queue );
+    virtual BoundingBox getBoundingBox() const;
+    virtual void update( MeshData& data );
+
+    GLsizei getInstanceCount() const;
+    const MeshInstance& getInstance( GLsizei index ) const;
+
+    GLsizei addInstance( const MeshInstance& instance );
+    void setInstance( GLsizei index, const MeshInstance& instance );
+    void setInstances( GLsizei first, GLsizei count, const MeshInstance* instances );
+    void setInstances( const std::vector<MeshInstance>& instances );
+    void clearInstances();
+
+    void setColorByScalar( bool enabled, float scalarsMin = 0.0f, float scalarsMax = 1.0f,
+                           const glm::vec3& minColor = glm::vec3(0.0f, 0.0f, 1.0f),
+                           const glm::vec3& maxColor = glm::vec3(1.0f, 0.0f, 0.0f) );
+
+protected:
+    void prepareInstanceAttributes();
+    void markDirty( GLsizei first, GLsizei count );
+    void uploadInstances();
+
+    std::vector<MeshInstance> m_instances;
+
+    GLuint         m_instanceBuffer;
+    GLsizei        m_instanceCapacity;  ///< instances the buffer can hold
+
+    /// range of instances not yet uploaded, empty if m_dirtyFirst >= m_dirtyLast
+    GLsizei        m_dirtyFirst;
+    GLsizei        m_dirtyLast;
+
+    mutable bool        m_instanceBoundsValid;
+    mutable BoundingBox m_instanceBounds;
+};
+
+// -------------------------------------------------------------------------
+
+inline GLsizei InstancedMeshDrawable::getInstanceCount() const
+{
+    return m_instances.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline const MeshInstance& InstancedMeshDrawable::getInstance( GLsizei index ) const
+{
+    return m_instances[index];
+}
+
+// -------------------------------------------------------------------------
+
+inline void InstancedMeshDrawable::setInstance( GLsizei index, const MeshInstance& instance )
+{
+    setInstances( index, 1, &instance );
+}
+
+} // namespace ugl
+#endif // _INSTANCEDMESHDRAWABLE_HPP_
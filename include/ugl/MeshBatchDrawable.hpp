@@ -0,0 +1,183 @@
+/** @file MeshBatchDrawable.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _MESHBATCHDRAWABLE_HPP_
+#define _MESHBATCHDRAWABLE_HPP_
+
+#include <GL/glew.h>
+
+#include "BoundingBox.hpp"
+#include "Drawable.hpp"
+#include "MeshData.hpp"
+#include "StateSet.hpp"
+#include "VariantProgram.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Per-draw parameters of a MeshBatchDrawable in std430 layout, see the
+ * `Batch` buffer in mesh_batch.glsl.
+ */
+struct MeshBatchParameters
+{
+    glm::mat4 modelMatrix;
+    glm::vec4 color;
+    float     alpha;
+    float     padding[3];
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * Renders many meshes with one glMultiDrawElementsIndirect call per variant
+ * (surface and edges).
+ *
+ * The vertices and indices of all added meshes are merged into shared
+ * buffers; each mesh becomes one indirect draw command addressing its range
+ * through firstIndex and baseVertex. Model matrix, color and alpha of each
+ * mesh are stored in a shader storage buffer indexed by gl_DrawID (or by an
+ * instanced attribute if ARB_shader_draw_parameters is missing).
+ *
+ * Hiding a mesh only rewrites the instance count of its draw commands.
+ * Adding meshes rebuilds the shared buffers on the next draw, so meshes
+ * should be added up front. Requires OpenGL 4.3.
+ */
+class MeshBatchDrawable : public Drawable
+{
+public:
+    /// binding point of the parameter buffer (0 is used by the dynamic fragment buffer)
+    static const GLuint PARAMETER_BINDING = 1u;
+
+    MeshBatchDrawable();
+    virtual ~MeshBatchDrawable();
+
+    virtual void draw( const StateSet& state );
+    virtual BoundingBox getBoundingBox() const;
+
+    GLsizei addMesh( MeshData& data, const glm::mat4& modelMatrix = glm::mat4(1.0f) );
+    GLsizei getMeshCount() const;
+
+    void setModelMatrix( GLsizei mesh, const glm::mat4& modelMatrix );
+    void setColor( GLsizei mesh, const glm::vec3& color );
+    void setAlpha( GLsizei mesh, float alpha );
+
+    void setMeshVisible( GLsizei mesh, bool visible );
+    bool isMeshVisible( GLsizei mesh ) const;
+
+    void setDrawSurface( bool drawSurface );
+    void setDrawEdges( bool drawEdges );
+
+protected:
+    /// layout of GL_DRAW_INDIRECT_BUFFER entries for glMultiDrawElementsIndirect
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    /// where a mesh lives in the shared buffers
+    struct MeshRange
+    {
+        GLuint      firstVertex;
+        GLuint      firstTriangleIndex;
+        GLuint      triangleIndexCount;
+        GLuint      firstEdgeIndex;    ///< relative to the edge indices
+        GLuint      edgeIndexCount;
+        BoundingBox boundingBox;
+        bool        visible;
+    };
+
+    void prepareShaderProgram();
+    void uploadGeometry();
+    void uploadParameters();
+    void uploadCommands();
+    void markParameters( GLsizei mesh );
+    void markCommands( GLsizei mesh );
+
+    VariantProgram m_program;
+    StateSet       m_stateSet;
+
+    std::vector<glm::vec3>           m_points;
+    std::vector<glm::vec3>           m_normals;
+    std::vector<GLuint>              m_triangleIndices;
+    std::vector<GLuint>              m_edgeIndices;
+    std::vector<MeshRange>           m_meshes;
+    std::vector<MeshBatchParameters> m_parameters;
+
+    GLuint         m_vertexArray;
+    GLuint         m_vertexPositionBuffer;
+    GLuint         m_vertexNormalBuffer;
+    GLuint         m_drawIdBuffer;
+    GLuint         m_indexBuffer;
+    GLuint         m_parameterBuffer;
+    GLuint         m_commandBuffer;     ///< surface commands, then edge commands
+
+    bool           m_geometryDirty;
+    GLsizei        m_parametersFirst;   ///< dirty range, empty if first >= last
+    GLsizei        m_parametersLast;
+    GLsizei        m_commandsFirst;
+    GLsizei        m_commandsLast;
+
+    mutable bool        m_boundingBoxValid;
+    mutable BoundingBox m_boundingBox;
+
+    bool           m_drawSurface;
+    bool           m_drawEdges;
+};
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshBatchDrawable::getMeshCount() const
+{
+    return m_meshes.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline bool MeshBatchDrawable::isMeshVisible( GLsizei mesh ) const
+{
+    return m_meshes[mesh].visible;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshBatchDrawable::setDrawSurface( bool drawSurface )
+{
+    m_drawSurface = drawSurface;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshBatchDrawable::setDrawEdges( bool drawEdges )
+{
+    m_drawEdges = drawEdges;
+}
+
+} // namespace ugl
+#endif // _MESHBATCHDRAWABLE_HPP_
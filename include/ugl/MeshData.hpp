@@ -28,6 +28,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <vector>
 
 namespace ugl
@@ -36,7 +37,18 @@ namespace ugl
 /**
  * Data class for a mesh made up of triangles using indices to a list of points.
  *
- * Vertex normals and edges can be computed.
+ * Vertex normals and edges can be computed. Vertex normals are gathered per
+ * point from a point to triangle adjacency, in parallel. Edges are extracted
+ * lazily by a parallel sort and keep their adjacent triangles.
+ *
+ * The topology (triangles around points, triangles at edges, boundary loops)
+ * is built lazily in parallel and cached until the triangles change.
+ *
+ * Changes are tracked for incremental GPU updates (see MeshDrawable::update()):
+ * moving points extends a dirty range of points, and the vertex normals are
+ * then only recomputed around the moved points. Adding points or changing the
+ * triangles marks the topology dirty instead. The dirty state is meant for a
+ * single consumer which calls clearDirty().
  */
 class MeshData
 {
@@ -56,6 +68,9 @@ public:
 
     void setPoints(const std::vector<glm::vec3>& points);
 
+    void setPoint(GLint pointId, const glm::vec3& point);
+    void setPoints(GLint first, GLsizei count, const glm::vec3* points);
+
     /// query the number of triangles defining the mesh
     GLsizei getTriangleCount() const;
 
@@ -73,6 +88,10 @@ public:
     const std::vector<glm::vec3>& getVertexNormals();
     void recomputeVertexNormals();
 
+    /// accumulate vertex normals in double precision (for large, finely tessellated meshes)
+    void setDoublePrecisionNormals(bool enabled);
+    bool isDoublePrecisionNormals() const;
+
     const BoundingBox& getBoundingBox();
     void recomputeBoundingBox();
 
@@ -81,11 +100,45 @@ public:
     const std::vector<glm::uvec2>& getEdges();
     void recomputeEdges();
 
+    /// number of triangles at the i-th edge (1 on a boundary, 2 inside a manifold)
+    GLsizei getEdgeTriangleCount(GLint edgeId);
+
+    /// the triangles at the i-th edge, see getEdgeTriangleCount()
+    const GLuint* getEdgeTriangles(GLint edgeId);
+
+    /// number of triangles at the i-th point
+    GLsizei getPointTriangleCount(GLint pointId);
+
+    /// the triangles at the i-th point, see getPointTriangleCount()
+    const GLuint* getPointTriangles(GLint pointId);
+    void recomputePointTriangles();
+
+    /// point loops along the boundary edges, oriented like their triangles
+    const std::vector< std::vector<GLuint> >& getBoundaryLoops();
+    void recomputeBoundaryLoops();
+
+    static void extractEdges(const std::vector<glm::uvec3>& triangles,
+                             std::vector<glm::uvec2>& edges,
+                             std::vector<GLuint>* edgeTriangleOffsets = nullptr,
+                             std::vector<GLuint>* edgeTriangles = nullptr);
+
+    /// range [first, last) of points whose position or normal changed, empty if first >= last
+    GLint getDirtyPointsFirst();
+    GLint getDirtyPointsLast();
+    bool  isTopologyDirty() const;
+    void  clearDirty();
+
 private:
+    void updateVertexNormals();
+    glm::vec3 gatherVertexNormal(GLuint pointId) const;
+    void markPointsDirty(GLint first, GLint last);
+    void markTopologyDirty();
+
     std::vector<glm::vec3>  m_points;
     std::vector<glm::uvec3> m_triangles;
 
     bool                    m_vertexNormalsValid;
+    bool                    m_doublePrecisionNormals;
     std::vector<glm::vec3>  m_vertexNormals;
 
     bool                    m_boundingBoxValid;
@@ -93,14 +146,37 @@ private:
 
     bool                    m_edgesValid;
     std::vector<glm::uvec2> m_edges;
+    std::vector<GLuint>     m_edgeTriangleOffsets;
+    std::vector<GLuint>     m_edgeTriangles;
+
+    /// points moved since the vertex normals were computed
+    std::vector<GLuint>     m_movedPoints;
+
+    /// triangles adjacent to each point (CSR)
+    bool                    m_pointTrianglesValid;
+    std::vector<GLuint>     m_pointTriangleOffsets;
+    std::vector<GLuint>     m_pointTriangles;
+
+    bool                    m_boundaryLoopsValid;
+    std::vector< std::vector<GLuint> > m_boundaryLoops;
+
+    GLint                   m_dirtyFirst;
+    GLint                   m_dirtyLast;
+    bool                    m_topologyDirty;
 };
 
 // -------------------------------------------------------------------------
 
 inline MeshData::MeshData() :
     m_vertexNormalsValid(false),
+    m_doublePrecisionNormals(false),
     m_boundingBoxValid(false),
-    m_edgesValid(false)
+    m_edgesValid(false),
+    m_pointTrianglesValid(false),
+    m_boundaryLoopsValid(false),
+    m_dirtyFirst(0),
+    m_dirtyLast(0),
+    m_topologyDirty(false)
 {
 }
 
@@ -130,6 +206,11 @@ inline const std::vector<glm::vec3>& MeshData::getPoints() const
 inline size_t MeshData::addPoint(const glm::vec3& point)
 {
     m_points.push_back(point);
+
+    m_vertexNormalsValid = false;
+    m_boundingBoxValid   = false;
+    markTopologyDirty();
+
     return m_points.size() - 1;
 }
 
@@ -137,7 +218,22 @@ inline size_t MeshData::addPoint(const glm::vec3& point)
 
 inline void MeshData::setPoints(const std::vector<glm::vec3>& points)
 {
+    if (points.size() != m_points.size())
+        markTopologyDirty();
+    else
+        markPointsDirty(0, points.size());
+
     m_points = points;
+
+    m_vertexNormalsValid = false;
+    m_boundingBoxValid   = false;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshData::setPoint(GLint pointId, const glm::vec3& point)
+{
+    setPoints(pointId, 1, &point);
 }
 
 // -------------------------------------------------------------------------
@@ -166,6 +262,10 @@ inline const std::vector<glm::uvec3>& MeshData::getTriangles() const
 inline void MeshData::addTriangle(const glm::uvec3& triangle)
 {
     m_triangles.push_back(triangle);
+
+    m_vertexNormalsValid = false;
+    m_edgesValid         = false;
+    markTopologyDirty();
 }
 
 // -------------------------------------------------------------------------
@@ -173,6 +273,10 @@ inline void MeshData::addTriangle(const glm::uvec3& triangle)
 inline void MeshData::setTriangles(const std::vector<glm::uvec3>& triangles)
 {
     m_triangles = triangles;
+
+    m_vertexNormalsValid = false;
+    m_edgesValid         = false;
+    markTopologyDirty();
 }
 
 // -------------------------------------------------------------------------
@@ -181,6 +285,8 @@ inline const glm::vec3& MeshData::getVertexNormal(GLint pointId)
 {
     if (!m_vertexNormalsValid)
         recomputeVertexNormals();
+    else if (!m_movedPoints.empty())
+        updateVertexNormals();
 
     return m_vertexNormals[pointId];
 }
@@ -191,12 +297,38 @@ inline const std::vector<glm::vec3>& MeshData::getVertexNormals()
 {
     if (!m_vertexNormalsValid)
         recomputeVertexNormals();
+    else if (!m_movedPoints.empty())
+        updateVertexNormals();
 
     return m_vertexNormals;
 }
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Switches the accumulation precision; all normals are recomputed and
+ * all points marked dirty, so that MeshDrawable::update() uploads them.
+ */
+inline void MeshData::setDoublePrecisionNormals(bool enabled)
+{
+    if (enabled == m_doublePrecisionNormals)
+        return;
+
+    m_doublePrecisionNormals = enabled;
+    m_vertexNormalsValid     = false;
+
+    markPointsDirty(0, getPointCount());
+}
+
+// -------------------------------------------------------------------------
+
+inline bool MeshData::isDoublePrecisionNormals() const
+{
+    return m_doublePrecisionNormals;
+}
+
+// -------------------------------------------------------------------------
+
 inline const BoundingBox& MeshData::getBoundingBox()
 {
     if (!m_boundingBoxValid)
@@ -243,5 +375,119 @@ inline const std::vector<glm::uvec2>& MeshData::getEdges()
     return m_edges;
 }
 
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshData::getEdgeTriangleCount(GLint edgeId)
+{
+    if (!m_edgesValid)
+        recomputeEdges();
+
+    return m_edgeTriangleOffsets[edgeId + 1] - m_edgeTriangleOffsets[edgeId];
+}
+
+// -------------------------------------------------------------------------
+
+inline const GLuint* MeshData::getEdgeTriangles(GLint edgeId)
+{
+    if (!m_edgesValid)
+        recomputeEdges();
+
+    return m_edgeTriangles.data() + m_edgeTriangleOffsets[edgeId];
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshData::getPointTriangleCount(GLint pointId)
+{
+    if (!m_pointTrianglesValid)
+        recomputePointTriangles();
+
+    return m_pointTriangleOffsets[pointId + 1] - m_pointTriangleOffsets[pointId];
+}
+
+// -------------------------------------------------------------------------
+
+inline const GLuint* MeshData::getPointTriangles(GLint pointId)
+{
+    if (!m_pointTrianglesValid)
+        recomputePointTriangles();
+
+    return m_pointTriangles.data() + m_pointTriangleOffsets[pointId];
+}
+
+// -------------------------------------------------------------------------
+
+inline const std::vector< std::vector<GLuint> >& MeshData::getBoundaryLoops()
+{
+    if (!m_boundaryLoopsValid)
+        recomputeBoundaryLoops();
+
+    return m_boundaryLoops;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the first dirty point; pending normal updates are done
+ * first since they may extend the range.
+ */
+inline GLint MeshData::getDirtyPointsFirst()
+{
+    if (m_vertexNormalsValid && !m_movedPoints.empty())
+        updateVertexNormals();
+
+    return m_dirtyFirst;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLint MeshData::getDirtyPointsLast()
+{
+    if (m_vertexNormalsValid && !m_movedPoints.empty())
+        updateVertexNormals();
+
+    return m_dirtyLast;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool MeshData::isTopologyDirty() const
+{
+    return m_topologyDirty;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshData::clearDirty()
+{
+    m_dirtyFirst    = m_dirtyLast = 0;
+    m_topologyDirty = false;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshData::markPointsDirty(GLint first, GLint last)
+{
+    if (m_dirtyFirst >= m_dirtyLast)
+    {
+        m_dirtyFirst = first;
+        m_dirtyLast  = last;
+    }
+    else
+    {
+        m_dirtyFirst = std::min(m_dirtyFirst, first);
+        m_dirtyLast  = std::max(m_dirtyLast, last);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshData::markTopologyDirty()
+{
+    m_topologyDirty       = true;
+    m_pointTrianglesValid = false;
+    m_boundaryLoopsValid  = false;
+}
+
 } // namespace ugl
 #endif // _MESHDATA_HPP_
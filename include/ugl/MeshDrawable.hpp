@@ -25,47 +25,187 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #include <GL/glew.h>
 
 #include "BoundingBox.hpp"
+#include "BufferPool.hpp"
 #include "Drawable.hpp"
 #include "MeshData.hpp"
 #include "StateSet.hpp"
 #include "VariantProgram.hpp"
 
+#include <vector>
+
 namespace ugl
 {
 
+/**
+ * Vertex layout used by a MeshDrawable. The default is the plain layout of
+ * separate float buffers; compact() halves the size of a vertex.
+ */
+struct MeshVertexFormat
+{
+    enum NormalFormat
+    {
+        FLOAT_NORMALS,          ///< 3 floats, 12 bytes
+        PACKED_NORMALS,         ///< GL_INT_2_10_10_10_REV, 4 bytes
+        OCTAHEDRAL_NORMALS      ///< 2 normalized shorts, 4 bytes
+    };
+
+    MeshVertexFormat();
+
+    static MeshVertexFormat compact();
+
+    /// positions and normals in one buffer
+    bool         interleaved;
+
+    /// positions as 16-bit fixed point relative to the bounding box (8 bytes)
+    bool         quantizePositions;
+
+    NormalFormat normals;
+
+    /// use 16-bit indices if the point count allows
+    bool         shortIndices;
+
+    /// triangles per culling cluster (about 128 to 256), 0 for none; the
+    /// clusters follow a Morton curve of the triangle centroids, within a
+    /// cluster the triangles keep their order in the MeshData (e.g. the
+    /// vertex cache order of MeshOptimizer)
+    GLsizei      clusterSize;
+};
+
+// -------------------------------------------------------------------------
+
 /**
  * Basic Drawable which renders meshes provided by MeshData.
+ *
+ * Vertex and index data are suballocated from the shared BufferPool in the
+ * layout given by a MeshVertexFormat; the shader decodes them so that
+ * vertexPosition and vertexNormal keep their meaning.
+ *
+ * Changes to the MeshData are applied with update(), which uploads only the
+ * dirty range of vertices.
+ *
+ * Edges are taken from MeshData::getEdges() when they are turned on with
+ * setDrawEdges(). If they are turned on through getTweakableParameters()
+ * instead, they appear after the next update().
+ *
+ * If the format has a cluster size, the triangles are sorted along a Morton
+ * curve and split into clusters with a bounding box and a cone of normals.
+ * With setClusterCulling(), clusters outside the view frustum or facing away
+ * from the camera are skipped and the remaining ranges are drawn with
+ * glMultiDrawElements. Edges and instanced draws are not culled.
  */
 class MeshDrawable : public Drawable
 {
 public:
-    explicit MeshDrawable( MeshData& data );
+    explicit MeshDrawable( MeshData& data, const MeshVertexFormat& format = MeshVertexFormat() );
     virtual ~MeshDrawable();
     virtual void draw( const StateSet& state );
+    virtual bool record( const StateSet& state, RenderQueue& queue );
     virtual BoundingBox getBoundingBox() const;
 
+    virtual void update( MeshData& data );
+
+    void setDrawEdges( bool drawEdges, MeshData& data );
+
     void getTweakableParameters(bool** drawSurface, bool** drawEdges, float** alpha);
 
+    const MeshVertexFormat& getVertexFormat() const;
+    GLenum getIndexType() const;
+
+    struct ClusterStatistics
+    {
+        GLsizei clusters;
+        GLsizei frustumCulled;
+        GLsizei backfaceCulled;
+        GLsizei ranges;          ///< draws after merging adjacent clusters
+    };
+
+    void setClusterCulling( bool frustum, bool backfaces );
+    bool isClusterCulling() const;
+
+    /// statistics of the last draw or record
+    const ClusterStatistics& getClusterStatistics() const;
+
 protected:
+    struct Cluster
+    {
+        BoundingBox box;
+        glm::vec3   coneAxis;
+        float       coneCutoff;  ///< sine of the cone angle, > 1 if it cannot be culled
+        GLuint      firstIndex;
+        GLsizei     indexCount;
+    };
+
     /**
      * Set up shader program.
      */
     void prepareShaderProgram();
 
+    void prepareVertexFormat( MeshData& data );
     void prepareVertexArrays( MeshData& data );
+    void uploadVertexData( MeshData& data );
+    void uploadEdges( const std::vector<glm::uvec2>& edges );
+    void bindVertexBuffers();
+
+    void buildClusters( MeshData& data, std::vector<glm::uvec3>& triangles );
+    void computeClusterBounds( MeshData& data );
+    void computeClusterBounds( MeshData& data, GLint first, GLint last );
+    void computeClusterBounds( MeshData& data, const std::vector<GLuint>& clusterIds );
+    bool cullClusters( const StateSet& state );
+
+    void encodeVertices( MeshData& data, GLint first, GLint last,
+                         std::vector<unsigned char>& positions,
+                         std::vector<unsigned char>& normals ) const;
+
+    void encodePosition( const glm::vec3& position, unsigned char* out ) const;
+    void encodeNormal( const glm::vec3& normal, unsigned char* out ) const;
+
+    GLsizei getPositionSize() const;
+    GLsizei getNormalSize() const;
+
+    void drawElements( GLenum mode, GLsizei count, BufferPool::Handle indices );
 
     VariantProgram m_program;
     StateSet       m_stateSet;
 
-    GLuint         m_vertexArray;
-    GLuint         m_vertexPositionBuffer;
-    GLuint         m_vertexNormalBuffer;
-    GLuint         m_triangleBuffer;
-    GLsizei        m_triangleCount;
-    GLuint         m_edgeBuffer;
-    GLsizei        m_edgeCount;
+    GLuint             m_vertexArray;
+    BufferPool::Handle m_vertexPositionBuffer;
+    BufferPool::Handle m_vertexNormalBuffer;
+    BufferPool::Handle m_triangleBuffer;
+    GLsizei            m_triangleCount;
+    BufferPool::Handle m_edgeBuffer;        ///< invalid until edges are turned on
+    GLsizei            m_edgeCount;
+
+    GLsizei            m_vertexCount;
+
+    MeshVertexFormat   m_format;
+    GLenum             m_indexType;
+    GLsizei            m_vertexStride;      ///< 0 if not interleaved
+    GLsizei            m_normalOffset;      ///< offset of the normal in an interleaved vertex
+
+    /// pool generation the attribute pointers were specified for
+    unsigned long      m_bufferGeneration;
+
+    /// number of instances drawn with glDrawElementsInstanced or 0
+    GLsizei        m_instanceCount;
+
+    BoundingBox    m_boundingBox;
 
-    const BoundingBox m_boundingBox;
+    /// range of quantized positions, see MeshVertexFormat
+    BoundingBox    m_positionRange;
+
+    /// clusters, the original ids of their triangles and the inverse mapping
+    /// from original triangle ids to clusters
+    std::vector<Cluster>       m_clusters;
+    std::vector<GLuint>        m_clusterTriangles;
+    std::vector<GLuint>        m_triangleClusters;
+
+    bool                       m_cullFrustum;
+    bool                       m_cullBackfaces;
+    ClusterStatistics          m_clusterStatistics;
+
+    /// visible triangle ranges of the last cullClusters()
+    std::vector<GLsizei>       m_rangeCounts;
+    std::vector<const GLvoid*> m_rangeOffsets;
 
     bool           m_drawSurface;
     bool           m_drawEdges;
@@ -75,9 +215,60 @@ protected:
 
 // -------------------------------------------------------------------------
 
-inline MeshDrawable::~MeshDrawable()
+inline MeshVertexFormat::MeshVertexFormat() :
+    interleaved( false ),
+    quantizePositions( false ),
+    normals( FLOAT_NORMALS ),
+    shortIndices( true ),
+    clusterSize( 0 )
+{
+}
+
+// -------------------------------------------------------------------------
+
+inline MeshVertexFormat MeshVertexFormat::compact()
+{
+    MeshVertexFormat format;
+    format.interleaved       = true;
+    format.quantizePositions = true;
+    format.normals           = OCTAHEDRAL_NORMALS;
+    return format;
+}
+
+// -------------------------------------------------------------------------
+
+inline const MeshVertexFormat& MeshDrawable::getVertexFormat() const
+{
+    return m_format;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLenum MeshDrawable::getIndexType() const
+{
+    return m_indexType;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshDrawable::setClusterCulling( bool frustum, bool backfaces )
+{
+    m_cullFrustum   = frustum;
+    m_cullBackfaces = backfaces;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool MeshDrawable::isClusterCulling() const
 {
+    return !m_clusters.empty() && (m_cullFrustum || m_cullBackfaces);
+}
+
+// -------------------------------------------------------------------------
 
+inline const MeshDrawable::ClusterStatistics& MeshDrawable::getClusterStatistics() const
+{
+    return m_clusterStatistics;
 }
 
 // -------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+/** @file MeshLODDrawable.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _MESHLODDRAWABLE_HPP_
+#define _MESHLODDRAWABLE_HPP_
+
+#include <GL/glew.h>
+
+#include "BoundingBox.hpp"
+#include "Drawable.hpp"
+#include "MeshData.hpp"
+#include "MeshDrawable.hpp"
+#include "StateSet.hpp"
+
+#include <vector>
+
+namespace ugl
+{
+
+class ViewController;
+
+/**
+ * Renders one of several levels of detail of a mesh, e.g. built with
+ * MeshSimplifier::buildChain().
+ *
+ * The level is chosen per draw from the projected size of the bounding box
+ * relative to the viewport height (taken from the globals.projectionMatrix
+ * and globals.modelviewMatrix uniforms): level 0 is drawn down to
+ * getDetailSize(), every following level covers half the size of the
+ * previous one. While the attached ViewController is interacting, the
+ * selection is shifted by getInteractionBias() coarser levels.
+ *
+ * Surface, edge and alpha parameters apply to all levels. Since the levels
+ * do not keep their MeshData, edges of a level are only drawn once they were
+ * built with getLevel( level )->setDrawEdges() or MeshDrawable::update().
+ */
+class MeshLODDrawable : public Drawable
+{
+public:
+    explicit MeshLODDrawable( MeshData& data, const MeshVertexFormat& format = MeshVertexFormat() );
+    virtual ~MeshLODDrawable();
+
+    virtual void draw( const StateSet& state );
+    virtual bool record( const StateSet& state, RenderQueue& queue );
+    virtual BoundingBox getBoundingBox() const;
+
+    /// appends a coarser level
+    void addLevel( MeshData& data );
+
+    GLsizei getLevelCount() const;
+    MeshDrawable* getLevel( GLsizei level );
+
+    /// level drawn last
+    GLsizei getCurrentLevel() const;
+
+    /// -1 selects by size, otherwise the level to draw
+    void setForcedLevel( GLint level );
+
+    void setDetailSize( float detailSize );
+    float getDetailSize() const;
+
+    void setInteraction( const ViewController* viewController, GLsizei bias = 1 );
+    GLsizei getInteractionBias() const;
+
+    void getTweakableParameters(bool** drawSurface, bool** drawEdges, float** alpha);
+
+protected:
+    float computeProjectedSize( const StateSet& state ) const;
+    MeshDrawable* selectLevel( const StateSet& state );
+
+    std::vector<MeshDrawable*> m_levels;
+    MeshVertexFormat           m_format;
+    BoundingBox                m_boundingBox;
+
+    GLsizei                    m_currentLevel;
+    GLint                      m_forcedLevel;
+    float                      m_detailSize;
+
+    const ViewController*      m_viewController;
+    GLsizei                    m_interactionBias;
+
+    bool                       m_drawSurface;
+    bool                       m_drawEdges;
+    float                      m_alpha;
+};
+
+// -------------------------------------------------------------------------
+
+inline BoundingBox MeshLODDrawable::getBoundingBox() const
+{
+    return m_boundingBox;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshLODDrawable::getLevelCount() const
+{
+    return m_levels.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline MeshDrawable* MeshLODDrawable::getLevel( GLsizei level )
+{
+    return m_levels[level];
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshLODDrawable::getCurrentLevel() const
+{
+    return m_currentLevel;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshLODDrawable::setForcedLevel( GLint level )
+{
+    m_forcedLevel = level;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @param detailSize Projected bounding box size (fraction of the viewport
+ * height) below which the first coarser level is used.
+ */
+inline void MeshLODDrawable::setDetailSize( float detailSize )
+{
+    m_detailSize = detailSize;
+}
+
+// -------------------------------------------------------------------------
+
+inline float MeshLODDrawable::getDetailSize() const
+{
+    return m_detailSize;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshLODDrawable::setInteraction( const ViewController* viewController, GLsizei bias )
+{
+    m_viewController  = viewController;
+    m_interactionBias = bias;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshLODDrawable::getInteractionBias() const
+{
+    return m_interactionBias;
+}
+
+} // namespace ugl
+#endif // _MESHLODDRAWABLE_HPP_
@@ -0,0 +1,145 @@
+/** @file MeshOptimizer.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _MESHOPTIMIZER_HPP_
+#define _MESHOPTIMIZER_HPP_
+
+#include "MeshData.hpp"
+#include "ScalarData.hpp"
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Reorders the triangles and points of a MeshData for rendering.
+ *
+ * optimize() runs three steps:
+ *
+ *   * Triangles are reordered for post-transform vertex cache locality using
+ *     Forsyth's "Linear-Speed Vertex Cache Optimisation".
+ *   * Optionally, the cache-optimized sequence is split into clusters at
+ *     cache flushes which are sorted front-to-back with respect to the mesh
+ *     centroid to reduce overdraw (after Sander et al., "Fast Triangle
+ *     Reordering for Vertex Locality and Reduced Overdraw"). The result is
+ *     dropped if the ACMR grows by more than the given threshold.
+ *   * Points are reordered by first use to improve vertex fetch locality;
+ *     scalars given along are remapped in the same way.
+ *
+ * The quality is measured as ACMR (average cache miss ratio, transformed
+ * vertices per triangle) of a FIFO cache of getCacheSize() entries.
+ */
+class MeshOptimizer
+{
+public:
+    struct Statistics
+    {
+        float acmrBefore;
+        float acmrAfter;
+    };
+
+    MeshOptimizer();
+
+    Statistics optimize(MeshData& data,
+                        const std::vector<ScalarData*>& scalars = std::vector<ScalarData*>());
+
+    /// old point index -> new point index of the last optimize()
+    const std::vector<GLuint>& getVertexRemap() const;
+
+    void setCacheSize(GLsizei cacheSize);
+    GLsizei getCacheSize() const;
+
+    void setOptimizeOverdraw(bool enabled, float threshold = 1.05f);
+    bool isOptimizeOverdraw() const;
+
+    static float computeACMR(const std::vector<glm::uvec3>& triangles,
+                             GLsizei pointCount, GLsizei cacheSize);
+
+private:
+    std::vector<glm::uvec3> optimizeVertexCache(const std::vector<glm::uvec3>& triangles,
+                                                GLsizei pointCount) const;
+    std::vector<glm::uvec3> optimizeOverdraw(const std::vector<glm::uvec3>& triangles,
+                                             const std::vector<glm::vec3>& points) const;
+    void optimizeVertexFetch(MeshData& data, const std::vector<ScalarData*>& scalars);
+
+    GLsizei             m_cacheSize;
+    bool                m_optimizeOverdraw;
+    float               m_overdrawThreshold;
+    std::vector<GLuint> m_vertexRemap;
+};
+
+// -------------------------------------------------------------------------
+
+inline MeshOptimizer::MeshOptimizer() :
+    m_cacheSize(32),
+    m_optimizeOverdraw(false),
+    m_overdrawThreshold(1.05f)
+{
+}
+
+// -------------------------------------------------------------------------
+
+inline const std::vector<GLuint>& MeshOptimizer::getVertexRemap() const
+{
+    return m_vertexRemap;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshOptimizer::setCacheSize(GLsizei cacheSize)
+{
+    // the scoring needs more than the three entries of the last triangle
+    m_cacheSize = cacheSize > 4 ? cacheSize : 4;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLsizei MeshOptimizer::getCacheSize() const
+{
+    return m_cacheSize;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @param threshold Maximum accepted ratio of the ACMR after and before the
+ * overdraw optimization.
+ */
+inline void MeshOptimizer::setOptimizeOverdraw(bool enabled, float threshold)
+{
+    m_optimizeOverdraw  = enabled;
+    m_overdrawThreshold = threshold;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool MeshOptimizer::isOptimizeOverdraw() const
+{
+    return m_optimizeOverdraw;
+}
+
+} // namespace ugl
+#endif // _MESHOPTIMIZER_HPP_
@@ -0,0 +1,96 @@
+/** @file MeshSimplifier.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _MESHSIMPLIFIER_HPP_
+#define _MESHSIMPLIFIER_HPP_
+
+#include "MeshData.hpp"
+#include "ScalarData.hpp"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Simplifies a MeshData by quadric error edge collapses (Garland and
+ * Heckbert, "Surface Simplification Using Quadric Error Metrics").
+ *
+ * The triangles are partitioned into a grid of cells by their centroid and
+ * the cells are simplified in parallel. Points shared between cells and
+ * points on the mesh boundary are locked, so the cells stay connected and
+ * the boundary is kept. buildChain() shifts the grid by half a cell on every
+ * other level, so the seams locked at one level are simplified at the next.
+ * Each collapse moves the surviving point to the
+ * endpoint or midpoint with the smallest error and rejects collapses which
+ * flip triangles or make the surface non-manifold. Scalars are carried along
+ * with the positions.
+ */
+class MeshSimplifier
+{
+public:
+    struct Level
+    {
+        MeshData                data;
+        std::vector<ScalarData> scalars;
+    };
+
+    MeshSimplifier();
+
+    void simplify(MeshData& data, const std::vector<ScalarData*>& scalars,
+                  float ratio, Level& out, float gridOffset = 0.0f) const;
+
+    std::vector<Level> buildChain(MeshData& data, const std::vector<ScalarData*>& scalars,
+                                  int levelCount, float ratio = 0.25f) const;
+
+    /// cells per axis, 0 to choose from the thread and triangle count
+    void setPartitionCount(int partitionCount);
+    int getPartitionCount() const;
+
+private:
+    int m_partitionCount;
+};
+
+// -------------------------------------------------------------------------
+
+inline MeshSimplifier::MeshSimplifier() :
+    m_partitionCount(0)
+{
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshSimplifier::setPartitionCount(int partitionCount)
+{
+    m_partitionCount = partitionCount;
+}
+
+// -------------------------------------------------------------------------
+
+inline int MeshSimplifier::getPartitionCount() const
+{
+    return m_partitionCount;
+}
+
+} // namespace ugl
+#endif // _MESHSIMPLIFIER_HPP_
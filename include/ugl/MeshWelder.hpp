@@ -0,0 +1,114 @@
+/** @file MeshWelder.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _MESHWELDER_HPP_
+#define _MESHWELDER_HPP_
+
+#include "MeshData.hpp"
+#include "ScalarData.hpp"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Cleans up meshes read from triangle soups.
+ *
+ * weld() runs three steps:
+ *
+ *   * Points closer than getEpsilon() are merged into the one with the lowest
+ *     index. Candidates are found in parallel through a spatial hash of cells
+ *     of size epsilon (sorted with parallelRadixSort()); an epsilon of 0
+ *     merges bitwise equal positions only.
+ *   * Triangles which become degenerate (repeated points or zero area) are
+ *     removed, as are duplicates with the same points and orientation.
+ *   * Unreferenced points are removed, keeping the order of the others.
+ *
+ * Scalars given along are remapped in the same way.
+ */
+class MeshWelder
+{
+public:
+    struct Statistics
+    {
+        GLsizei pointsBefore;
+        GLsizei pointsAfter;
+        GLsizei trianglesBefore;
+        GLsizei trianglesAfter;
+
+        /// host memory of points, triangles and scalars
+        size_t  bytesBefore;
+        size_t  bytesAfter;
+    };
+
+    MeshWelder();
+
+    Statistics weld(MeshData& data,
+                    const std::vector<ScalarData*>& scalars = std::vector<ScalarData*>());
+
+    /// old point index -> new point index of the last weld(), ~0u if removed
+    const std::vector<GLuint>& getVertexRemap() const;
+
+    void setEpsilon(float epsilon);
+    float getEpsilon() const;
+
+private:
+    void findRepresentatives(const std::vector<glm::vec3>& points,
+                             std::vector<GLuint>& representatives) const;
+
+    float               m_epsilon;
+    std::vector<GLuint> m_vertexRemap;
+};
+
+// -------------------------------------------------------------------------
+
+inline MeshWelder::MeshWelder() :
+    m_epsilon(0.0f)
+{
+}
+
+// -------------------------------------------------------------------------
+
+inline const std::vector<GLuint>& MeshWelder::getVertexRemap() const
+{
+    return m_vertexRemap;
+}
+
+// -------------------------------------------------------------------------
+
+inline void MeshWelder::setEpsilon(float epsilon)
+{
+    m_epsilon = epsilon > 0.0f ? epsilon : 0.0f;
+}
+
+// -------------------------------------------------------------------------
+
+inline float MeshWelder::getEpsilon() const
+{
+    return m_epsilon;
+}
+
+} // namespace ugl
+#endif // _MESHWELDER_HPP_
@@ -48,6 +48,7 @@ public:
               const boost::variant<long, std::string>& value );
     void setOrClear( const std::string& name, bool shouldSet );
     ShaderProgram& apply( VariantProgram& program ) const;
+    ShaderProgram& getProgram( VariantProgram& program ) const;
 };
 
 // -------------------------------------------------------------------------
@@ -55,7 +56,7 @@ public:
 inline void ModeSet::set( const std::string& name,
                           const boost::variant<long, std::string>& value )
 {
-    m_values[name] = value;
+    setValue(name, value);
 }
 
 // -------------------------------------------------------------------------
@@ -77,5 +78,15 @@ inline ShaderProgram& ModeSet::apply( VariantProgram& program ) const
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Returns the variant of the program for these modes without binding it.
+ */
+inline ShaderProgram& ModeSet::getProgram( VariantProgram& program ) const
+{
+    return program.getProgram(getMergedMap());
+}
+
+// -------------------------------------------------------------------------
+
 } // namespace ugl
 #endif
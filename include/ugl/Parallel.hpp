@@ -0,0 +1,93 @@
+/** @file Parallel.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _PARALLEL_HPP_
+#define _PARALLEL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * @brief Returns the number of threads used by parallelFor().
+ */
+inline unsigned int getThreadCount()
+{
+    const unsigned int count = std::thread::hardware_concurrency();
+    return count > 0u ? count : 1u;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Calls function(chunkBegin, chunkEnd) for contiguous chunks of
+ * [begin, end) on up to getThreadCount() threads and waits for them.
+ *
+ * Ranges smaller than two grains run on the calling thread. The function must
+ * not touch data written by other chunks.
+ */
+template <typename Function>
+void parallelFor(size_t begin, size_t end, Function function, size_t grain = 16384u)
+{
+    if (end <= begin)
+        return;
+
+    const size_t count  = end - begin;
+    const size_t chunks = std::min<size_t>(getThreadCount(), (count + grain - 1) / grain);
+
+    if (chunks <= 1u)
+    {
+        function(begin, end);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+
+    for (size_t chunk = 1u; chunk < chunks; ++chunk)
+    {
+        const size_t chunkBegin = begin + chunk * chunkSize;
+        const size_t chunkEnd   = std::min(end, chunkBegin + chunkSize);
+
+        if (chunkBegin < chunkEnd)
+            threads.push_back(std::thread(function, chunkBegin, chunkEnd));
+    }
+
+    // the first chunk runs on the calling thread
+    function(begin, std::min(end, begin + chunkSize));
+
+    for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+        thread->join();
+}
+
+// -------------------------------------------------------------------------
+
+void parallelRadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values);
+
+} // namespace ugl
+#endif // _PARALLEL_HPP_
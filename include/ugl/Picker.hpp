@@ -0,0 +1,88 @@
+/** @file Picker.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _PICKER_HPP_
+#define _PICKER_HPP_
+
+#include "Drawable.hpp"
+#include "MeshData.hpp"
+#include "TriangleBVH.hpp"
+#include "ViewController.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Picks triangles of mesh drawables on the CPU by casting rays against a
+ * TriangleBVH per mesh, which avoids reading back GPU buffers.
+ *
+ * The MeshData of a drawable is referenced, not copied, and has to outlive its
+ * registration. After points moved, call refit().
+ */
+class Picker
+{
+public:
+    struct Result
+    {
+        const Drawable* drawable;
+        GLuint          triangle;
+        glm::vec2       barycentrics;   ///< weights of the 2nd and 3rd point
+        float           distance;       ///< from the near plane, in world units
+        glm::vec3       position;
+    };
+
+    void add(const Drawable* drawable, const MeshData& data);
+    void remove(const Drawable* drawable);
+    void refit(const Drawable* drawable);
+    void clear();
+
+    bool pick(const ViewController& view, const glm::vec2& position, Result* result) const;
+    bool pick(const glm::mat4& projection, const glm::mat4& modelview,
+              const glm::vec2& position, Result* result) const;
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, Result* result) const;
+
+    static void computeRay(const glm::mat4& projection, const glm::mat4& modelview,
+                           const glm::vec2& position, glm::vec3* origin, glm::vec3* direction);
+
+private:
+    struct Entry
+    {
+        const Drawable* drawable;
+        const MeshData* data;
+        TriangleBVH     bvh;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+// -------------------------------------------------------------------------
+
+inline void Picker::clear()
+{
+    m_entries.clear();
+}
+
+} // namespace ugl
+#endif // _PICKER_HPP_
@@ -0,0 +1,154 @@
+/** @file RenderQueue.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _RENDERQUEUE_HPP_
+#define _RENDERQUEUE_HPP_
+
+#include <GL/glew.h>
+
+#include "ShaderProgram.hpp"
+#include "StateSet.hpp"
+#include "UniformSet.hpp"
+#include "VariantProgram.hpp"
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * A single recorded draw call: the program variant, the uniforms it is
+ * drawn with, the vertex array and the draw arguments.
+ */
+struct DrawPacket
+{
+    ShaderProgram*    program;
+    const UniformSet* uniforms;     ///< may be null
+    GLuint            vertexArray;
+    GLuint            elementBuffer; ///< 0 for non-indexed draws
+    size_t            textureHash;  ///< see UniformSet::getTextureHash()
+
+    GLenum            mode;
+    GLint             first;        ///< first vertex (non-indexed draws)
+    GLsizei           count;
+    GLenum            indexType;
+    const GLvoid*     indices;      ///< offset into the element buffer
+    GLsizei           instanceCount; ///< 0 for non-instanced draws
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * Collects the draw calls of \ref Drawable "Drawables" (see Drawable::record())
+ * and executes them sorted by program, vertex array and textures, so that
+ * each program and vertex array is bound as few times as possible.
+ *
+ * Uniform values are read when the queue is executed, not when a packet is
+ * recorded. A drawable must therefore not change the uniforms of packets it
+ * has already recorded before the queue is executed.
+ *
+ * The statistics count the program, vertex array and texture changes in
+ * recording order and in the executed order, i.e. the state changes saved by
+ * sorting.
+ */
+class RenderQueue
+{
+public:
+    struct Statistics
+    {
+        unsigned int packets;
+        unsigned int programChanges;
+        unsigned int vertexArrayChanges;
+        unsigned int textureChanges;
+    };
+
+    RenderQueue();
+
+    void drawArrays( const StateSet& state, VariantProgram& program,
+                     GLuint vertexArray, GLenum mode, GLint first, GLsizei count );
+    void drawElements( const StateSet& state, VariantProgram& program,
+                       GLuint vertexArray, GLuint elementBuffer, GLenum mode,
+                       GLsizei count, GLenum type, const GLvoid* indices,
+                       GLsizei instanceCount = 0 );
+    void add( const DrawPacket& packet );
+
+    void execute();
+    void clear();
+
+    bool isEmpty() const;
+
+    void setSortingEnabled( bool enabled );
+    bool isSortingEnabled() const;
+
+    const Statistics& getRecordedStatistics() const;
+    const Statistics& getExecutedStatistics() const;
+
+private:
+    DrawPacket makePacket( const StateSet& state, VariantProgram& program,
+                           GLuint vertexArray ) const;
+
+    static Statistics countChanges( const std::vector<const DrawPacket*>& packets );
+
+    std::vector<DrawPacket>        m_packets;
+    std::vector<const DrawPacket*> m_order;
+
+    bool       m_sorting;
+    Statistics m_recorded;
+    Statistics m_executed;
+};
+
+// -------------------------------------------------------------------------
+
+inline bool RenderQueue::isEmpty() const
+{
+    return m_packets.empty();
+}
+
+// -------------------------------------------------------------------------
+
+inline void RenderQueue::setSortingEnabled( bool enabled )
+{
+    m_sorting = enabled;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool RenderQueue::isSortingEnabled() const
+{
+    return m_sorting;
+}
+
+// -------------------------------------------------------------------------
+
+inline const RenderQueue::Statistics& RenderQueue::getRecordedStatistics() const
+{
+    return m_recorded;
+}
+
+// -------------------------------------------------------------------------
+
+inline const RenderQueue::Statistics& RenderQueue::getExecutedStatistics() const
+{
+    return m_executed;
+}
+
+} // namespace ugl
+#endif // _RENDERQUEUE_HPP_
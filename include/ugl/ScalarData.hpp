@@ -24,6 +24,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include <GL/glew.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace ugl
@@ -46,6 +47,12 @@ public:
 
     void addScalar(GLfloat scalar);
     void setAllScalars(const std::vector<GLfloat>& scalars);
+    void setScalars(GLint first, GLsizei count, const GLfloat* scalars);
+
+    /// range [first, last) of changed scalars, empty if first >= last
+    GLint                       getDirtyFirst() const;
+    GLint                       getDirtyLast() const;
+    void                        clearDirty();
 
     GLfloat                     getMin();
     GLfloat                     getMax();
@@ -57,12 +64,17 @@ private:
     bool                    m_minMaxValid;
     GLfloat                 m_min;
     GLfloat                 m_max;
+
+    GLint                   m_dirtyFirst;
+    GLint                   m_dirtyLast;
 };
 
 // -------------------------------------------------------------------------
 
 inline ScalarData::ScalarData() :
-    m_minMaxValid(false)
+    m_minMaxValid(false),
+    m_dirtyFirst(0),
+    m_dirtyLast(0)
 {
 }
 
@@ -99,6 +111,51 @@ inline void ScalarData::addScalar(GLfloat scalar)
 inline void ScalarData::setAllScalars(const std::vector<GLfloat>& scalars)
 {
     m_scalars = scalars;
+
+    m_minMaxValid = false;
+    m_dirtyFirst  = 0;
+    m_dirtyLast   = m_scalars.size();
+}
+
+// -------------------------------------------------------------------------
+
+inline void ScalarData::setScalars(GLint first, GLsizei count, const GLfloat* scalars)
+{
+    std::copy(scalars, scalars + count, m_scalars.begin() + first);
+
+    m_minMaxValid = false;
+
+    if (m_dirtyFirst >= m_dirtyLast)
+    {
+        m_dirtyFirst = first;
+        m_dirtyLast  = first + count;
+    }
+    else
+    {
+        m_dirtyFirst = std::min(m_dirtyFirst, first);
+        m_dirtyLast  = std::max(m_dirtyLast, first + count);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+inline GLint ScalarData::getDirtyFirst() const
+{
+    return m_dirtyFirst;
+}
+
+// -------------------------------------------------------------------------
+
+inline GLint ScalarData::getDirtyLast() const
+{
+    return m_dirtyLast;
+}
+
+// -------------------------------------------------------------------------
+
+inline void ScalarData::clearDirty()
+{
+    m_dirtyFirst = m_dirtyLast = 0;
 }
 
 // -------------------------------------------------------------------------
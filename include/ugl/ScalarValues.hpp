@@ -22,6 +22,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #ifndef _SCALARVALUES_HPP_
 #define _SCALARVALUES_HPP_
 
+#include "BufferPool.hpp"
 #include "ScalarData.hpp"
 #include "StateSet.hpp"
 #include "Values.hpp"
@@ -37,18 +38,27 @@ namespace ugl
 /**
  * Adds additional scalar values provided by ScalarData to a Drawable and
  * renders them.
+ *
+ * The scalars are suballocated from the BufferPool; initialize() may be called
+ * again to re-specify the attribute pointer after the pool was compacted.
+ * update() uploads the changed range of scalars.
  */
 class ScalarValues : public Values
 {
 public:
     explicit ScalarValues(ScalarData& data);
+    virtual ~ScalarValues();
     virtual void initialize(StateSet& stateSet, VariantProgram& program);    
     virtual void extendDraw(StateSet& stateSet);
 
+    void update(ScalarData& data);
+
     void getTweakableParameters(bool** showScalars, glm::vec3** minColor, glm::vec3** maxColor);
 
 private:
-    GLuint      m_vertexScalarBuffer;
+    BufferPool::Handle m_vertexScalarBuffer;
+    GLint       m_vertexScalarLocation;     ///< -1 until initialized
+    GLsizei     m_scalarCount;
     GLfloat     m_min;
     GLfloat     m_max;
 
@@ -24,6 +24,8 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include <GL/glew.h>
 
+#include "GLState.hpp"
+
 #include <boost/utility.hpp>
 
 #include <string>
@@ -36,11 +38,25 @@ namespace ugl
  * Compiles, links, binds and manages a GLSL program (similar to Qt's
  * QOpenGLShaderProgram).
  *
+ * Sampler uniforms are assigned fixed texture units when the program is
+ * linked, or take bindless texture handles if GLState has bindless textures
+ * enabled at that time.
+ *
  * Errors are directly printed to stderr.
  */
 class ShaderProgram : private boost::noncopyable
 {
 public:
+    /// active uniform of a linked program, see getActiveUniforms()
+    struct ActiveUniform
+    {
+        GLuint  name;       ///< interned name, see internUniformName()
+        GLint   location;
+        GLenum  type;
+        GLsizei size;
+        GLint   unit;       ///< first texture unit of a sampler or -1
+    };
+
     ShaderProgram();
     ~ShaderProgram();
 
@@ -52,9 +68,29 @@ public:
     void bind();
     void release();
 
+    const std::vector<ActiveUniform>& getActiveUniforms() const;
+    unsigned long getGeneration() const;
+
+    bool usesBindlessTextures() const;
+    void setTextureHandle(size_t uniform, GLuint64 handle) const;
+
 private:
     GLuint  m_program;
 
+    /// changes on every link(), see nextGeneration()
+    unsigned long m_generation;
+
+    std::vector<ActiveUniform> m_activeUniforms;
+
+    /// sampler uniforms take texture handles instead of units
+    bool m_bindlessTextures;
+
+    /// last handle set for each active uniform (bindless textures only)
+    mutable std::vector<GLuint64> m_textureHandles;
+
+    void queryActiveUniforms();
+    static bool isSamplerType(GLenum type);
+
     template <typename GetObjectFunction, typename GetObjectInfoLogFunction>
     static bool checkStatus(
             GLuint object, GLenum pname, const std::string& errorText,
@@ -67,7 +103,9 @@ private:
 // -------------------------------------------------------------------------
 
 inline ShaderProgram::ShaderProgram() :
-    m_program(glCreateProgram())
+    m_program(glCreateProgram()),
+    m_generation(0u),
+    m_bindlessTextures(false)
 {
 }
 
@@ -97,14 +135,57 @@ inline void ShaderProgram::bindAttributeLocation(
 
 inline void ShaderProgram::bind()
 {
-    glUseProgram(m_program);
+    GLState::getInstance().useProgram(m_program);
 }
 
 // -------------------------------------------------------------------------
 
 inline void ShaderProgram::release()
 {
-    glUseProgram(0u);
+    GLState::getInstance().useProgram(0u);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Uniforms of the default block which have a location, queried once
+ * after linking. Members of uniform blocks are not included.
+ */
+inline const std::vector<ShaderProgram::ActiveUniform>&
+        ShaderProgram::getActiveUniforms() const
+{
+    return m_activeUniforms;
+}
+
+// -------------------------------------------------------------------------
+
+inline unsigned long ShaderProgram::getGeneration() const
+{
+    return m_generation;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool ShaderProgram::usesBindlessTextures() const
+{
+    return m_bindlessTextures;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Sets the texture handle of a sampler uniform (bindless textures
+ * only), skipping the call if the uniform already holds the handle.
+ * @param uniform Index into getActiveUniforms().
+ * @param handle
+ */
+inline void ShaderProgram::setTextureHandle(size_t uniform, GLuint64 handle) const
+{
+    if (m_textureHandles[uniform] == handle)
+        return;
+
+    glProgramUniformHandleui64ARB(m_program, m_activeUniforms[uniform].location, handle);
+    m_textureHandles[uniform] = handle;
 }
 
 } // namespace ugl
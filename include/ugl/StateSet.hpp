@@ -32,8 +32,6 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include <boost/optional.hpp>
 
-#include <functional>
-
 namespace ugl
 {
 
@@ -45,7 +43,8 @@ namespace ugl
  * sequence.
  *
  * If a state is not found in the current StateSet, its parents are
- * recursively visited to look for the state.
+ * recursively visited to look for the state. The result of this lookup is
+ * cached until a StateSet in the chain gains a state or changes its parent.
  */
 class StateSet
 {
@@ -56,9 +55,17 @@ private:
 
     const StateSet*                m_parent;
 
-    template <typename T>
-    const T* getMember(
-       std::function<const boost::optional<T>& (const StateSet*)> member) const;
+    /// generation of the last structural change of this StateSet
+    unsigned long                  m_generation;
+
+    mutable const UniformSet*      m_resolvedUniforms;
+    mutable const ModeSet*         m_resolvedModes;
+    mutable const glm::uvec4*      m_resolvedViewport;
+    mutable unsigned long          m_resolvedGeneration;
+    mutable const StateSet*        m_resolvedOwner;
+
+    unsigned long getGeneration() const;
+    void resolve() const;
 
     template <typename T>
     T& getOrCreateMember(boost::optional<T>& member);
@@ -68,6 +75,7 @@ public:
     StateSet(const StateSet& parent);
 
     ShaderProgram& apply(VariantProgram& program) const;
+    ShaderProgram& getProgram(VariantProgram& program) const;
 
     // methods for reading
     const UniformSet*    getUniforms()        const;
@@ -90,7 +98,10 @@ template <typename T>
 inline T& StateSet::getOrCreateMember(boost::optional<T>& member)
 {
     if (!member)
+    {
         member = T();
+        m_generation = nextGeneration();
+    }
 
     return *member;
 }
@@ -127,7 +138,11 @@ inline glm::uvec4& StateSet::getOrCreateViewport()
 
 inline void StateSet::setParent(const StateSet& parent)
 {
-    this->m_parent = &parent;
+    if (this->m_parent != &parent)
+    {
+        this->m_parent = &parent;
+        this->m_generation = nextGeneration();
+    }
 
     this->getOrCreateUniforms().setParent(parent.getUniforms());
     this->getOrCreateModes().setParent(parent.getModes());
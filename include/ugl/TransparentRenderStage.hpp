@@ -25,12 +25,15 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #include <GL/glew.h>
 
 #include "Drawable.hpp"
+#include "DrawableHierarchy.hpp"
+#include "Frustum.hpp"
 #include "Volume.hpp"
 #include "ShaderProgram.hpp"
 #include "StateSet.hpp"
 #include "Framebuffer.hpp"
 #include "MeshData.hpp"
 #include "MeshDrawable.hpp"
+#include "RenderQueue.hpp"
 
 #include <vector>
 
@@ -40,6 +43,9 @@ namespace ugl
 /**
  * Renders its \ref Drawable "Drawables" using Depth Peeling for Order
  * Independent Transparency.
+ *
+ * Drawables outside the view frustum are culled once per frame, before the
+ * peel passes (see DefaultRenderStage).
  */
 class TransparentRenderStage
 {
@@ -70,6 +76,16 @@ public:
 
     const std::vector<Drawable*>* getDrawables();
 
+    void setRecordingEnabled(bool enabled);
+    bool isRecordingEnabled() const;
+    const RenderQueue& getRenderQueue() const;
+
+    void setCullingEnabled(bool enabled);
+    bool isCullingEnabled() const;
+    void setCamera(const glm::mat4& projection, const glm::mat4& modelview);
+    void clearCamera();
+    const DrawableHierarchy::Statistics& getCullingStatistics() const;
+
 protected:    
     GLuint width;
     GLuint height;
@@ -93,7 +109,76 @@ protected:
 
     glm::vec4 backgroundColor;
     bool checkerboard;
+
+    bool recording;
+    RenderQueue renderQueue;
+
+    bool culling;
+    bool hasCamera;
+    Frustum camera;
+    DrawableHierarchy hierarchy;
+    std::vector<Drawable*> visibleDrawables;
 };
 
+// -------------------------------------------------------------------------
+
+inline void TransparentRenderStage::setRecordingEnabled(bool enabled)
+{
+    this->recording = enabled;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool TransparentRenderStage::isRecordingEnabled() const
+{
+    return this->recording;
+}
+
+// -------------------------------------------------------------------------
+
+inline const RenderQueue& TransparentRenderStage::getRenderQueue() const
+{
+    return this->renderQueue;
+}
+
+// -------------------------------------------------------------------------
+
+inline void TransparentRenderStage::setCullingEnabled(bool enabled)
+{
+    this->culling = enabled;
+}
+
+// -------------------------------------------------------------------------
+
+inline bool TransparentRenderStage::isCullingEnabled() const
+{
+    return this->culling;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Culls against the given camera instead of the matrices of the StateSet.
+ */
+inline void TransparentRenderStage::setCamera(const glm::mat4& projection, const glm::mat4& modelview)
+{
+    this->camera.set(projection, modelview);
+    this->hasCamera = true;
+}
+
+// -------------------------------------------------------------------------
+
+inline void TransparentRenderStage::clearCamera()
+{
+    this->hasCamera = false;
+}
+
+// -------------------------------------------------------------------------
+
+inline const DrawableHierarchy::Statistics& TransparentRenderStage::getCullingStatistics() const
+{
+    return this->hierarchy.getStatistics();
+}
+
 }
 #endif
@@ -0,0 +1,112 @@
+/** @file TriangleBVH.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _TRIANGLEBVH_HPP_
+#define _TRIANGLEBVH_HPP_
+
+#include "BoundingBox.hpp"
+#include "MeshData.hpp"
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ugl
+{
+
+/**
+ * Bounding volume hierarchy over the triangles of a MeshData for ray queries
+ * on the CPU.
+ *
+ * build() splits nodes with the surface area heuristic evaluated on BIN_COUNT
+ * centroid bins per axis; binning of large nodes runs in parallel. After the
+ * points moved (but not the triangles changed), refit() updates the boxes
+ * without changing the topology.
+ */
+class TriangleBVH
+{
+public:
+    struct Hit
+    {
+        GLuint    triangle;
+        glm::vec2 barycentrics;     ///< weights of the 2nd and 3rd point
+        float     distance;         ///< in multiples of the ray direction
+    };
+
+    static const int BIN_COUNT = 16;
+    static const int LEAF_SIZE = 4;
+
+    void build(const MeshData& data);
+    void refit(const MeshData& data);
+    void clear();
+
+    bool intersect(const MeshData& data, const glm::vec3& origin, const glm::vec3& direction,
+                   Hit* hit, float maxDistance = -1.0f) const;
+
+    const BoundingBox& getBoundingBox() const;
+    size_t getNodeCount() const;
+
+private:
+    /// a leaf if count > 0, else its children are at index + 1 and right
+    struct Node
+    {
+        BoundingBox box;
+        GLuint      first;
+        GLuint      count;
+        GLuint      right;
+    };
+
+    GLuint buildNode(GLuint first, GLuint count);
+    void computeBounds(GLuint first, GLuint count, BoundingBox* box, BoundingBox* centroidBox) const;
+
+    std::vector<Node>        m_nodes;
+    std::vector<GLuint>      m_triangles;   ///< triangle per leaf slot
+    std::vector<BoundingBox> m_boxes;       ///< per triangle, only during build
+    std::vector<glm::vec3>   m_centroids;   ///< per triangle, only during build
+    BoundingBox              m_empty;
+};
+
+// -------------------------------------------------------------------------
+
+inline void TriangleBVH::clear()
+{
+    m_nodes.clear();
+    m_triangles.clear();
+}
+
+// -------------------------------------------------------------------------
+
+inline const BoundingBox& TriangleBVH::getBoundingBox() const
+{
+    return m_nodes.empty() ? m_empty : m_nodes.front().box;
+}
+
+// -------------------------------------------------------------------------
+
+inline size_t TriangleBVH::getNodeCount() const
+{
+    return m_nodes.size();
+}
+
+} // namespace ugl
+#endif // _TRIANGLEBVH_HPP_
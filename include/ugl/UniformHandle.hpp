@@ -0,0 +1,119 @@
+/** @file UniformHandle.hpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#ifndef _UNIFORMHANDLE_HPP_
+#define _UNIFORMHANDLE_HPP_
+
+#include <GL/glew.h>
+
+#include <string>
+
+namespace ugl
+{
+
+class UniformSet;
+
+// -------------------------------------------------------------------------
+
+/**
+ * Interns a uniform name, i.e. maps it to a small integer id which is unique
+ * for the lifetime of the process. UniformSet and ShaderProgram use these ids
+ * instead of strings to look up values.
+ */
+GLuint internUniformName(const std::string& name);
+
+/// id of a name which was never interned, see findUniformName()
+const GLuint UNKNOWN_UNIFORM_NAME = ~0u;
+
+/// returns the id of an interned name (without interning it) or UNKNOWN_UNIFORM_NAME
+GLuint findUniformName(const std::string& name);
+
+/// returns the name of an interned uniform id
+const std::string& getUniformName(GLuint id);
+
+// -------------------------------------------------------------------------
+
+/**
+ * Untyped reference to a value slot of one UniformSet, as returned by
+ * UniformSet::handle(). Converts implicitly into a typed UniformHandle.
+ */
+struct UniformSlot
+{
+    const UniformSet* set;
+    GLint             slot;
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * Pre-resolved, typed reference to a uniform of a UniformSet.
+ *
+ * Setting a value through a handle involves neither hashing nor a map lookup,
+ * and the upload function is fixed at compile time by uniform_traits<T>:
+ *
+ *     UniformHandle<glm::mat4> mv = uniforms.handle("globals.modelviewMatrix");
+ *     // ... every frame:
+ *     uniforms.set(mv, viewCtrl.transform());
+ *
+ * A handle is only valid for the UniformSet which created it.
+ */
+template<typename T>
+class UniformHandle
+{
+public:
+    UniformHandle();
+    UniformHandle(const UniformSlot& slot);
+
+    bool isValid() const;
+
+private:
+    friend class UniformSet;
+
+    UniformSlot m_slot;
+};
+
+// -------------------------------------------------------------------------
+
+template<typename T>
+inline UniformHandle<T>::UniformHandle()
+{
+    m_slot.set  = nullptr;
+    m_slot.slot = -1;
+}
+
+// -------------------------------------------------------------------------
+
+template<typename T>
+inline UniformHandle<T>::UniformHandle(const UniformSlot& slot) :
+    m_slot(slot)
+{
+}
+
+// -------------------------------------------------------------------------
+
+template<typename T>
+inline bool UniformHandle<T>::isValid() const
+{
+    return m_slot.set != nullptr && m_slot.slot >= 0;
+}
+
+} // namespace ugl
+#endif // _UNIFORMHANDLE_HPP_
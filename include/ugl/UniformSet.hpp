@@ -22,24 +22,49 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #ifndef _UNIFORMSET_HPP_
 #define _UNIFORMSET_HPP_
 
-#include "AbstractValueSet.hpp"
+#include "GlobalUniformBlock.hpp"
+#include "ShaderProgram.hpp"
+#include "UniformHandle.hpp"
 #include "UniformTraits.hpp"
+#include "Utils.hpp"
 
 #include <GL/glew.h>
 
+#include <algorithm>
+#include <cassert>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace ugl
 {
 
 // -------------------------------------------------------------------------
 
+/// uploads count values to a uniform location of the current program
+typedef void (*uniform_upload_function)( GLint location, GLsizei count, const GLvoid* data );
+
+/// values up to this size (a dmat4) are stored inline in uniform_wrapper
+const size_t UNIFORM_INLINE_BYTES = 16 * sizeof(GLdouble);
+
 struct uniform_wrapper
 {
-    GLenum   type;
+    GLenum   type;          ///< 0 if the slot holds no value
     GLsizei  size;
-    GLubyte* data;
+    size_t   bytes;
+    uniform_upload_function upload; ///< null for textures
+    GLint    global;        ///< member of the globals block or -1
+
+    /// region for larger values (arrays) in the arena of the set, offset -1
+    /// if none; kept for reuse while the slot holds inline values
+    GLint    spill;
+    size_t   spillCapacity;
+
+    union
+    {
+        GLdouble align;
+        GLubyte  data[UNIFORM_INLINE_BYTES];
+    } storage;
 };
 
 struct ImageTexture
@@ -58,59 +83,282 @@ struct ImageTexture
 /**
  * A hierarchical set of OpenGL uniforms including texture references which can
  * be applied to a GLSL program.
+ *
+ * Values are addressed by interned names (see internUniformName()) and kept in
+ * slots. A slot stays valid as long as the set lives, so handle() can return a
+ * pre-resolved UniformHandle for values which are set every frame. If a value
+ * is not found in the current set, its parents are recursively visited.
+ *
+ * apply() caches which value each active uniform of a program resolves to and
+ * only repeats the lookup if the program was relinked or a set in the
+ * hierarchy gained or lost a value (see getGeneration()).
+ *
+ * Values up to UNIFORM_INLINE_BYTES live inside their slot, larger arrays in
+ * an arena owned by the set. A slot keeps its arena region while it holds
+ * smaller values, so neither is reallocated when a value is set again with the
+ * same or a smaller size. Grown arrays are extended in place at the end of the
+ * arena or moved, and the arena is compacted once half of it is abandoned.
+ * Copies of a set own their values.
+ *
+ * Values named "globals.*" which belong to the `Globals` block of globals.glsl
+ * are additionally staged in a GlobalUniformBlock and reach the programs
+ * through a shared uniform buffer instead of per-program uniform uploads.
  */
-class UniformSet : public AbstractValueSet<uniform_wrapper>
+class UniformSet
 {
 public:
+    UniformSet();
+
     template<typename T>
     void set( const std::string& name, const T& value );
 
     template<typename T>
-    void get( const std::string& name, T* target );
+    void set( const UniformHandle<T>& handle, const T& value );
+
+    template<typename T>
+    void get( const std::string& name, T* target ) const;
+
+    UniformSlot handle( const std::string& name );
 
     void setTexture( const std::string& name, GLenum target, GLuint texture );
     void setImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
 
-    void apply( GLuint program ) const;
+    void clear( const std::string& name );
+    void clear();
+
+    bool exists( const std::string& name ) const;
+    const uniform_wrapper* get( GLuint name ) const;
+
+    void setParent( const UniformSet* parent );
+
+    unsigned long getGeneration() const;
+
+    void apply( const ShaderProgram& program ) const;
+
+    size_t getTextureHash( const ShaderProgram& program ) const;
 
 private:
+    /// active uniform of a program together with the value it resolves to
+    struct ResolvedUniform
+    {
+        GLuint                 name;
+        GLuint                 index;   ///< in ShaderProgram::getActiveUniforms()
+        GLint                  location;
+        GLint                  unit;
+        const UniformSet*      owner;
+        const uniform_wrapper* value;
+    };
+
+    /// resolution of all active uniforms of one program, see resolve()
+    struct ResolvedProgram
+    {
+        const ShaderProgram*         program;
+        unsigned long                programGeneration;
+        unsigned long                generation;
+        const UniformSet*            resolver;
+        std::vector<ResolvedUniform> uniforms;
+    };
+
+    const std::vector<ResolvedUniform>& resolve( const ShaderProgram& program ) const;
+
 	void applyImageTextures() const;
+    const GlobalUniformBlock* updateGlobals() const;
 
 private:
-    void set( const std::string& name, GLenum type, GLsizei size, const GLvoid *data );
-    void get( const std::string& name, GLenum type, GLsizei size, GLvoid* data );
+    GLint getOrCreateSlot( const std::string& name );
+
+    void set( GLint slot, GLenum type, GLsizei size, size_t bytes,
+              const GLvoid *data, uniform_upload_function upload );
+    void get( const std::string& name, GLenum type, size_t bytes, GLvoid* data ) const;
+
+    const uniform_wrapper* find( GLuint name, const UniformSet** owner ) const;
+    const GLubyte* getData( const uniform_wrapper& w ) const;
+    GLubyte* getData( uniform_wrapper& w );
+
+    void reserveSpill( uniform_wrapper& w, size_t bytes );
+    void compactArena();
+
+    /// slot of each interned name in m_slots or -1
+    std::vector<GLint>           m_index;
+    std::vector<uniform_wrapper> m_slots;
+
+    /// storage of values which do not fit into a slot, in multiples of 8 bytes
+    std::vector<GLubyte>         m_arena;
+
+    /// bytes of the arena no slot refers to any more
+    size_t                       m_arenaWaste;
+
+    const UniformSet*            m_parent;
+
+    /// generation of the last change of the slots of this set which affects
+    /// the resolution of values (not bumped by updates of existing values)
+    unsigned long                m_generation;
+
+    mutable std::vector<ResolvedProgram> m_resolved;
 
 	std::map<GLuint, ImageTexture> imageTextures;
+
+    GlobalUniformBlock m_globals;
 };
 
 // -------------------------------------------------------------------------
 
+inline UniformSet::UniformSet() :
+    m_arenaWaste(0u),
+    m_parent(nullptr),
+    m_generation(nextGeneration())
+{
+}
+
+// -------------------------------------------------------------------------
+
 template<typename T>
 inline void UniformSet::set( const std::string& name, const T& value )
 {
-    set( name,
+    set( getOrCreateSlot(name),
          uniform_traits<T>::type(),
          uniform_traits<T>::size(value),
-         uniform_traits<T>::data(value) );
+         uniform_traits<T>::bytes(value),
+         uniform_traits<T>::data(value),
+         &uniform_traits<T>::upload );
 }
 
 // -------------------------------------------------------------------------
 
 template<typename T>
-inline void UniformSet::get( const std::string& name, T* target )
+inline void UniformSet::set( const UniformHandle<T>& handle, const T& value )
+{
+    assert( handle.m_slot.set == this );
+
+    set( handle.m_slot.slot,
+         uniform_traits<T>::type(),
+         uniform_traits<T>::size(value),
+         uniform_traits<T>::bytes(value),
+         uniform_traits<T>::data(value),
+         &uniform_traits<T>::upload );
+}
+
+// -------------------------------------------------------------------------
+
+template<typename T>
+inline void UniformSet::get( const std::string& name, T* target ) const
 {
     get( name,
          uniform_traits<T>::type(),
-         uniform_traits<T>::size(*target),
+         uniform_traits<T>::bytes(*target),
          (GLvoid*) target );
 }
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Reserves a slot for the given name and returns it, to be converted
+ * into a typed UniformHandle. The slot holds no value until it is set.
+ */
+inline UniformSlot UniformSet::handle( const std::string& name )
+{
+    UniformSlot out;
+    out.set  = this;
+    out.slot = getOrCreateSlot( name );
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
 inline void UniformSet::setTexture( const std::string& name,
                                     GLenum target, GLuint texture )
 {
-    set( name, target, 1, &texture );
+    set( getOrCreateSlot(name), target, 1, sizeof(GLuint), &texture, nullptr );
+}
+
+// -------------------------------------------------------------------------
+
+inline bool UniformSet::exists( const std::string& name ) const
+{
+    return !!get( findUniformName(name) );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Looks up a value by its interned name in this set and its parents.
+ * @return The value or null if no set in the hierarchy holds it (also for
+ * UNKNOWN_UNIFORM_NAME).
+ */
+inline const uniform_wrapper* UniformSet::get( GLuint name ) const
+{
+    const UniformSet* owner;
+    return find( name, &owner );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Same as get(GLuint), additionally returns the set holding the value
+ * (needed to access values stored in its arena).
+ */
+inline const uniform_wrapper* UniformSet::find( GLuint name,
+                                                const UniformSet** owner ) const
+{
+    const UniformSet* uniformSet = this;
+
+    do
+    {
+        if (name < uniformSet->m_index.size())
+        {
+            const GLint slot = uniformSet->m_index[name];
+            if (slot >= 0 && uniformSet->m_slots[slot].type != 0)
+            {
+                *owner = uniformSet;
+                return &uniformSet->m_slots[slot];
+            }
+        }
+
+        uniformSet = uniformSet->m_parent;
+    } while (uniformSet);
+
+    return nullptr;
+}
+
+// -------------------------------------------------------------------------
+
+inline const GLubyte* UniformSet::getData( const uniform_wrapper& w ) const
+{
+    return w.bytes <= UNIFORM_INLINE_BYTES ? w.storage.data : &m_arena[w.spill];
+}
+
+// -------------------------------------------------------------------------
+
+inline GLubyte* UniformSet::getData( uniform_wrapper& w )
+{
+    return w.bytes <= UNIFORM_INLINE_BYTES ? w.storage.data : &m_arena[w.spill];
+}
+
+// -------------------------------------------------------------------------
+
+inline void UniformSet::setParent( const UniformSet* parent )
+{
+    if( m_parent != parent )
+    {
+        m_parent     = parent;
+        m_generation = nextGeneration();
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the newest generation of this set and its parents.
+ */
+inline unsigned long UniformSet::getGeneration() const
+{
+    unsigned long out = 0u;
+
+    for( const UniformSet* uniformSet = this; uniformSet; uniformSet = uniformSet->m_parent )
+        out = std::max( out, uniformSet->m_generation );
+
+    return out;
 }
 
 } // namespace ugl
@@ -37,6 +37,10 @@ namespace ugl
 /**
  * Traits for getting the size and a data pointer of different possible input
  * data to UniformSet.
+ *
+ * upload() passes the data to the uniform at the given location of the
+ * current program; it is resolved at compile time so that UniformSet can
+ * store it as a plain function pointer instead of switching on the type.
  */
 template<typename T>
 struct uniform_traits
@@ -50,36 +54,55 @@ struct basic_uniform_traits
 {
     static const GLvoid* data( const T& t ) { return &t; }
     static GLsizei size( const T& /*t*/ ) { return 1; }
+    static size_t bytes( const T& /*t*/ ) { return sizeof(T); }
 };
 
 template<>
 struct uniform_traits<int> : public basic_uniform_traits<int>
 {
     static GLenum type() { return GL_INT; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform1iv( location, count, (const GLint*) data ); }
 };
 
 template<>
 struct uniform_traits<unsigned int> : public basic_uniform_traits<unsigned int>
 {
     static GLenum type() { return GL_UNSIGNED_INT; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform1uiv( location, count, (const GLuint*) data ); }
 };
 
 template<>
 struct uniform_traits<float> : public basic_uniform_traits<float>
 {
     static GLenum type() { return GL_FLOAT; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform1fv( location, count, (const GLfloat*) data ); }
 };
 
 template<>
 struct uniform_traits<double> : public basic_uniform_traits<double>
 {
     static GLenum type() { return GL_DOUBLE; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform1dv( location, count, (const GLdouble*) data ); }
 };
 
 template<>
 struct uniform_traits<bool> : public basic_uniform_traits<bool>
 {
     static GLenum type() { return GL_BOOL; }
+
+    // stored as unsigned int by UniformSet
+    static size_t bytes( const bool& /*t*/ ) { return sizeof(GLuint); }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform1uiv( location, count, (const GLuint*) data ); }
 };
 
 // --- glm types -----------------------------------------------------------
@@ -89,72 +112,151 @@ struct glm_uniform_traits_base
 {
     static const GLvoid* data( const T& m ) { return glm::value_ptr( m ); }
     static GLsizei size( const T& /*t*/ ) { return 1; }
+    static size_t bytes( const T& /*t*/ ) { return sizeof(T); }
 };
 
 template<>
 struct uniform_traits<glm::vec2> : glm_uniform_traits_base<glm::vec2>
 {
     static GLenum type() { return GL_FLOAT_VEC2; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform2fv( location, count, (const GLfloat*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::vec3> : glm_uniform_traits_base<glm::vec3>
 {
     static GLenum type() { return GL_FLOAT_VEC3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform3fv( location, count, (const GLfloat*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::vec4> : glm_uniform_traits_base<glm::vec4>
 {
     static GLenum type() { return GL_FLOAT_VEC4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform4fv( location, count, (const GLfloat*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::ivec2> : glm_uniform_traits_base<glm::ivec2>
 {
     static GLenum type() { return GL_INT_VEC2; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform2iv( location, count, (const GLint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::ivec3> : glm_uniform_traits_base<glm::ivec3>
 {
     static GLenum type() { return GL_INT_VEC3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform3iv( location, count, (const GLint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::ivec4> : glm_uniform_traits_base<glm::ivec4>
 {
     static GLenum type() { return GL_INT_VEC4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform4iv( location, count, (const GLint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::uvec2> : glm_uniform_traits_base<glm::uvec2>
 {
-    static GLenum type() { return GL_INT_VEC2; }
+    static GLenum type() { return GL_UNSIGNED_INT_VEC2; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform2uiv( location, count, (const GLuint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::uvec3> : glm_uniform_traits_base<glm::uvec3>
 {
-    static GLenum type() { return GL_INT_VEC3; }
+    static GLenum type() { return GL_UNSIGNED_INT_VEC3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform3uiv( location, count, (const GLuint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::uvec4> : glm_uniform_traits_base<glm::uvec4>
 {
-    static GLenum type() { return GL_INT_VEC4; }
+    static GLenum type() { return GL_UNSIGNED_INT_VEC4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform4uiv( location, count, (const GLuint*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::mat3> : glm_uniform_traits_base<glm::mat3>
 {
     static GLenum type() { return GL_FLOAT_MAT3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniformMatrix3fv( location, count, GL_FALSE, (const GLfloat*) data ); }
 };
 
 template<>
 struct uniform_traits<glm::mat4> : glm_uniform_traits_base<glm::mat4>
 {
     static GLenum type() { return GL_FLOAT_MAT4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniformMatrix4fv( location, count, GL_FALSE, (const GLfloat*) data ); }
+};
+
+template<>
+struct uniform_traits<glm::dvec2> : glm_uniform_traits_base<glm::dvec2>
+{
+    static GLenum type() { return GL_DOUBLE_VEC2; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform2dv( location, count, (const GLdouble*) data ); }
+};
+
+template<>
+struct uniform_traits<glm::dvec3> : glm_uniform_traits_base<glm::dvec3>
+{
+    static GLenum type() { return GL_DOUBLE_VEC3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform3dv( location, count, (const GLdouble*) data ); }
+};
+
+template<>
+struct uniform_traits<glm::dvec4> : glm_uniform_traits_base<glm::dvec4>
+{
+    static GLenum type() { return GL_DOUBLE_VEC4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniform4dv( location, count, (const GLdouble*) data ); }
+};
+
+template<>
+struct uniform_traits<glm::dmat3> : glm_uniform_traits_base<glm::dmat3>
+{
+    static GLenum type() { return GL_DOUBLE_MAT3; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniformMatrix3dv( location, count, GL_FALSE, (const GLdouble*) data ); }
+};
+
+template<>
+struct uniform_traits<glm::dmat4> : glm_uniform_traits_base<glm::dmat4>
+{
+    static GLenum type() { return GL_DOUBLE_MAT4; }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { glUniformMatrix4dv( location, count, GL_FALSE, (const GLdouble*) data ); }
 };
 
 // --- STL vector ----------------------------------------------------------
@@ -174,7 +276,19 @@ struct uniform_traits< std::vector<U> >
         return out;
     }
 
+    static size_t bytes( const std::vector<U>& vector )
+    {
+        size_t out = 0;
+        for( const U& element : vector )
+            out += uniform_traits<U>::bytes( element );
+
+        return out;
+    }
+
     static GLenum type() { return uniform_traits<U>::type(); }
+
+    static void upload( GLint location, GLsizei count, const GLvoid* data )
+    { uniform_traits<U>::upload( location, count, data ); }
 };
 
 } // namespace ugl
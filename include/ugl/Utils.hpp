@@ -22,11 +22,19 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cstddef>
 #include <string>
 
 namespace ugl
 {
 std::string getBaseDir();
+unsigned long nextGeneration();
+
+/// mixes a hash value into a seed (as boost::hash_combine)
+inline size_t hashCombine(size_t seed, size_t value)
+{
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
 }
 
 #endif
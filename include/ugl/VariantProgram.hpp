@@ -61,6 +61,7 @@ public:
     GLuint getUnusedAttributeLocation() const;
     ShaderProgram& bind(const DefineMap& defineMap);
     ShaderProgram& bind();
+    ShaderProgram& getProgram(const DefineMap& defineMap);
     void clearCache();
 
 public:
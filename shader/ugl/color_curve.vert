@@ -19,10 +19,20 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
     Author(s): C.Garth, T.Biedert
 */
 
-in int vertexCurveId;
+#ifndef CURVE_DRAW_ID
+    // fallback without ARB_shader_draw_parameters: the curve id is fetched as
+    // an instanced attribute at the base instance of each indirect draw, or
+    // per point if indirect draws are missing as well
+    in int vertexCurveId;
+#endif
+
 flat out int fragCurveId;
 
 void computeForColor()
 {
+#ifdef CURVE_DRAW_ID
+    fragCurveId = gl_DrawIDARB;
+#else
     fragCurveId = vertexCurveId;
+#endif
 }
@@ -24,6 +24,9 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 // -------------------------------------------------------------------------
 
 #version 400 core
+#ifdef CURVE_DRAW_ID
+    #extension GL_ARB_shader_draw_parameters : require
+#endif
 
 #import <ugl/globals.glsl>
 
@@ -19,13 +19,21 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
     Author(s): C.Garth, T.Biedert
 */
 
+#ifdef UGL_BINDLESS_TEXTURES
+    // sampler uniforms are set to texture handles (see GLState)
+    #extension GL_ARB_bindless_texture : require
+    layout(bindless_sampler) uniform;
+#endif
+
 struct Light
 {
     vec3  direction;
     float glossiness;
 };
 
-struct Globals
+// std140 block shared by all programs through a uniform buffer
+// (layout must match the member table in GlobalUniformBlock.cpp)
+layout(std140) uniform Globals
 {
     mat4  modelviewMatrix;
     mat4  modelviewMatrixInverse;
@@ -41,6 +49,4 @@ struct Globals
     Light light[1];
 
     vec3 defaultColor;
-};
-
-uniform Globals globals;
+} globals;
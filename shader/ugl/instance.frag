@@ -0,0 +1,42 @@
+/** @file instance.frag
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+flat in vec4  fragInstanceColor;
+flat in float fragInstanceScalar;
+
+#ifdef INSTANCE_SCALAR
+    uniform float scalarsMin;
+    uniform float scalarsMax;
+    uniform vec3  minColor;
+    uniform vec3  maxColor;
+#endif
+
+vec4 getInstanceColor()
+{
+#ifdef INSTANCE_SCALAR
+    float normalizedScalar
+            = clamp( (fragInstanceScalar - scalarsMin) / (scalarsMax - scalarsMin), 0.0, 1.0 );
+
+    return vec4( mix(minColor, maxColor, normalizedScalar), fragInstanceColor.a );
+#else
+    return fragInstanceColor;
+#endif
+}
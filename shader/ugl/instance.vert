@@ -0,0 +1,34 @@
+/** @file instance.vert
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+// per-instance attributes of InstancedMeshDrawable (see MeshInstance)
+in mat4  instanceTransform;
+in vec4  instanceColor;
+in float instanceScalar;
+
+flat out vec4  fragInstanceColor;
+flat out float fragInstanceScalar;
+
+void computeForInstance()
+{
+    fragInstanceColor  = instanceColor;
+    fragInstanceScalar = instanceScalar;
+}
@@ -31,6 +31,10 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #vertex
 // -------------------------------------------------------------------------
 
+#ifdef INSTANCED
+    #import <ugl/instance.vert>
+#endif
+
 #ifdef LINE_MODE
     #import <ugl/normal_none.vert>
     #import <ugl/color_white.vert>
@@ -42,9 +46,29 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 in vec3 vertexPosition;
 
+#ifdef QUANTIZED_POSITIONS
+// maps the normalized 16-bit positions back to the bounding box
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#endif
+
+vec3 getPosition()
+{
+#ifdef QUANTIZED_POSITIONS
+    return positionOffset + positionScale * vertexPosition;
+#else
+    return vertexPosition;
+#endif
+}
+
 void main( void )
 {
-    vec4 worldPos = globals.modelviewMatrix * vec4( vertexPosition, 1.0 );
+#ifdef INSTANCED
+    computeForInstance();
+    vec4 worldPos = globals.modelviewMatrix * instanceTransform * vec4( getPosition(), 1.0 );
+#else
+    vec4 worldPos = globals.modelviewMatrix * vec4( getPosition(), 1.0 );
+#endif
     gl_Position   = globals.projectionMatrix * worldPos;
 
     computeForNormal( worldPos );
@@ -57,6 +81,10 @@ void main( void )
 // fragment output
 #import <ugl/out.frag>
 
+#ifdef INSTANCED
+    #import <ugl/instance.frag>
+#endif
+
 #ifdef LINE_MODE
     #import <ugl/normal_none.frag>
     #import <ugl/color_white.frag>
@@ -69,7 +97,16 @@ uniform float alpha;
 
 void main( void )
 {
+#ifdef INSTANCED
+    #ifdef LINE_MODE
+        vec4 color = vec4( getColor(), alpha );
+    #else
+        vec4 instanceColor = getInstanceColor();
+        vec4 color = vec4( instanceColor.rgb, instanceColor.a * alpha );
+    #endif
+#else
     vec4 color = vec4( getColor(), alpha );
+#endif
     color = illuminate( color );
     outputFragment( color );
 }
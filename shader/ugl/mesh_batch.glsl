@@ -0,0 +1,114 @@
+/** @file mesh_batch.glsl
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+// -------------------------------------------------------------------------
+#common
+// -------------------------------------------------------------------------
+
+#version 430 core
+
+#ifdef BATCH_DRAW_ID
+    #extension GL_ARB_shader_draw_parameters : require
+#endif
+
+#import <ugl/globals.glsl>
+
+// per-draw parameters of MeshBatchDrawable, indexed by the draw id
+// (layout must match MeshBatchParameters)
+struct BatchParameters
+{
+    mat4  modelMatrix;
+    vec4  color;
+    float alpha;
+};
+
+layout(std430, binding = 1) readonly buffer Batch
+{
+    BatchParameters batch[];
+};
+
+// -------------------------------------------------------------------------
+#vertex
+// -------------------------------------------------------------------------
+
+#ifndef LINE_MODE
+    #import <ugl/illuminate.vert>
+
+    in  vec3 vertexNormal;
+    out vec3 fragNormal;
+#endif
+
+#ifndef BATCH_DRAW_ID
+    // fallback without ARB_shader_draw_parameters: the draw id is fetched as
+    // an instanced attribute at the base instance of each draw
+    in int batchDrawId;
+#endif
+
+in vec3 vertexPosition;
+
+flat out int fragDrawId;
+
+void main( void )
+{
+#ifdef BATCH_DRAW_ID
+    int drawId = gl_DrawIDARB;
+#else
+    int drawId = batchDrawId;
+#endif
+
+    mat4 modelMatrix = batch[drawId].modelMatrix;
+    vec4 worldPos    = globals.modelviewMatrix * modelMatrix * vec4( vertexPosition, 1.0 );
+    gl_Position      = globals.projectionMatrix * worldPos;
+
+    fragDrawId = drawId;
+
+#ifndef LINE_MODE
+    computeForIlluminate( worldPos );
+    fragNormal = normalize( globals.normalMatrix * mat3( modelMatrix ) * vertexNormal );
+#endif
+}
+
+// -------------------------------------------------------------------------
+#fragment
+// -------------------------------------------------------------------------
+
+// fragment output
+#import <ugl/out.frag>
+
+#ifdef LINE_MODE
+    #import <ugl/normal_none.frag>
+    #import <ugl/color_white.frag>
+#else
+    #import <ugl/normal_vertex.frag>
+#endif
+
+flat in int fragDrawId;
+
+void main( void )
+{
+#ifdef LINE_MODE
+    vec4 color = vec4( getColor(), batch[fragDrawId].alpha );
+#else
+    vec4 color = vec4( batch[fragDrawId].color.rgb, batch[fragDrawId].alpha );
+#endif
+    color = illuminate( color );
+    outputFragment( color );
+}
@@ -24,8 +24,26 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 in vec3 vertexNormal;
 out vec3 fragNormal;
 
+vec3 getVertexNormal()
+{
+#ifdef OCTAHEDRAL_NORMALS
+    // only xy are set, unfold the lower hemisphere of the octahedron
+    vec3 n = vec3( vertexNormal.xy, 1.0 - abs( vertexNormal.x ) - abs( vertexNormal.y ) );
+    if( n.z < 0.0 )
+        n.xy = ( 1.0 - abs( n.yx ) ) * mix( vec2( -1.0 ), vec2( 1.0 ), greaterThanEqual( n.xy, vec2( 0.0 ) ) );
+    return n;
+#else
+    return vertexNormal;
+#endif
+}
+
 void computeForNormal( vec4 worldPos )
 {
     computeForIlluminate( worldPos );
-    fragNormal = normalize( globals.normalMatrix * vertexNormal );
+#ifdef INSTANCED
+    // exact for rotations and uniform scaling (see instance.vert)
+    fragNormal = normalize( globals.normalMatrix * mat3( instanceTransform ) * getVertexNormal() );
+#else
+    fragNormal = normalize( globals.normalMatrix * getVertexNormal() );
+#endif
 }
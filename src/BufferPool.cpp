@@ -0,0 +1,379 @@
+/** @file BufferPool.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/BufferPool.hpp"
+#include "ugl/GLState.hpp"
+#include "ugl/Utils.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace ugl
+{
+
+const BufferPool::Handle BufferPool::INVALID_HANDLE;
+const GLsizeiptr BufferPool::ALIGNMENT;
+
+// -------------------------------------------------------------------------
+
+BufferPool::BufferPool() :
+    m_pageSize(32 * 1024 * 1024),
+    m_generation(nextGeneration())
+{
+}
+
+// -------------------------------------------------------------------------
+
+GLuint BufferPool::createPage(GLsizeiptr size)
+{
+    Page page;
+    page.size = size;
+    page.used = 0;
+    page.freeBlocks.insert(std::make_pair(0, size));
+
+    glGenBuffers(1, &page.buffer);
+    GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+
+    m_pages.push_back(page);
+
+    return m_pages.size() - 1;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief First-fit allocation from the free list of a page.
+ * @param size Aligned size.
+ */
+bool BufferPool::allocateInPage(GLuint index, GLsizeiptr size, GLintptr* offset)
+{
+    Page& page = m_pages[index];
+
+    for (std::map<GLintptr, GLsizeiptr>::iterator block = page.freeBlocks.begin(); block != page.freeBlocks.end(); ++block)
+    {
+        if (block->second < size)
+            continue;
+
+        *offset = block->first;
+
+        const GLintptr   rest     = block->first + size;
+        const GLsizeiptr restSize = block->second - size;
+
+        page.freeBlocks.erase(block);
+        if (restSize > 0)
+            page.freeBlocks.insert(std::make_pair(rest, restSize));
+
+        page.used += size;
+        return true;
+    }
+
+    return false;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns a block to the free list of a page, merging it with its
+ * neighbours.
+ */
+void BufferPool::releaseInPage(GLuint index, GLintptr offset, GLsizeiptr size)
+{
+    Page& page = m_pages[index];
+    page.used -= size;
+
+    std::map<GLintptr, GLsizeiptr>::iterator block =
+            page.freeBlocks.insert(std::make_pair(offset, size)).first;
+
+    // merge with the following block
+    std::map<GLintptr, GLsizeiptr>::iterator next = block;
+    ++next;
+    if (next != page.freeBlocks.end() && block->first + block->second == next->first)
+    {
+        block->second += next->second;
+        page.freeBlocks.erase(next);
+    }
+
+    // merge with the preceding block
+    if (block != page.freeBlocks.begin())
+    {
+        std::map<GLintptr, GLsizeiptr>::iterator previous = block;
+        --previous;
+        if (previous->first + previous->second == block->first)
+        {
+            previous->second += block->second;
+            page.freeBlocks.erase(block);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+BufferPool::Handle BufferPool::createHandle(const Allocation& allocation)
+{
+    if (!m_freeHandles.empty())
+    {
+        const Handle handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_allocations[handle] = allocation;
+        return handle;
+    }
+
+    m_allocations.push_back(allocation);
+    return m_allocations.size() - 1;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Allocates a block and optionally fills it.
+ * @param size Size in bytes; empty allocations still take one aligned block.
+ * @param data Initial content or null.
+ * @param owner Used for bookkeeping only, see releaseAll().
+ */
+BufferPool::Handle BufferPool::allocate(GLsizeiptr size, const GLvoid* data, const void* owner)
+{
+    const GLsizeiptr aligned = align(std::max<GLsizeiptr>(size, 1));
+
+    Allocation allocation;
+    allocation.size     = size;
+    allocation.capacity = aligned;
+    allocation.owner    = owner;
+
+    bool found = false;
+    for (GLuint page = 0; page < m_pages.size() && !found; ++page)
+    {
+        if (m_pages[page].size - m_pages[page].used < aligned)
+            continue;
+
+        if (allocateInPage(page, aligned, &allocation.offset))
+        {
+            allocation.page = page;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        allocation.page = createPage(std::max(m_pageSize, aligned));
+        allocateInPage(allocation.page, aligned, &allocation.offset);
+    }
+
+    allocation.buffer = m_pages[allocation.page].buffer;
+
+    const Handle handle = createHandle(allocation);
+
+    if (data && size > 0)
+        upload(handle, 0, size, data);
+
+    return handle;
+}
+
+// -------------------------------------------------------------------------
+
+void BufferPool::upload(Handle handle, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+    const Allocation& allocation = m_allocations[handle];
+
+    if (offset + size > allocation.size)
+    {
+        std::cerr << "BufferPool: upload exceeds the allocation" << std::endl;
+        return;
+    }
+
+    GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset + offset, size, data);
+    GLState::getInstance().bindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Reads back part of an allocation; synchronizes with the GPU.
+ */
+void BufferPool::download(Handle handle, GLintptr offset, GLsizeiptr size, GLvoid* data) const
+{
+    const Allocation& allocation = m_allocations[handle];
+
+    if (offset + size > allocation.size)
+    {
+        std::cerr << "BufferPool: download exceeds the allocation" << std::endl;
+        return;
+    }
+
+    GLState::getInstance().bindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, allocation.offset + offset, size, data);
+    GLState::getInstance().bindBuffer(GL_COPY_READ_BUFFER, 0u);
+}
+
+// -------------------------------------------------------------------------
+
+void BufferPool::release(Handle handle)
+{
+    if (handle == INVALID_HANDLE || m_allocations[handle].capacity == 0)
+        return;
+
+    Allocation& allocation = m_allocations[handle];
+    releaseInPage(allocation.page, allocation.offset, allocation.capacity);
+
+    allocation.size     = 0;
+    allocation.capacity = 0;
+    allocation.owner    = nullptr;
+    m_freeHandles.push_back(handle);
+}
+
+// -------------------------------------------------------------------------
+
+void BufferPool::releaseAll(const void* owner)
+{
+    for (Handle handle = 0; handle < m_allocations.size(); ++handle)
+        if (m_allocations[handle].capacity > 0 && m_allocations[handle].owner == owner)
+            release(handle);
+}
+
+// -------------------------------------------------------------------------
+
+size_t BufferPool::getOwnerBytes(const void* owner) const
+{
+    size_t out = 0u;
+
+    for (std::vector<Allocation>::const_iterator allocation = m_allocations.begin(); allocation != m_allocations.end(); ++allocation)
+        if (allocation->capacity > 0 && allocation->owner == owner)
+            out += allocation->size;
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+BufferPool::Statistics BufferPool::getStatistics() const
+{
+    Statistics out;
+    out.pages            = m_pages.size();
+    out.allocations      = m_allocations.size() - m_freeHandles.size();
+    out.capacity         = 0u;
+    out.used             = 0u;
+    out.freeBlocks       = 0u;
+    out.largestFreeBlock = 0u;
+
+    for (std::vector<Page>::const_iterator page = m_pages.begin(); page != m_pages.end(); ++page)
+    {
+        out.capacity   += page->size;
+        out.used       += page->used;
+        out.freeBlocks += page->freeBlocks.size();
+
+        for (std::map<GLintptr, GLsizeiptr>::const_iterator block = page->freeBlocks.begin(); block != page->freeBlocks.end(); ++block)
+            out.largestFreeBlock = std::max<size_t>(out.largestFreeBlock, block->second);
+    }
+
+    const size_t free = out.capacity - out.used;
+    out.fragmentation = free > 0u ? 1.0f - (float) out.largestFreeBlock / free : 0.0f;
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Packs all allocations into new pages (copying on the GPU) and
+ * releases the old pages. Temporarily needs memory for both.
+ */
+void BufferPool::compact()
+{
+    std::vector<Page> oldPages;
+    oldPages.swap(m_pages);
+
+    // largest allocations first, so that they do not straddle pages
+    std::vector<Handle> order;
+    for (Handle handle = 0; handle < m_allocations.size(); ++handle)
+        if (m_allocations[handle].capacity > 0)
+            order.push_back(handle);
+
+    std::sort(order.begin(), order.end(), [this](Handle a, Handle b)
+    {
+        return m_allocations[a].capacity > m_allocations[b].capacity;
+    });
+
+    GLState& state = GLState::getInstance();
+
+    for (std::vector<Handle>::const_iterator handle = order.begin(); handle != order.end(); ++handle)
+    {
+        Allocation& allocation = m_allocations[*handle];
+        const GLsizeiptr aligned = allocation.capacity;
+
+        GLuint page = m_pages.size();
+        GLintptr offset = 0;
+        for (GLuint candidate = 0; candidate < m_pages.size(); ++candidate)
+        {
+            if (allocateInPage(candidate, aligned, &offset))
+            {
+                page = candidate;
+                break;
+            }
+        }
+
+        if (page == m_pages.size())
+        {
+            page = createPage(std::max(m_pageSize, aligned));
+            allocateInPage(page, aligned, &offset);
+        }
+
+        if (allocation.size > 0)
+        {
+            state.bindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+            state.bindBuffer(GL_COPY_WRITE_BUFFER, m_pages[page].buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                allocation.offset, offset, allocation.size);
+        }
+
+        allocation.buffer = m_pages[page].buffer;
+        allocation.offset = offset;
+        allocation.page   = page;
+    }
+
+    state.bindBuffer(GL_COPY_READ_BUFFER, 0u);
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+
+    for (std::vector<Page>::const_iterator page = oldPages.begin(); page != oldPages.end(); ++page)
+        state.deleteBuffers(1, &page->buffer);
+
+    m_generation = nextGeneration();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Deletes all pages; all handles become invalid.
+ */
+void BufferPool::clear()
+{
+    for (std::vector<Page>::const_iterator page = m_pages.begin(); page != m_pages.end(); ++page)
+        GLState::getInstance().deleteBuffers(1, &page->buffer);
+
+    m_pages.clear();
+    m_allocations.clear();
+    m_freeHandles.clear();
+
+    m_generation = nextGeneration();
+}
+
+} // namespace ugl
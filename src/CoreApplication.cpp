@@ -20,6 +20,8 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/CoreApplication.hpp"
+#include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
 
 #include <GL/glew.h>
 #include <iostream>
@@ -65,6 +67,11 @@ void CoreApplication::uglInit()
     std::cout << "GLSL Version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
     std::cout << "GLEW Version: " << glewGetString(GLEW_VERSION) << std::endl;
 
+#ifndef NDEBUG
+    // let the driver report errors instead of polling glGetError
+    setGLDebugLevel(GLDebugLevel::Async);
+#endif
+
     // Do user initialization
     initGL();
 }
@@ -75,8 +82,14 @@ void CoreApplication::uglInit()
  */
 void CoreApplication::uglDraw()
 {
+#ifndef NDEBUG
     // Clear error flags
-    while (glGetError() != GL_NO_ERROR);
+    if (getGLDebugLevel() == GLDebugLevel::Off)
+        while (glGetError() != GL_NO_ERROR);
+#endif
+
+    // The GUI toolkit may have changed any state since the last frame
+    GLState::getInstance().beginFrame();
 
     // User rendering
     drawGL();
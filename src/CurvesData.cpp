@@ -20,15 +20,100 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/CurvesData.hpp"
+#include "ugl/Parallel.hpp"
+
+#include <algorithm>
+#include <utility>
 
 namespace ugl
 {
 
+namespace
+{
+
+/**
+ * @brief Squared distance of p to the segment from a to b.
+ */
+float segmentDistance2(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+{
+    const glm::vec3 ab     = b - a;
+    const float     length = glm::dot(ab, ab);
+    const float     t      = length > 0.0f ? glm::clamp(glm::dot(p - a, ab) / length, 0.0f, 1.0f) : 0.0f;
+    const glm::vec3 d      = a + t * ab - p;
+
+    return glm::dot(d, d);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Douglas-Peucker: flags the points of [first, first + count) which
+ * are needed to stay within tolerance of the curve.
+ * @return Number of flagged points.
+ */
+GLsizei simplifyCurve(const glm::vec3* points, GLsizei count, float tolerance,
+                      char* keep, std::vector< std::pair<GLint, GLint> >& stack)
+{
+    if (count <= 2)
+    {
+        std::fill(keep, keep + count, 1);
+        return count;
+    }
+
+    std::fill(keep, keep + count, 0);
+    keep[0] = keep[count - 1] = 1;
+
+    GLsizei kept = 2;
+    const float tolerance2 = tolerance * tolerance;
+
+    stack.clear();
+    stack.push_back(std::make_pair(0, count - 1));
+
+    while (!stack.empty())
+    {
+        const GLint first = stack.back().first;
+        const GLint last  = stack.back().second;
+        stack.pop_back();
+
+        float maxDistance2 = tolerance2;
+        GLint farthest     = -1;
+
+        for (GLint i = first + 1; i < last; ++i)
+        {
+            const float distance2 = segmentDistance2(points[i], points[first], points[last]);
+            if (distance2 > maxDistance2)
+            {
+                maxDistance2 = distance2;
+                farthest     = i;
+            }
+        }
+
+        if (farthest < 0)
+            continue;
+
+        keep[farthest] = 1;
+        ++kept;
+
+        if (farthest - first > 1)
+            stack.push_back(std::make_pair(first, farthest));
+        if (last - farthest > 1)
+            stack.push_back(std::make_pair(farthest, last));
+    }
+
+    return kept;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
 void CurvesData::addCurve(const std::vector<glm::vec3>& curve)
 {
     m_startPointIds.push_back(m_points.size());
     m_pointCounts.push_back(curve.size());
     m_points.insert(m_points.end(), curve.cbegin(), curve.cend());
+
+    m_simplifiedLevels.clear();
 }
 
 // -------------------------------------------------------------------------
@@ -37,6 +122,8 @@ void CurvesData::addEmptyCurve()
 {
     m_startPointIds.push_back(m_points.size());
     m_pointCounts.push_back(0);
+
+    m_simplifiedLevels.clear();
 }
 
 // -------------------------------------------------------------------------
@@ -45,6 +132,8 @@ void CurvesData::addPointToLastCurve(const glm::vec3& point)
 {
     ++m_pointCounts.back();
     m_points.push_back(point);
+
+    m_simplifiedLevels.clear();
 }
 
 // -------------------------------------------------------------------------
@@ -63,4 +152,65 @@ void CurvesData::recomputeCurveIdsOfPointIds()
     m_curveIdsOfPointIdsValid = true;
 }
 
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Computes one simplified level per tolerance (in object space) with
+ * the Douglas-Peucker algorithm; curves are simplified in parallel.
+ *
+ * Tolerances should be ascending, since renderers pick the last level whose
+ * error is acceptable.
+ */
+void CurvesData::computeSimplifiedLevels(const std::vector<float>& tolerances)
+{
+    const GLsizei curveCount = getCurveCount();
+
+    m_simplifiedLevels.assign(tolerances.size(), SimplifiedLevel());
+
+    std::vector<char> keep(m_points.size());
+
+    for (size_t level = 0; level < tolerances.size(); ++level)
+    {
+        SimplifiedLevel& out = m_simplifiedLevels[level];
+        out.tolerance = tolerances[level];
+        out.pointCounts.resize(curveCount);
+        out.startIndices.resize(curveCount);
+
+        // flag the kept points, each curve owns its range of flags
+        parallelFor(0, curveCount, [&](size_t begin, size_t end)
+        {
+            std::vector< std::pair<GLint, GLint> > stack;
+
+            for (size_t curveId = begin; curveId < end; ++curveId)
+            {
+                const GLint first = m_startPointIds[curveId];
+                out.pointCounts[curveId] = simplifyCurve(m_points.data() + first, m_pointCounts[curveId],
+                                                         out.tolerance, keep.data() + first, stack);
+            }
+        }, 256);
+
+        GLint next = 0;
+        for (GLsizei curveId = 0; curveId < curveCount; ++curveId)
+        {
+            out.startIndices[curveId] = next;
+            next += out.pointCounts[curveId];
+        }
+
+        out.pointIds.resize(next);
+
+        parallelFor(0, curveCount, [&](size_t begin, size_t end)
+        {
+            for (size_t curveId = begin; curveId < end; ++curveId)
+            {
+                GLuint* ids = out.pointIds.data() + out.startIndices[curveId];
+
+                const GLint first = m_startPointIds[curveId];
+                for (GLint pointId = first; pointId < first + m_pointCounts[curveId]; ++pointId)
+                    if (keep[pointId])
+                        *ids++ = pointId;
+            }
+        }, 256);
+    }
+}
+
 } // namespace ugl
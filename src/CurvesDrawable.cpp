@@ -20,17 +20,29 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/CurvesDrawable.hpp"
+#include "ugl/Frustum.hpp"
 #include "ugl/GLHelper.hpp"
+#include "ugl/GLState.hpp"
 #include "ugl/NoValues.hpp"
 
+#include <algorithm>
+
 namespace ugl
 {
 
 CurvesDrawable::CurvesDrawable( CurvesData& data ) :
+    m_curveIdSource( getCurveIdSource() ),
+    m_curveIdBuffer( BufferPool::INVALID_HANDLE ),
+    m_commandBuffer( BufferPool::INVALID_HANDLE ),
+    m_curveColorBuffer( BufferPool::INVALID_HANDLE ),
+    m_curveColorOwnBuffer( 0u ),
     // prepare start index array
     m_startIndices( data.getAllStartPointIds() ),
     // prepare index count array
     m_indexCounts( data.getAllPointCounts() ),
+    m_currentLevel( 0 ),
+    m_forcedLevel( -1 ),
+    m_pixelTolerance( 1.0f ),
     m_values( new NoValues() ),
     m_boundingBox( data.getBoundingBox() ),
     m_colorCurves( true ),
@@ -42,6 +54,37 @@ CurvesDrawable::CurvesDrawable( CurvesData& data ) :
 
 // -------------------------------------------------------------------------
 
+CurvesDrawable::~CurvesDrawable()
+{
+    delete m_values;
+
+    BufferPool::getInstance().releaseAll( this );
+
+    GLState& state = GLState::getInstance();
+    state.deleteBuffers( 1, &m_curveColorOwnBuffer );
+    state.deleteTextures( 1, &m_curveColorTex );
+    state.deleteVertexArrays( 1, &m_vertexArray );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Selects gl_DrawIDARB if available, otherwise the base instance of
+ * indirect draws (OpenGL 4.3 or ARB_multi_draw_indirect) or per-point ids.
+ */
+CurvesDrawable::CurveIdSource CurvesDrawable::getCurveIdSource()
+{
+    if( GLEW_ARB_shader_draw_parameters )
+        return DRAW_ID;
+
+    if( GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect )
+        return BASE_INSTANCE;
+
+    return VERTEX_ATTRIBUTE;
+}
+
+// -------------------------------------------------------------------------
+
 void CurvesDrawable::prepareShaderProgram()
 {
     m_program.addImportPath( "shader" );
@@ -50,31 +93,45 @@ void CurvesDrawable::prepareShaderProgram()
     m_program.addShaderFromSourceFile( COMBINED, "ugl/curves.glsl" );
 
     m_program.addAttributeLocation( "vertexPosition", 0u );
-    m_program.addAttributeLocation( "vertexCurveId", 1u );
+
+    if( m_curveIdSource == DRAW_ID )
+        m_stateSet.getOrCreateModes().set( "CURVE_DRAW_ID", 1 );
+    else
+        m_program.addAttributeLocation( "vertexCurveId", 1u );
 }
 
 // -------------------------------------------------------------------------
 
 void CurvesDrawable::prepareVertexArrays( CurvesData& data )
 {
-    // set up the vertex arrays and attribute bindings
-    glGenVertexArrays( 1, &m_vertexArray );
-    glBindVertexArray( m_vertexArray );
+    BufferPool& pool = BufferPool::getInstance();
 
-    // prepare vertex position buffer
-    m_vertexPositionBuffer = GLHelper::prepareStaticBuffer( data.getAllPoints() );
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexPositionBuffer );
-    glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
-    glEnableVertexAttribArray( 0u );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
+    // suballocate vertex positions
+    m_vertexPositionBuffer = pool.allocate( data.getAllPoints(), this );
+
+    // without gl_DrawIDARB, the base instance of each draw picks its curve id
+    if( m_curveIdSource == BASE_INSTANCE )
+    {
+        std::vector<GLint>       curveIds( data.getCurveCount() );
+        std::vector<DrawCommand> commands( data.getCurveCount() );
 
-    // prepare vertex curve buffer
-    m_vertexCurveIdBuffer = GLHelper::prepareStaticBuffer(
-                              data.getAllCurveIdsOfPointIds() );
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexCurveIdBuffer );
-    glVertexAttribIPointer( 1u, 1, GL_INT, 0, nullptr );
-    glEnableVertexAttribArray( 1u );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
+        for( GLint curveId = 0; curveId < data.getCurveCount(); ++curveId )
+        {
+            curveIds[curveId] = curveId;
+
+            commands[curveId].count         = m_indexCounts[curveId];
+            commands[curveId].instanceCount = 1u;
+            commands[curveId].first         = m_startIndices[curveId];
+            commands[curveId].baseInstance  = curveId;
+        }
+
+        m_curveIdBuffer = pool.allocate( curveIds, this );
+        m_commandBuffer = pool.allocate( commands, this );
+    }
+    else if( m_curveIdSource == VERTEX_ATTRIBUTE )
+    {
+        m_curveIdBuffer = pool.allocate( data.getAllCurveIdsOfPointIds(), this );
+    }
 
     // prepare buffer texture for curve colors
     {
@@ -89,16 +146,182 @@ void CurvesDrawable::prepareVertexArrays( CurvesData& data )
         for( std::vector<glm::vec3>::iterator point = startPoints.begin(); point != startPoints.end(); ++point )
             *point = startPointsBox.normalizePosition( *point );
 
-        m_curveColorBuffer = GLHelper::prepareStaticBuffer( startPoints );
         glGenTextures( 1, &m_curveColorTex );
-        glBindTexture( GL_TEXTURE_BUFFER, m_curveColorTex );
-        glTexBuffer( GL_TEXTURE_BUFFER, GL_RGB32F, m_curveColorBuffer );
+
+        // a texture buffer can only address part of a buffer with glTexBufferRange
+        if( GLEW_ARB_texture_buffer_range )
+        {
+            m_curveColorBuffer = pool.allocate( startPoints, this );
+        }
+        else
+        {
+            m_curveColorOwnBuffer = GLHelper::prepareStaticBuffer( startPoints );
+            GLState::getInstance().bindTexture( GL_TEXTURE_BUFFER, m_curveColorTex );
+            glTexBuffer( GL_TEXTURE_BUFFER, GL_RGB32F, m_curveColorOwnBuffer );
+            GLState::getInstance().bindTexture( GL_TEXTURE_BUFFER, 0u );
+        }
+
         m_stateSet.getOrCreateUniforms().setTexture( "curveColors",
                 GL_TEXTURE_BUFFER, m_curveColorTex );
-        glBindTexture( GL_TEXTURE_BUFFER, 0u );
     }
 
-    glBindVertexArray( 0u );
+    prepareLevels( data );
+
+    // set up the vertex arrays and attribute bindings
+    glGenVertexArrays( 1, &m_vertexArray );
+    bindVertexBuffers();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Suballocates the point ids of the simplified levels as indices.
+ */
+void CurvesDrawable::prepareLevels( CurvesData& data )
+{
+    BufferPool& pool = BufferPool::getInstance();
+
+    m_levels.resize( data.getSimplifiedLevelCount() );
+
+    for( GLint index = 0; index < data.getSimplifiedLevelCount(); ++index )
+    {
+        const CurvesData::SimplifiedLevel& simplified = data.getSimplifiedLevel( index );
+        Level& level = m_levels[index];
+
+        level.tolerance    = simplified.tolerance;
+        level.indices      = pool.allocate( simplified.pointIds, this );
+        level.startIndices = simplified.startIndices;
+        level.indexCounts  = simplified.pointCounts;
+
+        // filled by uploadLevelCommands(), the first indices depend on the pool offset
+        level.commands     = m_curveIdSource != BASE_INSTANCE
+                             ? BufferPool::INVALID_HANDLE
+                             : pool.allocate( level.startIndices.size() * sizeof(DrawElementsCommand), nullptr, this );
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Updates the index offsets (and indirect commands) of the levels to
+ * the current offsets of their indices in the pool.
+ */
+void CurvesDrawable::uploadLevelCommands()
+{
+    BufferPool& pool = BufferPool::getInstance();
+
+    for( std::vector<Level>::iterator level = m_levels.begin(); level != m_levels.end(); ++level )
+    {
+        const GLintptr base = pool.get( level->indices ).offset;
+
+        level->offsets.resize( level->startIndices.size() );
+        for( size_t curveId = 0; curveId < level->startIndices.size(); ++curveId )
+            level->offsets[curveId] = (const GLvoid*) ( base + level->startIndices[curveId] * sizeof(GLuint) );
+
+        if( level->commands == BufferPool::INVALID_HANDLE )
+            continue;
+
+        std::vector<DrawElementsCommand> commands( level->startIndices.size() );
+        for( size_t curveId = 0; curveId < commands.size(); ++curveId )
+        {
+            commands[curveId].count         = level->indexCounts[curveId];
+            commands[curveId].instanceCount = 1u;
+            commands[curveId].firstIndex    = base / sizeof(GLuint) + level->startIndices[curveId];
+            commands[curveId].baseVertex    = 0;
+            commands[curveId].baseInstance  = curveId;
+        }
+
+        if( !commands.empty() )
+            pool.upload( level->commands, 0, commands.size() * sizeof(DrawElementsCommand), commands.data() );
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the coarsest level whose tolerance projects to at most
+ * m_pixelTolerance pixels, or 0 if the view is unknown.
+ */
+GLint CurvesDrawable::selectLevel( const StateSet& state ) const
+{
+    if( m_forcedLevel >= 0 )
+        return std::min<GLint>( m_forcedLevel, m_levels.size() );
+
+    const glm::uvec4* viewport = state.getViewport();
+    glm::mat4         projection, modelview;
+
+    if( m_levels.empty() || !viewport ||
+        !Frustum::getViewMatrices( state, &projection, &modelview ) )
+        return 0;
+
+    // pixels per object space unit
+    const float scale         = glm::length( glm::vec3( modelview[0] ) );
+    float       pixelsPerUnit = scale * projection[1][1] * 0.5f * (*viewport)[3];
+
+    if( projection[2][3] != 0.0f )
+    {
+        const glm::vec3 center   = 0.5f * ( m_boundingBox.getMin() + m_boundingBox.getMax() );
+        const float     radius   = 0.5f * scale * glm::length( m_boundingBox.getMax() - m_boundingBox.getMin() );
+        const float     distance = -( modelview * glm::vec4( center.x, center.y, center.z, 1.0f ) ).z - radius;
+
+        // the camera is inside the bounding sphere
+        if( distance <= 0.0f )
+            return 0;
+
+        pixelsPerUnit /= distance;
+    }
+
+    GLint out = 0;
+    for( GLint level = 0; level < (GLint) m_levels.size(); ++level )
+        if( m_levels[level].tolerance * pixelsPerUnit <= m_pixelTolerance )
+            out = level + 1;
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Specifies the attribute pointers (including those of the values) and
+ * the curve color range at the current offsets in the pool; repeated when the
+ * pool was compacted.
+ */
+void CurvesDrawable::bindVertexBuffers()
+{
+    const BufferPool& pool = BufferPool::getInstance();
+
+    GLState::getInstance().bindVertexArray( m_vertexArray );
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, pool.get( m_vertexPositionBuffer ).buffer );
+    glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, 0, pool.getOffsetPointer( m_vertexPositionBuffer ) );
+    glEnableVertexAttribArray( 0u );
+
+    if( m_curveIdSource != DRAW_ID )
+    {
+        GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, pool.get( m_curveIdBuffer ).buffer );
+        glVertexAttribIPointer( 1u, 1, GL_INT, 0, pool.getOffsetPointer( m_curveIdBuffer ) );
+        glVertexAttribDivisor( 1u, m_curveIdSource == BASE_INSTANCE ? 1u : 0u );
+        glEnableVertexAttribArray( 1u );
+    }
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
+
+    m_values->initialize( m_stateSet, m_program );
+
+    GLState::getInstance().bindVertexArray( 0u );
+
+    if( m_curveColorBuffer != BufferPool::INVALID_HANDLE )
+    {
+        const BufferPool::Allocation& colors = pool.get( m_curveColorBuffer );
+
+        GLState::getInstance().bindTexture( GL_TEXTURE_BUFFER, m_curveColorTex );
+        glTexBufferRange( GL_TEXTURE_BUFFER, GL_RGB32F, colors.buffer, colors.offset, colors.size );
+        GLState::getInstance().bindTexture( GL_TEXTURE_BUFFER, 0u );
+    }
+
+    uploadLevelCommands();
+
+    m_bufferGeneration = pool.getGeneration();
 }
 
 // -------------------------------------------------------------------------
@@ -108,9 +331,9 @@ void CurvesDrawable::addValues(Values* values)
     delete m_values;
     m_values = values;
 
-    glBindVertexArray( m_vertexArray );
+    GLState::getInstance().bindVertexArray( m_vertexArray );
     m_values->initialize( m_stateSet, m_program );
-    glBindVertexArray( 0u );    
+    GLState::getInstance().bindVertexArray( 0u );    
 }
 
 // -------------------------------------------------------------------------
@@ -136,8 +359,11 @@ void CurvesDrawable::draw( const StateSet& state )
     UniformSet& uniforms = m_stateSet.getOrCreateUniforms();
     ModeSet&    modes    = m_stateSet.getOrCreateModes();
 
+    if( m_bufferGeneration != BufferPool::getInstance().getGeneration() )
+        bindVertexBuffers();
+
     // set render modes and issue draw calls
-    glBindVertexArray( m_vertexArray );
+    GLState::getInstance().bindVertexArray( m_vertexArray );
 
     modes.setOrClear( "COLOR_CURVES", m_colorCurves );
     uniforms.set( "alpha", m_alpha );
@@ -147,10 +373,44 @@ void CurvesDrawable::draw( const StateSet& state )
     // bind program and add uniforms
     m_stateSet.apply( m_program );
 
-    glMultiDrawArrays( GL_LINE_STRIP, m_startIndices.data(),
-                       m_indexCounts.data(), m_startIndices.size() );
+    const BufferPool& pool = BufferPool::getInstance();
+
+    m_currentLevel = selectLevel( state );
+
+    if( m_currentLevel > 0 )
+    {
+        const Level& level = m_levels[m_currentLevel - 1];
+
+        GLState::getInstance().bindBuffer( GL_ELEMENT_ARRAY_BUFFER, pool.get( level.indices ).buffer );
+
+        // the per-point curve ids are indexed like the positions
+        if( m_curveIdSource != BASE_INSTANCE )
+        {
+            glMultiDrawElements( GL_LINE_STRIP, level.indexCounts.data(), GL_UNSIGNED_INT,
+                                 level.offsets.data(), level.indexCounts.size() );
+        }
+        else
+        {
+            GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, pool.get( level.commands ).buffer );
+            glMultiDrawElementsIndirect( GL_LINE_STRIP, GL_UNSIGNED_INT, pool.getOffsetPointer( level.commands ),
+                                         level.indexCounts.size(), 0 );
+            GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, 0u );
+        }
+    }
+    else if( m_curveIdSource != BASE_INSTANCE )
+    {
+        glMultiDrawArrays( GL_LINE_STRIP, m_startIndices.data(),
+                           m_indexCounts.data(), m_startIndices.size() );
+    }
+    else
+    {
+        GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, pool.get( m_commandBuffer ).buffer );
+        glMultiDrawArraysIndirect( GL_LINE_STRIP, pool.getOffsetPointer( m_commandBuffer ),
+                                   m_startIndices.size(), 0 );
+        GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, 0u );
+    }
 
-    glBindVertexArray( 0u );
+    GLState::getInstance().bindVertexArray( 0u );
     // done drawing
 }
 
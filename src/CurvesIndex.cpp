@@ -0,0 +1,455 @@
+/** @file CurvesIndex.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/CurvesIndex.hpp"
+#include "ugl/Parallel.hpp"
+#include "ugl/Picker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ugl
+{
+
+const GLsizei CurvesIndex::GROUP_SEGMENTS;
+const GLsizei CurvesIndex::LEAF_SIZE;
+
+namespace
+{
+
+/**
+ * @brief Squared distance between the segment a + s * (b - a), 0 <= s <= 1,
+ * and the ray origin + t * direction, t >= 0 (after Ericson, "Real-Time
+ * Collision Detection", 5.1.9).
+ */
+float segmentRayDistance2(const glm::vec3& a, const glm::vec3& b,
+                          const glm::vec3& origin, const glm::vec3& direction,
+                          float* s, float* t)
+{
+    const glm::vec3 d1 = b - a;
+    const glm::vec3 r  = a - origin;
+
+    const float segmentLength2 = glm::dot(d1, d1);
+    const float rayLength2     = glm::dot(direction, direction);
+    const float f              = glm::dot(direction, r);
+
+    if (segmentLength2 <= 0.0f)
+    {
+        *s = 0.0f;
+        *t = std::max(f / rayLength2, 0.0f);
+    }
+    else
+    {
+        const float c           = glm::dot(d1, r);
+        const float d           = glm::dot(d1, direction);
+        const float denominator = segmentLength2 * rayLength2 - d * d;
+
+        // parallel lines: any s will do
+        *s = denominator > 0.0f ? glm::clamp((d * f - c * rayLength2) / denominator, 0.0f, 1.0f) : 0.0f;
+        *t = (d * *s + f) / rayLength2;
+
+        if (*t < 0.0f)
+        {
+            *t = 0.0f;
+            *s = glm::clamp(-c / segmentLength2, 0.0f, 1.0f);
+        }
+    }
+
+    const glm::vec3 delta = a + *s * d1 - (origin + *t * direction);
+    return glm::dot(delta, delta);
+}
+
+// -------------------------------------------------------------------------
+
+float pointSegmentDistance2(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+{
+    const glm::vec3 ab     = b - a;
+    const float     length = glm::dot(ab, ab);
+    const float     s      = length > 0.0f ? glm::clamp(glm::dot(p - a, ab) / length, 0.0f, 1.0f) : 0.0f;
+    const glm::vec3 delta  = a + s * ab - p;
+
+    return glm::dot(delta, delta);
+}
+
+// -------------------------------------------------------------------------
+
+float pointBoxDistance2(const glm::vec3& p, const BoundingBox& box)
+{
+    const glm::vec3 delta = glm::max(glm::max(box.getMin() - p, p - box.getMax()), glm::vec3(0.0f));
+    return glm::dot(delta, delta);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Slab test of the ray against the box grown by radius.
+ */
+bool rayHitsBox(const BoundingBox& box, float radius, const glm::vec3& origin, const glm::vec3& direction)
+{
+    float entry = 0.0f;
+    float exit  = std::numeric_limits<float>::max();
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float min = box.getMin()[axis] - radius;
+        const float max = box.getMax()[axis] + radius;
+
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < min || origin[axis] > max)
+                return false;
+            continue;
+        }
+
+        const float t0 = (min - origin[axis]) / direction[axis];
+        const float t1 = (max - origin[axis]) / direction[axis];
+
+        entry = std::max(entry, std::min(t0, t1));
+        exit  = std::min(exit,  std::max(t0, t1));
+    }
+
+    return entry <= exit;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Clips the segment from a to b against the box.
+ */
+bool segmentHitsBox(const glm::vec3& a, const glm::vec3& b, const BoundingBox& box)
+{
+    const glm::vec3 direction = b - a;
+
+    float entry = 0.0f;
+    float exit  = 1.0f;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (a[axis] < box.getMin()[axis] || a[axis] > box.getMax()[axis])
+                return false;
+            continue;
+        }
+
+        const float t0 = (box.getMin()[axis] - a[axis]) / direction[axis];
+        const float t1 = (box.getMax()[axis] - a[axis]) / direction[axis];
+
+        entry = std::max(entry, std::min(t0, t1));
+        exit  = std::min(exit,  std::max(t0, t1));
+
+        if (entry > exit)
+            return false;
+    }
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+
+bool boxesOverlap(const BoundingBox& a, const BoundingBox& b)
+{
+    for (int axis = 0; axis < 3; ++axis)
+        if (a.getMax()[axis] < b.getMin()[axis] || b.getMax()[axis] < a.getMin()[axis])
+            return false;
+
+    return true;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Indexes the curves (and points of the last curve) added since the
+ * previous update; starts over if the data shrank.
+ */
+void CurvesIndex::update(const CurvesData& data)
+{
+    if (data.getCurveCount() < m_indexedCurves ||
+        (m_indexedCurves > 0 && data.getPointCount(m_indexedCurves - 1) < m_indexedPoints))
+        clear();
+
+    const std::vector<GLint>& startPointIds = data.getAllStartPointIds();
+
+    std::vector<GLint> dirty;
+
+    // points appended to the last indexed curve
+    if (m_indexedCurves > 0 && data.getPointCount(m_indexedCurves - 1) > m_indexedPoints)
+    {
+        const GLint curveId = m_indexedCurves - 1;
+        const GLint first   = startPointIds[curveId] + std::max(m_indexedPoints - 1, 0);
+        const GLint last    = startPointIds[curveId] + data.getPointCount(curveId) - 1;
+
+        for (GLint pointId = first; pointId < last; ++pointId)
+            m_groups.back().segments.push_back(pointId);
+
+        dirty.push_back(m_groups.size() - 1);
+    }
+
+    for (GLint curveId = m_indexedCurves; curveId < data.getCurveCount(); ++curveId)
+    {
+        if (m_groups.empty() || (GLsizei) m_groups.back().segments.size() >= GROUP_SEGMENTS)
+        {
+            m_groups.push_back(Group());
+            m_groups.back().firstCurve = curveId;
+            m_groups.back().curveCount = 0;
+        }
+
+        Group& group = m_groups.back();
+        ++group.curveCount;
+
+        const GLint first = startPointIds[curveId];
+        for (GLint pointId = first; pointId < first + data.getPointCount(curveId) - 1; ++pointId)
+            group.segments.push_back(pointId);
+
+        if (dirty.empty() || dirty.back() != (GLint) m_groups.size() - 1)
+            dirty.push_back(m_groups.size() - 1);
+    }
+
+    m_indexedCurves = data.getCurveCount();
+    m_indexedPoints = m_indexedCurves > 0 ? data.getPointCount(m_indexedCurves - 1) : 0;
+
+    parallelFor(0, dirty.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            buildGroup(data, m_groups[dirty[i]]);
+    }, 1);
+}
+
+// -------------------------------------------------------------------------
+
+void CurvesIndex::buildGroup(const CurvesData& data, Group& group) const
+{
+    group.nodes.clear();
+    group.box = BoundingBox();
+
+    if (group.segments.empty())
+        return;
+
+    group.nodes.reserve(2 * group.segments.size() / LEAF_SIZE + 1);
+    buildNode(data.getAllPoints(), group, 0u, group.segments.size());
+
+    group.box = group.nodes.front().box;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Splits at the median of the segment midpoints along the longest
+ * axis of their bounds.
+ */
+GLuint CurvesIndex::buildNode(const std::vector<glm::vec3>& points, Group& group, GLuint first, GLuint count) const
+{
+    const GLuint index = group.nodes.size();
+    group.nodes.push_back(Node());
+
+    BoundingBox box, centerBox;
+    for (GLuint slot = first; slot < first + count; ++slot)
+    {
+        const glm::vec3& a = points[group.segments[slot]];
+        const glm::vec3& b = points[group.segments[slot] + 1];
+
+        box.add(a);
+        box.add(b);
+        centerBox.add(0.5f * (a + b));
+    }
+
+    group.nodes[index].box   = box;
+    group.nodes[index].first = first;
+    group.nodes[index].count = count;
+    group.nodes[index].right = 0u;
+
+    if (count <= (GLuint) LEAF_SIZE)
+        return index;
+
+    const glm::vec3 extent = centerBox.getMax() - centerBox.getMin();
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    const GLuint middle = first + count / 2;
+    std::nth_element(group.segments.begin() + first, group.segments.begin() + middle,
+                     group.segments.begin() + first + count,
+                     [&](GLuint a, GLuint b)
+                     {
+                         return points[a][axis] + points[a + 1][axis] < points[b][axis] + points[b + 1][axis];
+                     });
+
+    group.nodes[index].count = 0u;
+
+    buildNode(points, group, first, middle - first);
+    const GLuint right = buildNode(points, group, middle, first + count - middle);
+    group.nodes[index].right = right;
+
+    return index;
+}
+
+// -------------------------------------------------------------------------
+
+GLint CurvesIndex::getCurveOfPoint(const CurvesData& data, const Group& group, GLuint pointId) const
+{
+    const std::vector<GLint>& startPointIds = data.getAllStartPointIds();
+
+    const std::vector<GLint>::const_iterator begin = startPointIds.begin() + group.firstCurve;
+    const std::vector<GLint>::const_iterator end   = begin + group.curveCount;
+
+    return std::upper_bound(begin, end, (GLint) pointId) - startPointIds.begin() - 1;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Finds the curve passing closest to the ray origin + t * direction,
+ * t >= 0, within radius; equally close curves are ordered along the ray.
+ */
+bool CurvesIndex::nearest(const CurvesData& data, const glm::vec3& origin, const glm::vec3& direction,
+                          float radius, Hit* hit) const
+{
+    const std::vector<glm::vec3>& points = data.getAllPoints();
+
+    float bestDistance2 = radius * radius;
+    float bestRay       = std::numeric_limits<float>::max();
+    const Group* bestGroup = nullptr;
+    GLuint bestSegment = 0u;
+    GLuint bestPoint   = 0u;
+
+    for (std::vector<Group>::const_iterator group = m_groups.begin(); group != m_groups.end(); ++group)
+    {
+        traverse(*group,
+                 [&](const BoundingBox& box)
+                 {
+                     return rayHitsBox(box, std::sqrt(bestDistance2), origin, direction);
+                 },
+                 [&](GLuint pointId)
+                 {
+                     float s, t;
+                     const float distance2 = segmentRayDistance2(points[pointId], points[pointId + 1],
+                                                                 origin, direction, &s, &t);
+
+                     if (distance2 < bestDistance2 || (distance2 == bestDistance2 && t < bestRay))
+                     {
+                         bestDistance2 = distance2;
+                         bestRay       = t;
+                         bestGroup     = &*group;
+                         bestSegment   = pointId;
+                         bestPoint     = s < 0.5f ? pointId : pointId + 1;
+                     }
+                 });
+    }
+
+    if (!bestGroup)
+        return false;
+
+    hit->curveId     = getCurveOfPoint(data, *bestGroup, bestSegment);
+    hit->pointId     = bestPoint;
+    hit->distance    = std::sqrt(bestDistance2);
+    hit->rayDistance = bestRay;
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Picks with the ray through a position in normalized device
+ * coordinates, see Picker::computeRay().
+ */
+bool CurvesIndex::nearest(const CurvesData& data, const glm::mat4& projection, const glm::mat4& modelview,
+                          const glm::vec2& position, float radius, Hit* hit) const
+{
+    glm::vec3 origin, direction;
+    Picker::computeRay(projection, modelview, position, &origin, &direction);
+
+    return nearest(data, origin, direction, radius, hit);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Collects the ids of all curves with a segment in the box, sorted.
+ */
+void CurvesIndex::findCurves(const CurvesData& data, const BoundingBox& box, std::vector<GLint>& curveIds) const
+{
+    const std::vector<glm::vec3>& points = data.getAllPoints();
+
+    curveIds.clear();
+
+    for (std::vector<Group>::const_iterator group = m_groups.begin(); group != m_groups.end(); ++group)
+    {
+        traverse(*group,
+                 [&](const BoundingBox& node) { return boxesOverlap(node, box); },
+                 [&](GLuint pointId)
+                 {
+                     if (segmentHitsBox(points[pointId], points[pointId + 1], box))
+                         curveIds.push_back(getCurveOfPoint(data, *group, pointId));
+                 });
+    }
+
+    std::sort(curveIds.begin(), curveIds.end());
+    curveIds.erase(std::unique(curveIds.begin(), curveIds.end()), curveIds.end());
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Collects the ids of all curves passing within radius of center
+ * (a spherical brush), sorted.
+ */
+void CurvesIndex::findCurves(const CurvesData& data, const glm::vec3& center, float radius,
+                             std::vector<GLint>& curveIds) const
+{
+    const std::vector<glm::vec3>& points = data.getAllPoints();
+    const float radius2 = radius * radius;
+
+    curveIds.clear();
+
+    for (std::vector<Group>::const_iterator group = m_groups.begin(); group != m_groups.end(); ++group)
+    {
+        traverse(*group,
+                 [&](const BoundingBox& node) { return pointBoxDistance2(center, node) <= radius2; },
+                 [&](GLuint pointId)
+                 {
+                     if (pointSegmentDistance2(center, points[pointId], points[pointId + 1]) <= radius2)
+                         curveIds.push_back(getCurveOfPoint(data, *group, pointId));
+                 });
+    }
+
+    std::sort(curveIds.begin(), curveIds.end());
+    curveIds.erase(std::unique(curveIds.begin(), curveIds.end()), curveIds.end());
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Collects the groups whose bounding box intersects the frustum; each
+ * covers the curves getGroupFirstCurve() to getGroupFirstCurve() +
+ * getGroupCurveCount().
+ */
+void CurvesIndex::cullGroups(const Frustum& frustum, std::vector<GLint>& groups) const
+{
+    groups.clear();
+
+    for (GLint group = 0; group < (GLint) m_groups.size(); ++group)
+        if (!m_groups[group].segments.empty() && frustum.intersects(m_groups[group].box))
+            groups.push_back(group);
+}
+
+} // namespace ugl
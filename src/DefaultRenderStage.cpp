@@ -20,6 +20,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/DefaultRenderStage.hpp"
+#include "ugl/GLState.hpp"
 
 #include <iostream>
 
@@ -31,6 +32,7 @@ namespace ugl
 void DefaultRenderStage::addDrawable( Drawable* sr )
 {
     m_drawables.push_back( sr );
+    m_hierarchy.invalidate();
 }
 
 
@@ -42,11 +44,15 @@ void DefaultRenderStage::removeDrawable(Drawable* drawable)
 {
     if (std::find(m_drawables.begin(), m_drawables.end(), drawable)!=m_drawables.end())
       m_drawables.erase(std::remove(m_drawables.begin(), m_drawables.end(), drawable),m_drawables.end());
+    m_hierarchy.invalidate();
 }
 
 // ------------------------------------------------------------------------
 
-DefaultRenderStage::DefaultRenderStage()
+DefaultRenderStage::DefaultRenderStage() :
+    m_recording( false ),
+    m_culling( true ),
+    m_hasCamera( false )
 {
     //background
     m_bgProgram.addImportPath("shader");
@@ -73,13 +79,37 @@ void DefaultRenderStage::draw( StateSet& state, bool drawBg )
     UniformSet& uniforms = state.getOrCreateUniforms();
     uniforms.set("drawBg", drawBg);
     m_stateSet.apply(m_bgProgram);
-    glBindVertexArray(m_bgVAO);
+    GLState::getInstance().bindVertexArray(m_bgVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
-
-    for( std::vector<Drawable*>::iterator di=m_drawables.begin(); di != m_drawables.end(); ++di )
-        if ((*di)->isVisible())
-            (*di)->draw( m_stateSet );          
+    GLState::getInstance().bindVertexArray(0);
+
+    // cull against the camera or the matrices of the state, if known
+    Frustum frustum;
+    if( m_culling && m_hasCamera )
+        frustum = m_camera;
+    else if( m_culling )
+        frustum.setFromStateSet( m_stateSet );
+
+    m_hierarchy.cull( m_drawables, frustum, m_visibleDrawables );
+
+    if( !m_recording )
+    {
+        for( std::vector<Drawable*>::iterator di=m_visibleDrawables.begin(); di != m_visibleDrawables.end(); ++di )
+            (*di)->draw( m_stateSet );
+        return;
+    }
+
+    // record what can be recorded, draw the rest after the queue (drawing
+    // may reload programs which queued packets refer to)
+    std::vector<Drawable*> immediate;
+    for( std::vector<Drawable*>::iterator di=m_visibleDrawables.begin(); di != m_visibleDrawables.end(); ++di )
+        if (!(*di)->record( m_stateSet, m_queue ))
+            immediate.push_back( *di );
+
+    m_queue.execute();
+
+    for( std::vector<Drawable*>::iterator di=immediate.begin(); di != immediate.end(); ++di )
+        (*di)->draw( m_stateSet );
 }
     
 } // namespace ugl
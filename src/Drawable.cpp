@@ -34,13 +34,24 @@ Drawable::~Drawable()
 }
 
 
+/**
+ * @brief Records the draw calls of this drawable into a queue.
+ * @return False if the drawable does not support recording and has to be
+ * drawn with draw() instead (the default).
+ */
+bool Drawable::record(const StateSet& /*state*/, RenderQueue& /*queue*/)
+{
+    return false;
+}
+
+
 void Drawable::setVisible(bool visible)
 {
     this->visible = visible;
 }
 
 
-bool Drawable::isVisible()
+bool Drawable::isVisible() const
 {
     return this->visible;
 }
@@ -0,0 +1,233 @@
+/** @file DrawableHierarchy.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/DrawableHierarchy.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace ugl
+{
+
+const size_t DrawableHierarchy::MIN_DRAWABLES;
+
+// -------------------------------------------------------------------------
+
+namespace
+{
+
+/// orders drawable indices by the center of their box along one axis
+struct CompareCenters
+{
+    const std::vector<BoundingBox>& boxes;
+    int axis;
+
+    bool operator()(int a, int b) const
+    {
+        return boxes[a].getMin()[axis] + boxes[a].getMax()[axis] <
+               boxes[b].getMin()[axis] + boxes[b].getMax()[axis];
+    }
+};
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+DrawableHierarchy::DrawableHierarchy() :
+    m_valid(false)
+{
+    m_statistics.drawn  = 0u;
+    m_statistics.culled = 0u;
+}
+
+// -------------------------------------------------------------------------
+
+void DrawableHierarchy::build(const std::vector<Drawable*>& drawables)
+{
+    const int count = drawables.size();
+
+    m_boxes.resize(count);
+    m_order.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        m_boxes[i] = drawables[i]->getBoundingBox();
+        m_order[i] = i;
+    }
+
+    m_nodes.clear();
+    if (count > 0)
+        buildNode(0, count);
+
+    m_valid = true;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Builds the subtree over m_order[first, first + count) by a median
+ * split of the box centers along the longest axis.
+ * @return Index of the subtree root.
+ */
+int DrawableHierarchy::buildNode(int first, int count)
+{
+    const int index = m_nodes.size();
+    m_nodes.push_back(Node());
+
+    BoundingBox centers;
+    for (int i = first; i < first + count; ++i)
+    {
+        const BoundingBox& box = m_boxes[m_order[i]];
+        if (!box.isEmpty())
+            centers.add(0.5f * (box.getMin() + box.getMax()));
+    }
+
+    if (count <= LEAF_SIZE || centers.isEmpty())
+    {
+        m_nodes[index].first = first;
+        m_nodes[index].count = count;
+        m_nodes[index].right = -1;
+        return index;
+    }
+
+    const glm::vec3 extent = centers.getMax() - centers.getMin();
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    const int half = count / 2;
+    CompareCenters compare = { m_boxes, axis };
+    std::nth_element(m_order.begin() + first, m_order.begin() + first + half,
+                     m_order.begin() + first + count, compare);
+
+    buildNode(first, half);
+    const int right = buildNode(first + half, count - half);
+
+    m_nodes[index].first = first;
+    m_nodes[index].count = 0;
+    m_nodes[index].right = right;
+
+    return index;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Updates all boxes bottom-up. Children are stored after their parent,
+ * so a reverse sweep visits them first.
+ */
+void DrawableHierarchy::refit(const std::vector<Drawable*>& drawables)
+{
+    for (size_t i = 0; i < drawables.size(); ++i)
+    {
+        m_boxes[i] = drawables[i]->getBoundingBox();
+
+        // drawables without an extent yet are never culled
+        if (m_boxes[i].isEmpty())
+            m_boxes[i] = BoundingBox(glm::vec3(-std::numeric_limits<float>::max()),
+                                     glm::vec3( std::numeric_limits<float>::max()));
+    }
+
+    for (int index = (int) m_nodes.size() - 1; index >= 0; --index)
+    {
+        Node& node = m_nodes[index];
+        node.box = BoundingBox();
+
+        if (node.count > 0)
+        {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                node.box.add(m_boxes[m_order[i]]);
+        }
+        else
+        {
+            node.box.add(m_nodes[index + 1].box);
+            node.box.add(m_nodes[node.right].box);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Collects the visible drawables intersecting the frustum, in the
+ * order of the given vector.
+ */
+void DrawableHierarchy::cull(const std::vector<Drawable*>& drawables,
+                             const Frustum& frustum, std::vector<Drawable*>& visible)
+{
+    visible.clear();
+    m_inside.assign(drawables.size(), 0);
+
+    if (drawables.size() < MIN_DRAWABLES)
+    {
+        for (size_t i = 0; i < drawables.size(); ++i)
+            m_inside[i] = frustum.intersects(drawables[i]->getBoundingBox());
+    }
+    else
+    {
+        if (!m_valid || m_boxes.size() != drawables.size())
+            build(drawables);
+
+        refit(drawables);
+
+        std::vector<int> stack(1, 0);
+        while (!stack.empty())
+        {
+            const int index = stack.back();
+            const Node& node = m_nodes[index];
+            stack.pop_back();
+
+            if (!frustum.intersects(node.box))
+                continue;
+
+            if (node.count > 0)
+            {
+                for (int i = node.first; i < node.first + node.count; ++i)
+                    m_inside[m_order[i]] = frustum.intersects(m_boxes[m_order[i]]);
+            }
+            else
+            {
+                stack.push_back(node.right);
+                stack.push_back(index + 1);
+            }
+        }
+    }
+
+    m_statistics.drawn  = 0u;
+    m_statistics.culled = 0u;
+
+    for (size_t i = 0; i < drawables.size(); ++i)
+    {
+        if (!drawables[i]->isVisible())
+            continue;
+
+        if (m_inside[i])
+        {
+            visible.push_back(drawables[i]);
+            ++m_statistics.drawn;
+        }
+        else
+        {
+            ++m_statistics.culled;
+        }
+    }
+}
+
+} // namespace ugl
@@ -21,16 +21,178 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/ErrorCheck.hpp"
 
-#include <GL/glew.h>
-
 #include <iostream>
+#include <vector>
 #include <assert.h>
 
 namespace ugl
 {
 
-void checkAndPrintGLError(std::string label, const char* file, int line )
+// -------------------------------------------------------------------------
+
+namespace
+{
+
+GLDebugLevel debugLevel = GLDebugLevel::Off;
+
+/// debug groups pushed through pushGLDebugGroup() (synchronous level only)
+std::vector<std::string> debugGroups;
+
+const char* getDebugSourceName(GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API:             return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+        default:                              return "other";
+    }
+}
+
+const char* getDebugTypeName(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR:               return "Error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated behavior";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "Undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "Portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "Performance";
+        default:                                return "Message";
+    }
+}
+
+void GLAPIENTRY debugCallback(GLenum source, GLenum type, GLuint id,
+                              GLenum severity, GLsizei /*length*/,
+                              const GLchar* message, const void* /*userParam*/)
+{
+    std::cerr << "OpenGL " << getDebugTypeName(type)
+              << " (" << getDebugSourceName(source) << ", id " << id << "): "
+              << message;
+
+    if (debugLevel == GLDebugLevel::Synchronous && !debugGroups.empty())
+    {
+        std::cerr << " (Groups: ";
+        for (size_t i = 0; i < debugGroups.size(); ++i)
+            std::cerr << (i > 0 ? " > " : "") << debugGroups[i];
+        std::cerr << ")";
+    }
+
+    std::cerr << std::endl;
+
+#ifdef UGL_ASSERT_ON_OPENGL_ERROR
+    if (type == GL_DEBUG_TYPE_ERROR && severity == GL_DEBUG_SEVERITY_HIGH)
+        assert(false);
+#else
+    (void) severity;
+#endif
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Selects how OpenGL errors are reported.
+ * @return Whether the level could be set (false if KHR_debug is missing, in
+ * which case the level stays Off).
+ */
+bool setGLDebugLevel(GLDebugLevel level)
+{
+    if (level != GLDebugLevel::Off && !GLEW_KHR_debug)
+    {
+        debugLevel = GLDebugLevel::Off;
+        return false;
+    }
+
+    if (level == GLDebugLevel::Off)
+    {
+        if (debugLevel != GLDebugLevel::Off)
+        {
+            glDisable(GL_DEBUG_OUTPUT);
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(nullptr, nullptr);
+        }
+    }
+    else
+    {
+        glEnable(GL_DEBUG_OUTPUT);
+
+        if (level == GLDebugLevel::Synchronous)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        else
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+        glDebugMessageCallback(debugCallback, nullptr);
+
+        // notifications (e.g. buffer placement hints) are too chatty
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    }
+
+    debugLevel = level;
+    debugGroups.clear();
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+
+GLDebugLevel getGLDebugLevel()
+{
+    return debugLevel;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Opens a named debug group (synchronous level only), shown in debug
+ * messages and in tools like RenderDoc.
+ */
+void pushGLDebugGroup(const char* label)
+{
+    if (debugLevel != GLDebugLevel::Synchronous)
+        return;
+
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, label);
+    debugGroups.push_back(label);
+}
+
+// -------------------------------------------------------------------------
+
+void popGLDebugGroup()
 {
+    if (debugLevel != GLDebugLevel::Synchronous || debugGroups.empty())
+        return;
+
+    glPopDebugGroup();
+    debugGroups.pop_back();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Names an OpenGL object for debug messages (if KHR_debug is available).
+ * @param identifier Namespace of the object, e.g. GL_TEXTURE or GL_PROGRAM.
+ */
+void labelGLObject(GLenum identifier, GLuint name, const std::string& label)
+{
+    if (!GLEW_KHR_debug)
+        return;
+
+    glObjectLabel(identifier, name, (GLsizei) label.size(), label.c_str());
+}
+
+// -------------------------------------------------------------------------
+
+void checkAndPrintGLError(const std::string& label, const char* file, int line )
+{
+    // errors are reported by the debug callback instead
+    if (debugLevel != GLDebugLevel::Off)
+        return;
+
     std::string errors;
 
     GLenum error;    
@@ -21,6 +21,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/Framebuffer.hpp"
 #include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
 
 #include <iostream>
 
@@ -28,6 +29,25 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 namespace ugl
 {
 
+namespace
+{
+
+/**
+ * @brief Deletes a texture which has a bindless handle (its storage cannot be
+ * respecified), so that resize() creates a new one.
+ */
+void releaseImmutableTexture(GLuint& texture)
+{
+    if (texture != 0 && GLState::getInstance().hasTextureHandle(texture))
+    {
+        GLState::getInstance().deleteTextures(1, &texture);
+        texture = 0;
+    }
+}
+
+} // anonymous namespace
+
+
 /*
  * Constructor.
  */
@@ -81,10 +101,12 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     {
         ColorTextureConf curCConf = *(this->colorTextureConfs[i]);
 
+        releaseImmutableTexture(this->colorTextures[i]);
+
         if(this->colorTextures[i] == 0)
             glGenTextures(1, &this->colorTextures[i]);
 
-        glBindTexture(curCConf.target, this->colorTextures[i]);
+        GLState::getInstance().bindTexture(curCConf.target, this->colorTextures[i]);
 
         if (numSamples > 0)
         {
@@ -97,7 +119,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
         
         checkGLError();
 
-        glBindTexture(curCConf.target, 0);
+        GLState::getInstance().bindTexture(curCConf.target, 0);
     }
 
 
@@ -109,10 +131,12 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     //this->depthTextureConf->format          = depthFormat;
     //this->depthTextureConf->type            = depthType;
 
+    releaseImmutableTexture(this->depthTexture);
+
     if (this->depthTexture == 0)
         glGenTextures(1, &this->depthTexture);
 
-    glBindTexture(this->depthTextureConf->target, this->depthTexture);
+    GLState::getInstance().bindTexture(this->depthTextureConf->target, this->depthTexture);
 
     if (numSamples > 0)
     {
@@ -123,7 +147,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
         glTexImage2D(this->depthTextureConf->target, 0, this->depthTextureConf->internalFormat, width, height, 0, this->depthTextureConf->format, this->depthTextureConf->type, 0);
     }
 
-    glBindTexture(this->depthTextureConf->target, 0);
+    GLState::getInstance().bindTexture(this->depthTextureConf->target, 0);
 
 
     /*
@@ -134,14 +158,14 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
         glGenFramebuffers(1, &this->fbo);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, this->fbo);
     for(unsigned int i=0; i<this->colorTextures.size(); i++)
     {
         glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+i, this->colorTextures[i], 0);
     }
     glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->depthTexture, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
     /*
@@ -178,12 +202,14 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     {
         ColorTextureConf curCConf = *(this->colorTextureConfs[i]);
 
+        releaseImmutableTexture(this->colorTextures[i]);
+
         if(this->colorTextures[i] == 0)
             glGenTextures(1, &this->colorTextures[i]);
 
         //glActiveTexture(GL_TEXTURE0+i);
 
-        glBindTexture(curCConf.target, this->colorTextures[i]);
+        GLState::getInstance().bindTexture(curCConf.target, this->colorTextures[i]);
 
         if (numSamples > 0)
         {
@@ -199,7 +225,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
         glTexParameteri(curCConf.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
         checkGLError();
-        glBindTexture(curCConf.target, 0);
+        GLState::getInstance().bindTexture(curCConf.target, 0);
     }
 
 
@@ -211,11 +237,13 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     //this->depthTextureConf->format          = depthFormat;
     //this->depthTextureConf->type            = depthType;
 
+    releaseImmutableTexture(this->depthTexture);
+
     if (this->depthTexture == 0)
         glGenTextures(1, &this->depthTexture);
 
     //glActiveTexture(GL_TEXTURE0+colorTextures.size());
-    glBindTexture(this->depthTextureConf->target, this->depthTexture);
+    GLState::getInstance().bindTexture(this->depthTextureConf->target, this->depthTexture);
 
     if (numSamples > 0)
     {
@@ -231,7 +259,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     glTexParameteri(this->depthTextureConf->target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(this->depthTextureConf->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    glBindTexture(this->depthTextureConf->target, 0);
+    GLState::getInstance().bindTexture(this->depthTextureConf->target, 0);
 
 
     /*
@@ -242,7 +270,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
         glGenFramebuffers(1, &this->fbo);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, this->fbo);
     std::vector<GLuint> drawBuffers;
     for(unsigned int i=0; i<this->colorTextures.size(); i++)
     {
@@ -253,7 +281,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
     glDrawBuffers(drawBuffers.size(), drawBuffers.data());
     glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->depthTexture, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     /*
      * Store parameters
@@ -270,7 +298,7 @@ void Framebuffer::resize(unsigned int width, unsigned int height, unsigned int n
  */
 bool Framebuffer::checkCompleteness()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, this->fbo);
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
@@ -326,8 +354,8 @@ bool Framebuffer::checkCompleteness()
  */
 void Framebuffer::resolve()
 {
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->fbo);
+    GLState::getInstance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GLState::getInstance().bindFramebuffer(GL_READ_FRAMEBUFFER, this->fbo);
     glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, this->width, this->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 }
 
@@ -339,7 +367,7 @@ void Framebuffer::destroy()
 {
     if (this->fbo != 0)
     {
-        glDeleteFramebuffers(1, &this->fbo);
+        GLState::getInstance().deleteFramebuffers(1, &this->fbo);
         this->fbo = 0;
     }
 
@@ -347,14 +375,14 @@ void Framebuffer::destroy()
     {
         if (this->colorTextures[i] != 0)
         {
-            glDeleteTextures(1, &this->colorTextures[i]);
+            GLState::getInstance().deleteTextures(1, &this->colorTextures[i]);
             this->colorTextures[i] = 0;
         }
     }
 
     if (this->depthTexture != 0)
     {
-        glDeleteTextures(1, &this->depthTexture);
+        GLState::getInstance().deleteTextures(1, &this->depthTexture);
         this->depthTexture = 0;
     }
 }
@@ -0,0 +1,116 @@
+/** @file Frustum.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/Frustum.hpp"
+#include "ugl/StateSet.hpp"
+
+namespace ugl
+{
+
+/**
+ * @brief Default constructor, the frustum contains everything.
+ */
+Frustum::Frustum()
+{
+    for (int plane = 0; plane < 6; ++plane)
+        planes[plane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+
+/**
+ * @brief Explicit constructor.
+ * @param projection
+ * @param modelview
+ */
+Frustum::Frustum(const glm::mat4& projection, const glm::mat4& modelview)
+{
+    set(projection, modelview);
+}
+
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Extracts the planes from the rows of projection * modelview (Gribb
+ * and Hartmann).
+ */
+void Frustum::set(const glm::mat4& projection, const glm::mat4& modelview)
+{
+    const glm::mat4 m = projection * modelview;
+
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; ++row)
+        rows[row] = glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+}
+
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Sets the frustum from the globals.projectionMatrix and
+ * globals.modelviewMatrix uniforms of a StateSet.
+ * @return False (and the frustum is left unchanged) if one of them is missing.
+ */
+bool Frustum::setFromStateSet(const StateSet& state)
+{
+    glm::mat4 projection, modelview;
+
+    if (!getViewMatrices(state, &projection, &modelview))
+        return false;
+
+    set(projection, modelview);
+
+    return true;
+}
+
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Reads the globals.projectionMatrix and globals.modelviewMatrix
+ * uniforms of a StateSet (or its parents).
+ * @return False (and the matrices are left unchanged) if one of them is
+ * missing.
+ */
+bool Frustum::getViewMatrices(const StateSet& state,
+                              glm::mat4* projection, glm::mat4* modelview)
+{
+    const UniformSet* uniforms = state.getUniforms();
+
+    if (!uniforms ||
+        !uniforms->exists("globals.projectionMatrix") ||
+        !uniforms->exists("globals.modelviewMatrix"))
+        return false;
+
+    uniforms->get("globals.projectionMatrix", projection);
+    uniforms->get("globals.modelviewMatrix", modelview);
+
+    return true;
+}
+
+} // namespace ugl
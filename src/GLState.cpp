@@ -0,0 +1,419 @@
+/** @file GLState.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/GLState.hpp"
+
+#include <iostream>
+
+namespace ugl
+{
+
+// -------------------------------------------------------------------------
+
+namespace
+{
+
+/// glGet parameter of the binding of a buffer target (0 if not validated)
+GLenum getBufferBindingQuery(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:               return GL_ARRAY_BUFFER_BINDING;
+    case GL_ELEMENT_ARRAY_BUFFER:       return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+    case GL_UNIFORM_BUFFER:             return GL_UNIFORM_BUFFER_BINDING;
+    case GL_SHADER_STORAGE_BUFFER:      return GL_SHADER_STORAGE_BUFFER_BINDING;
+    case GL_ATOMIC_COUNTER_BUFFER:      return GL_ATOMIC_COUNTER_BUFFER_BINDING;
+    case GL_DRAW_INDIRECT_BUFFER:       return GL_DRAW_INDIRECT_BUFFER_BINDING;
+    case GL_COPY_READ_BUFFER:           return GL_COPY_READ_BUFFER_BINDING;
+    case GL_COPY_WRITE_BUFFER:          return GL_COPY_WRITE_BUFFER_BINDING;
+    case GL_PIXEL_PACK_BUFFER:          return GL_PIXEL_PACK_BUFFER_BINDING;
+    case GL_PIXEL_UNPACK_BUFFER:        return GL_PIXEL_UNPACK_BUFFER_BINDING;
+    default:                            return 0;
+    }
+}
+
+/// glGet parameter of the binding of a texture target (0 if not validated)
+GLenum getTextureBindingQuery(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_1D:                   return GL_TEXTURE_BINDING_1D;
+    case GL_TEXTURE_2D:                   return GL_TEXTURE_BINDING_2D;
+    case GL_TEXTURE_3D:                   return GL_TEXTURE_BINDING_3D;
+    case GL_TEXTURE_1D_ARRAY:             return GL_TEXTURE_BINDING_1D_ARRAY;
+    case GL_TEXTURE_2D_ARRAY:             return GL_TEXTURE_BINDING_2D_ARRAY;
+    case GL_TEXTURE_RECTANGLE:            return GL_TEXTURE_BINDING_RECTANGLE;
+    case GL_TEXTURE_CUBE_MAP:             return GL_TEXTURE_BINDING_CUBE_MAP;
+    case GL_TEXTURE_BUFFER:               return GL_TEXTURE_BINDING_BUFFER;
+    case GL_TEXTURE_2D_MULTISAMPLE:       return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY;
+    default:                              return 0;
+    }
+}
+
+/// prints a mismatch between a shadow binding and the actual GL state
+bool check(const char* what, GLuint shadow, GLint actual)
+{
+    if (shadow == (GLuint) actual)
+        return true;
+
+    std::cerr << "GLState mismatch: " << what << " is " << actual
+              << ", expected " << shadow << std::endl;
+    return false;
+}
+
+} // anonymous namespace
+
+const GLuint GLState::UNKNOWN;
+
+// -------------------------------------------------------------------------
+
+GLState::GLState() :
+#ifdef UGL_VALIDATE_GL_STATE
+    m_validate(true)
+#else
+    m_validate(false)
+#endif
+    , m_bindlessTextures(false)
+{
+    m_counters.issued = m_counters.elided = 0u;
+    m_lastFrameCounters = m_counters;
+
+    invalidate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint& bound = m_buffers.insert(std::make_pair(target, UNKNOWN)).first->second;
+
+    if (elide(bound == buffer))
+        return;
+
+    glBindBuffer(target, buffer);
+    bound = buffer;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    GLuint& bound = m_indexedBuffers.insert(
+            std::make_pair(IndexedTarget(target, index), UNKNOWN)).first->second;
+
+    if (elide(bound == buffer && m_buffers.count(target) && m_buffers[target] == buffer))
+        return;
+
+    // also binds the buffer to the generic binding point of the target
+    glBindBufferBase(target, index, buffer);
+    bound = buffer;
+    m_buffers[target] = buffer;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::bindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format)
+{
+    const ImageUnit image = { texture, level, layered, layer, access, format };
+
+    std::map<GLuint, ImageUnit>::iterator it = m_imageUnits.find(unit);
+    const bool redundant = it != m_imageUnits.end() &&
+            it->second.texture == texture && it->second.level == level &&
+            it->second.layered == layered && it->second.layer == layer &&
+            it->second.access == access && it->second.format == format;
+
+    if (elide(redundant))
+        return;
+
+    glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    m_imageUnits[unit] = image;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+    if (elide((!draw || m_drawFramebuffer == framebuffer) &&
+              (!read || m_readFramebuffer == framebuffer)))
+        return;
+
+    glBindFramebuffer(target, framebuffer);
+
+    if (draw)
+        m_drawFramebuffer = framebuffer;
+    if (read)
+        m_readFramebuffer = framebuffer;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+    std::map<GLenum, bool>::iterator it = m_capabilities.find(capability);
+
+    if (elide(it != m_capabilities.end() && it->second == enabled))
+        return;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+
+    m_capabilities[capability] = enabled;
+
+    if (m_validate)
+        validate();
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::deleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    glDeleteBuffers(n, buffers);
+
+    // deleted buffers are unbound from all targets, their names may be reused
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (std::map<GLenum, GLuint>::iterator it = m_buffers.begin(); it != m_buffers.end(); ++it)
+            if (it->second == buffers[i])
+                it->second = 0u;
+
+        for (std::map<IndexedTarget, GLuint>::iterator it = m_indexedBuffers.begin(); it != m_indexedBuffers.end(); ++it)
+            if (it->second == buffers[i])
+                it->second = 0u;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::deleteTextures(GLsizei n, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        std::map<GLuint, GLuint64>::iterator it = m_residentTextures.find(textures[i]);
+        if (it != m_residentTextures.end())
+        {
+            glMakeTextureHandleNonResidentARB(it->second);
+            m_residentTextures.erase(it);
+        }
+    }
+
+    glDeleteTextures(n, textures);
+
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (std::map<TextureTarget, GLuint>::iterator it = m_textures.begin(); it != m_textures.end(); ++it)
+            if (it->second == textures[i])
+                it->second = 0u;
+
+        // image units are not reset by the deletion
+        for (std::map<GLuint, ImageUnit>::iterator it = m_imageUnits.begin(); it != m_imageUnits.end(); )
+            if (it->second.texture == textures[i])
+                m_imageUnits.erase(it++);
+            else
+                ++it;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::deleteVertexArrays(GLsizei n, const GLuint* vertexArrays)
+{
+    glDeleteVertexArrays(n, vertexArrays);
+
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (m_vertexArray == vertexArrays[i])
+        {
+            m_vertexArray = 0u;
+            m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void GLState::deleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    glDeleteFramebuffers(n, framebuffers);
+
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (m_drawFramebuffer == framebuffers[i])
+            m_drawFramebuffer = 0u;
+        if (m_readFramebuffer == framebuffers[i])
+            m_readFramebuffer = 0u;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Switches between texture units and bindless texture handles for
+ * sampler uniforms. Only affects programs linked afterwards.
+ * @return Whether bindless textures are used (false if ARB_bindless_texture
+ * is not available).
+ */
+bool GLState::setBindlessTexturesEnabled(bool enabled)
+{
+    m_bindlessTextures = enabled && GLEW_ARB_bindless_texture;
+    return m_bindlessTextures;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Forgets the shadow state, i.e. the next call for each binding is
+ * issued. Needed after OpenGL state was changed without going through GLState.
+ */
+void GLState::invalidate()
+{
+    m_program         = UNKNOWN;
+    m_vertexArray     = UNKNOWN;
+    m_activeTexture   = UNKNOWN;
+    m_drawFramebuffer = UNKNOWN;
+    m_readFramebuffer = UNKNOWN;
+
+    m_buffers.clear();
+    m_indexedBuffers.clear();
+    m_textures.clear();
+    m_imageUnits.clear();
+    m_capabilities.clear();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Starts a new frame: invalidates the shadow state and restarts the
+ * counters (the previous frame remains available in getLastFrameCounters()).
+ */
+void GLState::beginFrame()
+{
+    invalidate();
+
+    m_lastFrameCounters = m_counters;
+    m_counters.issued = m_counters.elided = 0u;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Compares all known shadow bindings against glGet.
+ * @return Whether the shadow state matches (mismatches are printed).
+ */
+bool GLState::validate() const
+{
+    bool out = true;
+    GLint value;
+
+    if (m_program != UNKNOWN)
+    {
+        glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+        out &= check("GL_CURRENT_PROGRAM", m_program, value);
+    }
+
+    if (m_vertexArray != UNKNOWN)
+    {
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+        out &= check("GL_VERTEX_ARRAY_BINDING", m_vertexArray, value);
+    }
+
+    if (m_drawFramebuffer != UNKNOWN)
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &value);
+        out &= check("GL_DRAW_FRAMEBUFFER_BINDING", m_drawFramebuffer, value);
+    }
+
+    if (m_readFramebuffer != UNKNOWN)
+    {
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &value);
+        out &= check("GL_READ_FRAMEBUFFER_BINDING", m_readFramebuffer, value);
+    }
+
+    for (std::map<GLenum, GLuint>::const_iterator it = m_buffers.begin(); it != m_buffers.end(); ++it)
+    {
+        const GLenum query = getBufferBindingQuery(it->first);
+        if (query == 0 || it->second == UNKNOWN)
+            continue;
+
+        glGetIntegerv(query, &value);
+        out &= check("buffer binding", it->second, value);
+    }
+
+    for (std::map<IndexedTarget, GLuint>::const_iterator it = m_indexedBuffers.begin(); it != m_indexedBuffers.end(); ++it)
+    {
+        const GLenum query = getBufferBindingQuery(it->first.first);
+        if (query == 0 || it->second == UNKNOWN)
+            continue;
+
+        glGetIntegeri_v(query, it->first.second, &value);
+        out &= check("indexed buffer binding", it->second, value);
+    }
+
+    for (std::map<GLuint, ImageUnit>::const_iterator it = m_imageUnits.begin(); it != m_imageUnits.end(); ++it)
+    {
+        glGetIntegeri_v(GL_IMAGE_BINDING_NAME, it->first, &value);
+        out &= check("GL_IMAGE_BINDING_NAME", it->second.texture, value);
+    }
+
+    for (std::map<GLenum, bool>::const_iterator it = m_capabilities.begin(); it != m_capabilities.end(); ++it)
+        out &= check("capability", it->second, glIsEnabled(it->first));
+
+    if (m_activeTexture != UNKNOWN)
+    {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+        out &= check("GL_ACTIVE_TEXTURE", GL_TEXTURE0 + m_activeTexture, value);
+
+        // querying texture bindings requires switching the active unit
+        for (std::map<TextureTarget, GLuint>::const_iterator it = m_textures.begin(); it != m_textures.end(); ++it)
+        {
+            const GLenum query = getTextureBindingQuery(it->first.second);
+            if (query == 0 || it->second == UNKNOWN)
+                continue;
+
+            glActiveTexture(GL_TEXTURE0 + it->first.first);
+            glGetIntegerv(query, &value);
+            out &= check("texture binding", it->second, value);
+        }
+
+        glActiveTexture(GL_TEXTURE0 + m_activeTexture);
+    }
+
+    return out;
+}
+
+} // namespace ugl
@@ -0,0 +1,274 @@
+/** @file GlobalUniformBlock.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/GlobalUniformBlock.hpp"
+#include "ugl/GLState.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace ugl
+{
+
+// -------------------------------------------------------------------------
+
+namespace
+{
+
+/**
+ * std140 layout of the `Globals` block in globals.glsl. Has to be kept in
+ * sync with the shader declaration.
+ */
+struct BlockMember
+{
+    const char* name;
+    GLenum      type;
+    GLuint      offset;
+    GLuint      bytes;
+};
+
+const BlockMember blockMembers[] =
+{
+    { "globals.modelviewMatrix",           GL_FLOAT_MAT4,   0u, 64u },
+    { "globals.modelviewMatrixInverse",    GL_FLOAT_MAT4,  64u, 64u },
+    { "globals.projectionMatrix",          GL_FLOAT_MAT4, 128u, 64u },
+    { "globals.projectionMatrixInverse",   GL_FLOAT_MAT4, 192u, 64u },
+    { "globals.normalMatrix",              GL_FLOAT_MAT3, 256u, 48u },
+    { "globals.normalMatrixInverse",       GL_FLOAT_MAT3, 304u, 48u },
+    { "globals.viewport",                  GL_INT_VEC4,   352u, 16u },
+    { "globals.light[0].direction",        GL_FLOAT_VEC3, 368u, 12u },
+    { "globals.light[0].glossiness",       GL_FLOAT,      380u,  4u },
+    { "globals.defaultColor",              GL_FLOAT_VEC3, 384u, 12u }
+};
+
+const GLint  blockMemberCount = sizeof(blockMembers) / sizeof(blockMembers[0]);
+const GLuint blockSize        = 400u;
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+GlobalUniformBlock::GlobalUniformBlock() :
+    m_mask(0u),
+    m_dirty(false),
+    m_composedGeneration(0u),
+    m_composedBase(nullptr),
+    m_composedBaseGeneration(0u),
+    m_buffer(0u)
+{
+}
+
+// -------------------------------------------------------------------------
+
+GlobalUniformBlock::GlobalUniformBlock(const GlobalUniformBlock& other) :
+    m_values(other.m_values),
+    m_mask(other.m_mask),
+    m_dirty(true),
+    m_composedGeneration(0u),
+    m_composedBase(nullptr),
+    m_composedBaseGeneration(0u),
+    m_buffer(0u)
+{
+    // the uniform buffer is not shared, a copy creates its own on update()
+}
+
+// -------------------------------------------------------------------------
+
+GlobalUniformBlock::~GlobalUniformBlock()
+{
+    if (m_buffer != 0u)
+    {
+        GLState::getInstance().deleteBuffers(1, &m_buffer);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+GlobalUniformBlock& GlobalUniformBlock::operator=(const GlobalUniformBlock& other)
+{
+    if (this != &other)
+    {
+        m_values = other.m_values;
+        m_mask   = other.m_mask;
+        m_dirty  = true;
+    }
+
+    return *this;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Looks up a uniform name in the block layout.
+ * @param name Full uniform name, e.g. "globals.modelviewMatrix".
+ * @return Index of the block member or -1 if the name is not part of the block.
+ */
+GLint GlobalUniformBlock::findMember(const std::string& name)
+{
+    if (name.compare(0, 8, "globals.") != 0)
+        return -1;
+
+    for (GLint member = 0; member < blockMemberCount; ++member)
+        if (name == blockMembers[member].name)
+            return member;
+
+    return -1;
+}
+
+// -------------------------------------------------------------------------
+
+void GlobalUniformBlock::set(GLint member, GLenum type, GLsizei size, const GLvoid* data)
+{
+    const BlockMember& m = blockMembers[member];
+
+    if (type != m.type || size != 1)
+    {
+        std::cerr << "Uniform " << m.name << " does not match the type of the globals block" << std::endl;
+        return;
+    }
+
+    if (m_values.empty())
+        m_values.assign(blockSize, 0u);
+
+    GLubyte* target = &m_values[m.offset];
+    GLubyte  converted[48];
+
+    if (type == GL_FLOAT_MAT3)
+    {
+        // std140 stores each column of a mat3 with a stride of a vec4
+        std::memset(converted, 0, sizeof(converted));
+        for (unsigned int column = 0u; column < 3u; ++column)
+            std::memcpy(converted + 16u * column,
+                        (const GLubyte*) data + 3u * sizeof(GLfloat) * column,
+                        3u * sizeof(GLfloat));
+        data = converted;
+    }
+
+    // only touch the uniform buffer if the value actually changed
+    if ((m_mask & (1u << member)) && std::memcmp(target, data, m.bytes) == 0)
+        return;
+
+    std::memcpy(target, data, m.bytes);
+    m_mask |= (1u << member);
+    m_dirty = true;
+}
+
+// -------------------------------------------------------------------------
+
+void GlobalUniformBlock::clear(GLint member)
+{
+    if (m_mask & (1u << member))
+    {
+        m_mask &= ~(1u << member);
+        m_dirty = true;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void GlobalUniformBlock::clear()
+{
+    if (m_mask != 0u)
+    {
+        m_mask  = 0u;
+        m_dirty = true;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Merges the members of this block over the base block and uploads
+ * the result if anything changed since the last update.
+ * @param base Block of the parent UniformSet, already updated (may be null).
+ */
+void GlobalUniformBlock::update(const GlobalUniformBlock* base) const
+{
+    const unsigned long baseGeneration = base ? base->m_composedGeneration : 0u;
+
+    if (!m_dirty && m_buffer != 0u &&
+        base == m_composedBase && baseGeneration == m_composedBaseGeneration)
+        return;
+
+    // compose: values from the base, overridden by the members set here
+    if (base)
+        m_composed = base->m_composed;
+    else
+        m_composed.assign(blockSize, 0u);
+
+    for (GLint member = 0; member < blockMemberCount; ++member)
+    {
+        if (m_mask & (1u << member))
+        {
+            const BlockMember& m = blockMembers[member];
+            std::memcpy(&m_composed[m.offset], &m_values[m.offset], m.bytes);
+        }
+    }
+
+    // upload
+    if (m_buffer == 0u)
+    {
+        glGenBuffers(1, &m_buffer);
+        GLState::getInstance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, blockSize, m_composed.data(), GL_DYNAMIC_DRAW);
+    }
+    else
+    {
+        GLState::getInstance().bindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, blockSize, m_composed.data());
+    }
+
+    // the buffer stays bound, so that bind() finds it bound to the generic
+    // target and GLState can skip the glBindBufferBase
+
+    m_dirty                  = false;
+    m_composedBase           = base;
+    m_composedBaseGeneration = baseGeneration;
+    ++m_composedGeneration;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Binds the uniform buffer to the shared binding point (only if it is
+ * not bound already, see GLState).
+ */
+void GlobalUniformBlock::bind() const
+{
+    GLState::getInstance().bindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, m_buffer);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Assigns the `Globals` block of a linked program to the shared
+ * binding point.
+ * @param program
+ */
+void GlobalUniformBlock::bindProgram(GLuint program)
+{
+    const GLuint blockIndex = glGetUniformBlockIndex(program, "Globals");
+
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, blockIndex, BINDING_POINT);
+}
+
+} // namespace ugl
@@ -0,0 +1,292 @@
+/** @file InstancedMeshDrawable.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/InstancedMeshDrawable.hpp"
+#include "ugl/GLState.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace ugl
+{
+
+namespace
+{
+
+// attribute locations following those of MeshDrawable (0 and 1);
+// the transform occupies one location per column
+const GLuint instanceTransformLocation = 2u;
+const GLuint instanceColorLocation     = 6u;
+const GLuint instanceScalarLocation    = 7u;
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+InstancedMeshDrawable::InstancedMeshDrawable( MeshData& data, const MeshVertexFormat& format ) :
+    MeshDrawable( data, format ),
+    m_instanceBuffer( 0u ),
+    m_instanceCapacity( 0 ),
+    m_dirtyFirst( 0 ),
+    m_dirtyLast( 0 ),
+    m_instanceBoundsValid( false )
+{
+    m_program.addAttributeLocation( "instanceTransform", instanceTransformLocation );
+    m_program.addAttributeLocation( "instanceColor",     instanceColorLocation );
+    m_program.addAttributeLocation( "instanceScalar",    instanceScalarLocation );
+
+    m_stateSet.getOrCreateModes().set( "INSTANCED", 1 );
+
+    prepareInstanceAttributes();
+}
+
+// -------------------------------------------------------------------------
+
+InstancedMeshDrawable::~InstancedMeshDrawable()
+{
+    GLState::getInstance().deleteBuffers( 1, &m_instanceBuffer );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Adds the per-instance attributes to the vertex array of the mesh.
+ */
+void InstancedMeshDrawable::prepareInstanceAttributes()
+{
+    glGenBuffers( 1, &m_instanceBuffer );
+
+    GLState::getInstance().bindVertexArray( m_vertexArray );
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_instanceBuffer );
+
+    const GLsizei stride = sizeof(MeshInstance);
+
+    for( GLuint column = 0u; column < 4u; ++column )
+    {
+        const GLuint location = instanceTransformLocation + column;
+        glVertexAttribPointer( location, 4, GL_FLOAT, GL_FALSE, stride,
+                               (const GLvoid*) (offsetof(MeshInstance, transform) + column * sizeof(glm::vec4)) );
+        glVertexAttribDivisor( location, 1u );
+        glEnableVertexAttribArray( location );
+    }
+
+    glVertexAttribPointer( instanceColorLocation, 4, GL_FLOAT, GL_FALSE, stride,
+                           (const GLvoid*) offsetof(MeshInstance, color) );
+    glVertexAttribDivisor( instanceColorLocation, 1u );
+    glEnableVertexAttribArray( instanceColorLocation );
+
+    glVertexAttribPointer( instanceScalarLocation, 1, GL_FLOAT, GL_FALSE, stride,
+                           (const GLvoid*) offsetof(MeshInstance, scalar) );
+    glVertexAttribDivisor( instanceScalarLocation, 1u );
+    glEnableVertexAttribArray( instanceScalarLocation );
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
+    GLState::getInstance().bindVertexArray( 0u );
+}
+
+// -------------------------------------------------------------------------
+
+GLsizei InstancedMeshDrawable::addInstance( const MeshInstance& instance )
+{
+    m_instances.push_back( instance );
+
+    const GLsizei index = m_instances.size() - 1;
+    markDirty( index, 1 );
+
+    return index;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Overwrites count instances starting at first, appending if the range
+ * extends past the current end.
+ */
+void InstancedMeshDrawable::setInstances( GLsizei first, GLsizei count,
+                                          const MeshInstance* instances )
+{
+    if( (size_t) (first + count) > m_instances.size() )
+        m_instances.resize( first + count );
+
+    std::copy( instances, instances + count, m_instances.begin() + first );
+    markDirty( first, count );
+}
+
+// -------------------------------------------------------------------------
+
+void InstancedMeshDrawable::setInstances( const std::vector<MeshInstance>& instances )
+{
+    m_instances = instances;
+    markDirty( 0, m_instances.size() );
+}
+
+// -------------------------------------------------------------------------
+
+void InstancedMeshDrawable::clearInstances()
+{
+    m_instances.clear();
+    m_dirtyFirst = m_dirtyLast = 0;
+    m_instanceBoundsValid = false;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Maps the instance scalars to a color ramp instead of using the
+ * instance colors (alpha is still taken from the instance color).
+ */
+void InstancedMeshDrawable::setColorByScalar( bool enabled, float scalarsMin, float scalarsMax,
+                                              const glm::vec3& minColor, const glm::vec3& maxColor )
+{
+    m_stateSet.getOrCreateModes().setOrClear( "INSTANCE_SCALAR", enabled );
+
+    if( enabled )
+    {
+        UniformSet& uniforms = m_stateSet.getOrCreateUniforms();
+        uniforms.set( "scalarsMin", scalarsMin );
+        uniforms.set( "scalarsMax", scalarsMax );
+        uniforms.set( "minColor",   minColor );
+        uniforms.set( "maxColor",   maxColor );
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void InstancedMeshDrawable::markDirty( GLsizei first, GLsizei count )
+{
+    if( m_dirtyFirst >= m_dirtyLast )
+    {
+        m_dirtyFirst = first;
+        m_dirtyLast  = first + count;
+    }
+    else
+    {
+        m_dirtyFirst = std::min( m_dirtyFirst, first );
+        m_dirtyLast  = std::max( m_dirtyLast, first + count );
+    }
+
+    m_instanceBoundsValid = false;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Uploads the dirty range of instances, reallocating the buffer with
+ * twice the required size if it is too small.
+ */
+void InstancedMeshDrawable::uploadInstances()
+{
+    const GLsizei count = m_instances.size();
+
+    if( count > m_instanceCapacity )
+    {
+        m_instanceCapacity = std::max( 2 * count, 64 );
+
+        GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_instanceBuffer );
+        glBufferData( GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(MeshInstance),
+                      nullptr, GL_DYNAMIC_DRAW );
+        glBufferSubData( GL_ARRAY_BUFFER, 0, count * sizeof(MeshInstance), m_instances.data() );
+        GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
+    }
+    else if( m_dirtyFirst < m_dirtyLast )
+    {
+        const GLsizei last = std::min( m_dirtyLast, count );
+
+        GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, m_instanceBuffer );
+        glBufferSubData( GL_ARRAY_BUFFER, m_dirtyFirst * sizeof(MeshInstance),
+                         (last - m_dirtyFirst) * sizeof(MeshInstance),
+                         &m_instances[m_dirtyFirst] );
+        GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
+    }
+
+    m_dirtyFirst = m_dirtyLast = 0;
+    m_instanceCount = count;
+}
+
+// -------------------------------------------------------------------------
+
+void InstancedMeshDrawable::draw( const StateSet& state )
+{
+    uploadInstances();
+
+    if( m_instanceCount > 0 )
+        MeshDrawable::draw( state );
+}
+
+// -------------------------------------------------------------------------
+
+bool InstancedMeshDrawable::record( const StateSet& state, RenderQueue& queue )
+{
+    uploadInstances();
+
+    if( m_instanceCount > 0 )
+        MeshDrawable::record( state, queue );
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Applies the changes of data like MeshDrawable::update(); the mesh
+ * bounding box may change, so the instance bounds are recomputed.
+ */
+void InstancedMeshDrawable::update( MeshData& data )
+{
+    MeshDrawable::update( data );
+
+    m_instanceBoundsValid = false;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the union of the mesh bounding box transformed by each
+ * instance (computed lazily after changes).
+ */
+BoundingBox InstancedMeshDrawable::getBoundingBox() const
+{
+    if( m_instanceBoundsValid )
+        return m_instanceBounds;
+
+    m_instanceBounds = BoundingBox();
+
+    const glm::vec3& min = m_boundingBox.getMin();
+    const glm::vec3& max = m_boundingBox.getMax();
+
+    for( std::vector<MeshInstance>::const_iterator instance = m_instances.begin();
+         instance != m_instances.end(); ++instance )
+    {
+        for( int corner = 0; corner < 8; ++corner )
+        {
+            const glm::vec4 p( corner & 1 ? max.x : min.x,
+                               corner & 2 ? max.y : min.y,
+                               corner & 4 ? max.z : min.z, 1.0f );
+            m_instanceBounds.add( glm::vec3( instance->transform * p ) );
+        }
+    }
+
+    m_instanceBoundsValid = true;
+
+    return m_instanceBounds;
+}
+
+} // namespace ugl
@@ -0,0 +1,438 @@
+/** @file MeshBatchDrawable.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/MeshBatchDrawable.hpp"
+#include "ugl/GLState.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace ugl
+{
+
+const GLuint MeshBatchDrawable::PARAMETER_BINDING;
+
+// -------------------------------------------------------------------------
+
+MeshBatchDrawable::MeshBatchDrawable() :
+    m_vertexPositionBuffer( 0u ),
+    m_vertexNormalBuffer( 0u ),
+    m_drawIdBuffer( 0u ),
+    m_indexBuffer( 0u ),
+    m_parameterBuffer( 0u ),
+    m_commandBuffer( 0u ),
+    m_geometryDirty( false ),
+    m_parametersFirst( 0 ),
+    m_parametersLast( 0 ),
+    m_commandsFirst( 0 ),
+    m_commandsLast( 0 ),
+    m_boundingBoxValid( false ),
+    m_drawSurface( true ),
+    m_drawEdges( false )
+{
+    prepareShaderProgram();
+
+    glGenVertexArrays( 1, &m_vertexArray );
+    glGenBuffers( 1, &m_vertexPositionBuffer );
+    glGenBuffers( 1, &m_vertexNormalBuffer );
+    glGenBuffers( 1, &m_drawIdBuffer );
+    glGenBuffers( 1, &m_indexBuffer );
+    glGenBuffers( 1, &m_parameterBuffer );
+    glGenBuffers( 1, &m_commandBuffer );
+
+    GLState& state = GLState::getInstance();
+    state.bindVertexArray( m_vertexArray );
+
+    state.bindBuffer( GL_ARRAY_BUFFER, m_vertexPositionBuffer );
+    glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+    glEnableVertexAttribArray( 0u );
+
+    state.bindBuffer( GL_ARRAY_BUFFER, m_vertexNormalBuffer );
+    glVertexAttribPointer( 1u, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+    glEnableVertexAttribArray( 1u );
+
+    // draw id fallback: one integer per mesh, fetched at the base instance
+    state.bindBuffer( GL_ARRAY_BUFFER, m_drawIdBuffer );
+    glVertexAttribIPointer( 2u, 1, GL_INT, 0, nullptr );
+    glVertexAttribDivisor( 2u, 1u );
+    glEnableVertexAttribArray( 2u );
+
+    state.bindBuffer( GL_ARRAY_BUFFER, 0u );
+
+    // the element buffer binding is stored in the vertex array
+    state.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer );
+
+    state.bindVertexArray( 0u );
+}
+
+// -------------------------------------------------------------------------
+
+MeshBatchDrawable::~MeshBatchDrawable()
+{
+    const GLuint buffers[] = { m_vertexPositionBuffer, m_vertexNormalBuffer, m_drawIdBuffer,
+                               m_indexBuffer, m_parameterBuffer, m_commandBuffer };
+
+    GLState::getInstance().deleteBuffers( 6, buffers );
+    GLState::getInstance().deleteVertexArrays( 1, &m_vertexArray );
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::prepareShaderProgram()
+{
+    m_program.addImportPath( "shader" );
+    m_program.addShaderFromSourceFile( COMBINED, "ugl/mesh_batch.glsl" );
+
+    m_program.addAttributeLocation( "vertexPosition", 0u );
+    m_program.addAttributeLocation( "vertexNormal",   1u );
+    m_program.addAttributeLocation( "batchDrawId",    2u );
+
+    if( GLEW_ARB_shader_draw_parameters )
+        m_stateSet.getOrCreateModes().set( "BATCH_DRAW_ID", 1 );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Appends a mesh to the batch.
+ * @return Index of the mesh, used to change its parameters and visibility.
+ */
+GLsizei MeshBatchDrawable::addMesh( MeshData& data, const glm::mat4& modelMatrix )
+{
+    MeshRange range;
+    range.firstVertex        = m_points.size();
+    range.firstTriangleIndex = m_triangleIndices.size();
+    range.triangleIndexCount = data.getTriangleCount() * 3;
+    range.firstEdgeIndex     = m_edgeIndices.size();
+    range.edgeIndexCount     = data.getEdgeCount() * 2;
+    range.boundingBox        = data.getBoundingBox();
+    range.visible            = true;
+
+    // indices stay local to the mesh, the commands add baseVertex
+    m_points.insert( m_points.end(), data.getPoints().begin(), data.getPoints().end() );
+    m_normals.insert( m_normals.end(), data.getVertexNormals().begin(), data.getVertexNormals().end() );
+
+    const std::vector<glm::uvec3>& triangles = data.getTriangles();
+    for( std::vector<glm::uvec3>::const_iterator t = triangles.begin(); t != triangles.end(); ++t )
+    {
+        m_triangleIndices.push_back( t->x );
+        m_triangleIndices.push_back( t->y );
+        m_triangleIndices.push_back( t->z );
+    }
+
+    const std::vector<glm::uvec2>& edges = data.getEdges();
+    for( std::vector<glm::uvec2>::const_iterator e = edges.begin(); e != edges.end(); ++e )
+    {
+        m_edgeIndices.push_back( e->x );
+        m_edgeIndices.push_back( e->y );
+    }
+
+    MeshBatchParameters parameters;
+    parameters.modelMatrix = modelMatrix;
+    parameters.color       = glm::vec4( 1.0f );
+    parameters.alpha       = 1.0f;
+    parameters.padding[0]  = parameters.padding[1] = parameters.padding[2] = 0.0f;
+
+    m_meshes.push_back( range );
+    m_parameters.push_back( parameters );
+
+    m_geometryDirty    = true;
+    m_boundingBoxValid = false;
+
+    return m_meshes.size() - 1;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::setModelMatrix( GLsizei mesh, const glm::mat4& modelMatrix )
+{
+    m_parameters[mesh].modelMatrix = modelMatrix;
+    markParameters( mesh );
+
+    m_boundingBoxValid = false;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::setColor( GLsizei mesh, const glm::vec3& color )
+{
+    m_parameters[mesh].color = glm::vec4( color, 1.0f );
+    markParameters( mesh );
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::setAlpha( GLsizei mesh, float alpha )
+{
+    m_parameters[mesh].alpha = alpha;
+    markParameters( mesh );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Shows or hides a single mesh by setting the instance count of its
+ * draw commands to 1 or 0.
+ */
+void MeshBatchDrawable::setMeshVisible( GLsizei mesh, bool visible )
+{
+    if( m_meshes[mesh].visible == visible )
+        return;
+
+    m_meshes[mesh].visible = visible;
+    markCommands( mesh );
+
+    m_boundingBoxValid = false;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::markParameters( GLsizei mesh )
+{
+    if( m_parametersFirst >= m_parametersLast )
+    {
+        m_parametersFirst = mesh;
+        m_parametersLast  = mesh + 1;
+    }
+    else
+    {
+        m_parametersFirst = std::min( m_parametersFirst, mesh );
+        m_parametersLast  = std::max( m_parametersLast, mesh + 1 );
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::markCommands( GLsizei mesh )
+{
+    if( m_commandsFirst >= m_commandsLast )
+    {
+        m_commandsFirst = mesh;
+        m_commandsLast  = mesh + 1;
+    }
+    else
+    {
+        m_commandsFirst = std::min( m_commandsFirst, mesh );
+        m_commandsLast  = std::max( m_commandsLast, mesh + 1 );
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Reallocates all shared buffers after meshes were added.
+ */
+void MeshBatchDrawable::uploadGeometry()
+{
+    GLState& state = GLState::getInstance();
+    const GLsizei meshCount = m_meshes.size();
+
+    state.bindBuffer( GL_ARRAY_BUFFER, m_vertexPositionBuffer );
+    glBufferData( GL_ARRAY_BUFFER, m_points.size() * sizeof(glm::vec3),
+                  m_points.data(), GL_STATIC_DRAW );
+
+    state.bindBuffer( GL_ARRAY_BUFFER, m_vertexNormalBuffer );
+    glBufferData( GL_ARRAY_BUFFER, m_normals.size() * sizeof(glm::vec3),
+                  m_normals.data(), GL_STATIC_DRAW );
+
+    std::vector<GLint> drawIds( meshCount );
+    for( GLsizei mesh = 0; mesh < meshCount; ++mesh )
+        drawIds[mesh] = mesh;
+
+    state.bindBuffer( GL_ARRAY_BUFFER, m_drawIdBuffer );
+    glBufferData( GL_ARRAY_BUFFER, drawIds.size() * sizeof(GLint),
+                  drawIds.data(), GL_STATIC_DRAW );
+    state.bindBuffer( GL_ARRAY_BUFFER, 0u );
+
+    // triangle indices first, edge indices behind them
+    const size_t triangleBytes = m_triangleIndices.size() * sizeof(GLuint);
+    const size_t edgeBytes     = m_edgeIndices.size() * sizeof(GLuint);
+
+    state.bindVertexArray( m_vertexArray );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, triangleBytes + edgeBytes, nullptr, GL_STATIC_DRAW );
+    glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, triangleBytes, m_triangleIndices.data() );
+    glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, triangleBytes, edgeBytes, m_edgeIndices.data() );
+    state.bindVertexArray( 0u );
+
+    state.bindBuffer( GL_SHADER_STORAGE_BUFFER, m_parameterBuffer );
+    glBufferData( GL_SHADER_STORAGE_BUFFER, meshCount * sizeof(MeshBatchParameters),
+                  nullptr, GL_DYNAMIC_DRAW );
+    state.bindBuffer( GL_SHADER_STORAGE_BUFFER, 0u );
+
+    state.bindBuffer( GL_DRAW_INDIRECT_BUFFER, m_commandBuffer );
+    glBufferData( GL_DRAW_INDIRECT_BUFFER, 2 * meshCount * sizeof(DrawCommand),
+                  nullptr, GL_DYNAMIC_DRAW );
+    state.bindBuffer( GL_DRAW_INDIRECT_BUFFER, 0u );
+
+    // the new buffers hold no parameters and commands yet
+    m_parametersFirst = m_commandsFirst = 0;
+    m_parametersLast  = m_commandsLast  = meshCount;
+    m_geometryDirty   = false;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::uploadParameters()
+{
+    if( m_parametersFirst >= m_parametersLast )
+        return;
+
+    GLState::getInstance().bindBuffer( GL_SHADER_STORAGE_BUFFER, m_parameterBuffer );
+    glBufferSubData( GL_SHADER_STORAGE_BUFFER,
+                     m_parametersFirst * sizeof(MeshBatchParameters),
+                     (m_parametersLast - m_parametersFirst) * sizeof(MeshBatchParameters),
+                     &m_parameters[m_parametersFirst] );
+    GLState::getInstance().bindBuffer( GL_SHADER_STORAGE_BUFFER, 0u );
+
+    m_parametersFirst = m_parametersLast = 0;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Rewrites the surface and edge commands of the dirty meshes.
+ */
+void MeshBatchDrawable::uploadCommands()
+{
+    if( m_commandsFirst >= m_commandsLast )
+        return;
+
+    const GLsizei meshCount = m_meshes.size();
+    const GLsizei count     = m_commandsLast - m_commandsFirst;
+    const GLuint  edgeBase  = m_triangleIndices.size();
+
+    std::vector<DrawCommand> surface( count ), edges( count );
+
+    for( GLsizei i = 0; i < count; ++i )
+    {
+        const GLsizei    mesh  = m_commandsFirst + i;
+        const MeshRange& range = m_meshes[mesh];
+
+        surface[i].count         = range.triangleIndexCount;
+        surface[i].instanceCount = range.visible ? 1u : 0u;
+        surface[i].firstIndex    = range.firstTriangleIndex;
+        surface[i].baseVertex    = range.firstVertex;
+        surface[i].baseInstance  = mesh;
+
+        edges[i]            = surface[i];
+        edges[i].count      = range.edgeIndexCount;
+        edges[i].firstIndex = edgeBase + range.firstEdgeIndex;
+    }
+
+    GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, m_commandBuffer );
+    glBufferSubData( GL_DRAW_INDIRECT_BUFFER, m_commandsFirst * sizeof(DrawCommand),
+                     count * sizeof(DrawCommand), surface.data() );
+    glBufferSubData( GL_DRAW_INDIRECT_BUFFER, (meshCount + m_commandsFirst) * sizeof(DrawCommand),
+                     count * sizeof(DrawCommand), edges.data() );
+    GLState::getInstance().bindBuffer( GL_DRAW_INDIRECT_BUFFER, 0u );
+
+    m_commandsFirst = m_commandsLast = 0;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshBatchDrawable::draw( const StateSet& state )
+{
+    if( m_meshes.empty() )
+        return;
+
+    if( !GLEW_VERSION_4_3 )
+    {
+        static bool reported = false;
+        if( !reported )
+            std::cerr << "MeshBatchDrawable requires OpenGL 4.3" << std::endl;
+        reported = true;
+        return;
+    }
+
+    if( m_geometryDirty )
+        uploadGeometry();
+
+    uploadParameters();
+    uploadCommands();
+
+    m_stateSet.setParent( state );
+    ModeSet& modes = m_stateSet.getOrCreateModes();
+
+    const GLsizei meshCount = m_meshes.size();
+
+    GLState& glState = GLState::getInstance();
+    glState.bindVertexArray( m_vertexArray );
+    glState.bindBufferBase( GL_SHADER_STORAGE_BUFFER, PARAMETER_BINDING, m_parameterBuffer );
+    glState.bindBuffer( GL_DRAW_INDIRECT_BUFFER, m_commandBuffer );
+
+    if( m_drawSurface )
+    {
+        modes.clear( "LINE_MODE" );
+        m_stateSet.apply( m_program );
+
+        glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, meshCount, 0 );
+    }
+
+    if( m_drawEdges )
+    {
+        modes.set( "LINE_MODE", 1 );
+        m_stateSet.apply( m_program );
+
+        glMultiDrawElementsIndirect( GL_LINES, GL_UNSIGNED_INT,
+                                     (const GLvoid*) (meshCount * sizeof(DrawCommand)), meshCount, 0 );
+    }
+
+    glState.bindBuffer( GL_DRAW_INDIRECT_BUFFER, 0u );
+    glState.bindVertexArray( 0u );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the union of the transformed bounding boxes of the visible
+ * meshes.
+ */
+BoundingBox MeshBatchDrawable::getBoundingBox() const
+{
+    if( m_boundingBoxValid )
+        return m_boundingBox;
+
+    m_boundingBox = BoundingBox();
+
+    for( size_t mesh = 0; mesh < m_meshes.size(); ++mesh )
+    {
+        if( !m_meshes[mesh].visible )
+            continue;
+
+        const glm::vec3& min = m_meshes[mesh].boundingBox.getMin();
+        const glm::vec3& max = m_meshes[mesh].boundingBox.getMax();
+
+        for( int corner = 0; corner < 8; ++corner )
+        {
+            const glm::vec4 p( corner & 1 ? max.x : min.x,
+                               corner & 2 ? max.y : min.y,
+                               corner & 4 ? max.z : min.z, 1.0f );
+            m_boundingBox.add( glm::vec3( m_parameters[mesh].modelMatrix * p ) );
+        }
+    }
+
+    m_boundingBoxValid = true;
+
+    return m_boundingBox;
+}
+
+} // namespace ugl
@@ -20,73 +20,338 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/MeshData.hpp"
+#include "ugl/Parallel.hpp"
 
 #include <algorithm>
-#include <set>
+#include <cmath>
 #include <utility>
 
 namespace ugl
 {
 
-void MeshData::recomputeVertexNormals()
+namespace
+{
+
+/**
+ * @brief Sums up the (area weighted) normals of the given triangles in
+ * precision T and normalizes the sum; zero if degenerate.
+ */
+template <typename T>
+glm::vec3 sumTriangleNormals(const std::vector<glm::vec3>& points,
+                             const std::vector<glm::uvec3>& triangles,
+                             const GLuint* triangleId, const GLuint* triangleEnd)
 {
-    m_vertexNormals.assign(getPointCount(), glm::vec3(0.0f));
+    T n[3] = { T(0), T(0), T(0) };
 
-    for (GLint triangleId = 0; triangleId < getTriangleCount(); ++triangleId)
+    for (; triangleId != triangleEnd; ++triangleId)
     {
-        const glm::uvec3& triangle = getTriangle(triangleId);
+        const glm::uvec3& triangle = triangles[*triangleId];
 
-        const glm::vec3& p0 = getPoint(triangle[0u]);
-        const glm::vec3& p1 = getPoint(triangle[1u]);
-        const glm::vec3& p2 = getPoint(triangle[2u]);
+        const glm::vec3& p0 = points[triangle[0u]];
+        const glm::vec3& p1 = points[triangle[1u]];
+        const glm::vec3& p2 = points[triangle[2u]];
 
-        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const T e1[3] = { T(p1.x) - T(p0.x), T(p1.y) - T(p0.y), T(p1.z) - T(p0.z) };
+        const T e2[3] = { T(p2.x) - T(p0.x), T(p2.y) - T(p0.y), T(p2.z) - T(p0.z) };
 
-        m_vertexNormals[triangle[0u]] += normal;
-        m_vertexNormals[triangle[1u]] += normal;
-        m_vertexNormals[triangle[2u]] += normal;
+        n[0] += e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] += e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] += e1[0] * e2[1] - e1[1] * e2[0];
     }
 
-    for (size_t pointId = 0u; pointId < m_vertexNormals.size(); ++pointId)
+    const T length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+    if (length > T(0))
+        return glm::vec3(n[0] / length, n[1] / length, n[2] / length);
+
+    return glm::vec3(0.0f);
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+void MeshData::setPoints(GLint first, GLsizei count, const glm::vec3* points)
+{
+    std::copy(points, points + count, m_points.begin() + first);
+
+    // grow the bounding box, it may be larger than necessary until recomputed
+    if (m_boundingBoxValid)
+        for (GLsizei i = 0; i < count; ++i)
+            m_boundingBox.add(points[i]);
+
+    if (m_vertexNormalsValid)
+        for (GLsizei i = 0; i < count; ++i)
+            m_movedPoints.push_back(first + i);
+
+    markPointsDirty(first, first + count);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Recomputes all vertex normals in parallel, gathering the area
+ * weighted triangle normals around each point (in triangle order, so the
+ * result does not depend on the number of threads).
+ */
+void MeshData::recomputeVertexNormals()
+{
+    if (!m_pointTrianglesValid)
+        recomputePointTriangles();
+
+    m_vertexNormals.resize(getPointCount());
+
+    parallelFor(0u, getPointCount(), [this](size_t begin, size_t end)
     {
-        if (glm::length(m_vertexNormals[pointId]) > 0.0f)
-            m_vertexNormals[pointId] = glm::normalize(m_vertexNormals[pointId]);
-    }
+        for (size_t pointId = begin; pointId < end; ++pointId)
+            m_vertexNormals[pointId] = gatherVertexNormal(pointId);
+    });
 
     m_vertexNormalsValid = true;
+    m_movedPoints.clear();
 }
 
 // -------------------------------------------------------------------------
 
-void MeshData::recomputeEdges()
+/**
+ * @brief Recomputes the normals of all points sharing a triangle with a moved
+ * point, or all normals if many points moved.
+ */
+void MeshData::updateVertexNormals()
+{
+    if (m_movedPoints.size() > m_points.size() / 4u)
+    {
+        recomputeVertexNormals();
+        markPointsDirty(0, getPointCount());
+        return;
+    }
+
+    if (!m_pointTrianglesValid)
+        recomputePointTriangles();
+
+    std::vector<GLuint> affected;
+    for (std::vector<GLuint>::const_iterator pointId = m_movedPoints.begin(); pointId != m_movedPoints.end(); ++pointId)
+        for (GLuint i = m_pointTriangleOffsets[*pointId]; i < m_pointTriangleOffsets[*pointId + 1]; ++i)
+            for (int corner = 0; corner < 3; ++corner)
+                affected.push_back(m_triangles[m_pointTriangles[i]][corner]);
+
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for (std::vector<GLuint>::const_iterator pointId = affected.begin(); pointId != affected.end(); ++pointId)
+        m_vertexNormals[*pointId] = gatherVertexNormal(*pointId);
+
+    if (!affected.empty())
+        markPointsDirty(affected.front(), affected.back() + 1);
+
+    m_movedPoints.clear();
+}
+
+// -------------------------------------------------------------------------
+
+glm::vec3 MeshData::gatherVertexNormal(GLuint pointId) const
+{
+    if (m_pointTriangles.empty())
+        return glm::vec3(0.0f);
+
+    const GLuint* begin = &m_pointTriangles[0] + m_pointTriangleOffsets[pointId];
+    const GLuint* end   = &m_pointTriangles[0] + m_pointTriangleOffsets[pointId + 1];
+
+    if (m_doublePrecisionNormals)
+        return sumTriangleNormals<double>(m_points, m_triangles, begin, end);
+    else
+        return sumTriangleNormals<float>(m_points, m_triangles, begin, end);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Builds the triangles around each point as CSR arrays by radix
+ * sorting the (point, triangle) pairs of all corners in parallel.
+ */
+void MeshData::recomputePointTriangles()
+{
+    const size_t cornerCount = m_triangles.size() * 3;
+
+    std::vector<uint64_t> keys(cornerCount);
+    m_pointTriangles.resize(cornerCount);
+
+    parallelFor(0u, m_triangles.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t triangleId = begin; triangleId < end; ++triangleId)
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                keys[3 * triangleId + corner]             = m_triangles[triangleId][corner];
+                m_pointTriangles[3 * triangleId + corner] = triangleId;
+            }
+    });
+
+    // stable, so the triangles of each point stay in triangle order
+    parallelRadixSort(keys, m_pointTriangles);
+
+    // each run of equal points sets the offsets up to its point
+    m_pointTriangleOffsets.resize(getPointCount() + 1);
+
+    parallelFor(0u, cornerCount, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (i > 0u && keys[i] == keys[i - 1])
+                continue;
+
+            const uint64_t first = i > 0u ? keys[i - 1] + 1 : 0u;
+            for (uint64_t pointId = first; pointId <= keys[i]; ++pointId)
+                m_pointTriangleOffsets[pointId] = i;
+        }
+    });
+
+    const GLuint first = cornerCount > 0u ? keys.back() + 1 : 0u;
+    for (GLuint pointId = first; pointId <= (GLuint) getPointCount(); ++pointId)
+        m_pointTriangleOffsets[pointId] = cornerCount;
+
+    m_pointTrianglesValid = true;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Chains the boundary edges (edges with a single triangle) into loops,
+ * oriented like their triangles. At non-manifold boundary points a loop may
+ * end up open.
+ */
+void MeshData::recomputeBoundaryLoops()
 {
-    // first, count the edges emanating from each vertex
-    // (to avoid counting opposite edges twice, an edge is always taken
-    // to emanate from the vertex with the smaller index)
-    std::set< std::pair<GLuint, GLuint> > edgeSet;
+    if (!m_edgesValid)
+        recomputeEdges();
 
-    for (GLint triangleId = 0; triangleId < getTriangleCount(); ++triangleId)
+    // boundary edges, directed as in their triangle
+    std::vector< std::pair<GLuint, GLuint> > boundary;
+
+    for (size_t edgeId = 0u; edgeId < m_edges.size(); ++edgeId)
     {
-        const glm::uvec3& triangle = getTriangle(triangleId);
-        const GLuint i0 = triangle[0u], i1 = triangle[1u], i2 = triangle[2u];
-
-        // 1st edge: 0 -> 1
-        edgeSet.emplace(std::make_pair(std::min(i0, i1), std::max(i0, i1)));
-        // 2nd edge: 1 -> 2
-        edgeSet.emplace(std::make_pair(std::min(i1, i2), std::max(i1, i2)));
-        // 3rd edge: 2 -> 0
-        edgeSet.emplace(std::make_pair(std::min(i2, i0), std::max(i2, i0)));
+        const glm::uvec2& edge = m_edges[edgeId];
+
+        if (edge.x == edge.y || m_edgeTriangleOffsets[edgeId + 1] - m_edgeTriangleOffsets[edgeId] != 1u)
+            continue;
+
+        const glm::uvec3& triangle = m_triangles[m_edgeTriangles[m_edgeTriangleOffsets[edgeId]]];
+
+        bool forward = false;
+        for (int corner = 0; corner < 3; ++corner)
+            if (triangle[corner] == edge.x && triangle[(corner + 1) % 3] == edge.y)
+                forward = true;
+
+        boundary.push_back(forward ? std::make_pair(edge.x, edge.y) : std::make_pair(edge.y, edge.x));
     }
 
-    // copy edges from the set to a linear array
-    m_edges.clear();
-    m_edges.reserve(edgeSet.size());
-    for (std::set< std::pair<GLuint, GLuint> >::const_iterator edgePair = edgeSet.begin();
-            edgePair != edgeSet.end(); ++edgePair)
-        m_edges.emplace_back(glm::uvec2(edgePair->first, edgePair->second));
+    std::sort(boundary.begin(), boundary.end());
+    std::vector<bool> visited(boundary.size(), false);
+
+    m_boundaryLoops.clear();
+
+    for (size_t start = 0u; start < boundary.size(); ++start)
+    {
+        if (visited[start])
+            continue;
+
+        std::vector<GLuint> loop;
+        size_t current = start;
+
+        while (true)
+        {
+            visited[current] = true;
+            loop.push_back(boundary[current].first);
+
+            const GLuint next = boundary[current].second;
+            if (next == boundary[start].first)
+                break;
+
+            // first unvisited boundary edge leaving the next point
+            std::vector< std::pair<GLuint, GLuint> >::const_iterator candidate =
+                    std::lower_bound(boundary.begin(), boundary.end(), std::make_pair(next, 0u));
+
+            while (candidate != boundary.end() && candidate->first == next && visited[candidate - boundary.begin()])
+                ++candidate;
+
+            if (candidate == boundary.end() || candidate->first != next)
+            {
+                loop.push_back(next);
+                break;
+            }
+
+            current = candidate - boundary.begin();
+        }
 
+        m_boundaryLoops.push_back(loop);
+    }
+
+    m_boundaryLoopsValid = true;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshData::recomputeEdges()
+{
+    extractEdges(m_triangles, m_edges, &m_edgeTriangleOffsets, &m_edgeTriangles);
     m_edgesValid = true;
 }
 
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Extracts the unique edges of triangles, sorted by their (smaller,
+ * larger) point index pair.
+ *
+ * Each triangle side becomes a 64-bit key (smaller index in the upper half)
+ * tagged with its triangle; the keys are radix sorted in parallel and equal
+ * keys merged. Optionally returns the triangles adjacent to each edge as CSR
+ * arrays, in triangle order.
+ */
+void MeshData::extractEdges(const std::vector<glm::uvec3>& triangles,
+                            std::vector<glm::uvec2>& edges,
+                            std::vector<GLuint>* edgeTriangleOffsets,
+                            std::vector<GLuint>* edgeTriangles)
+{
+    std::vector<uint64_t> keys(triangles.size() * 3);
+    std::vector<uint32_t> triangleIds(triangles.size() * 3);
+
+    parallelFor(0u, triangles.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t triangleId = begin; triangleId < end; ++triangleId)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const GLuint i0 = triangles[triangleId][corner];
+                const GLuint i1 = triangles[triangleId][(corner + 1) % 3];
+
+                keys[3 * triangleId + corner]        = (uint64_t) std::min(i0, i1) << 32 | std::max(i0, i1);
+                triangleIds[3 * triangleId + corner] = triangleId;
+            }
+        }
+    });
+
+    parallelRadixSort(keys, triangleIds);
+
+    edges.clear();
+    if (edgeTriangleOffsets)
+        edgeTriangleOffsets->clear();
+
+    for (size_t i = 0u; i < keys.size(); ++i)
+    {
+        if (i > 0u && keys[i] == keys[i - 1])
+            continue;
+
+        edges.push_back(glm::uvec2(keys[i] >> 32, keys[i] & 0xffffffffu));
+
+        if (edgeTriangleOffsets)
+            edgeTriangleOffsets->push_back(i);
+    }
+
+    if (edgeTriangleOffsets)
+        edgeTriangleOffsets->push_back(keys.size());
+
+    if (edgeTriangles)
+        edgeTriangles->swap(triangleIds);
+}
 
 } // namespace ugl
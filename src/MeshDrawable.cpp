@@ -19,26 +19,97 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
     Author(s): C.Garth, T.Biedert
 */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <vector>
 
-#include "ugl/GLHelper.hpp"
+#include "ugl/Frustum.hpp"
+#include "ugl/GLState.hpp"
 #include "ugl/MeshDrawable.hpp"
+#include "ugl/Parallel.hpp"
+#include "ugl/RenderQueue.hpp"
 
 namespace ugl
 {
 
-MeshDrawable::MeshDrawable( MeshData& data) :
+namespace
+{
+
+/// converts a value in [-1,1] to a signed normalized integer with the given maximum
+GLint toSnorm( float value, float max )
+{
+    return (GLint) std::floor( glm::clamp( value, -1.0f, 1.0f ) * max + 0.5f );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Copies the indices, narrowing them to the element type T.
+ */
+template <typename T, typename Vector>
+std::vector<T> convertIndices( const std::vector<Vector>& primitives )
+{
+    const int components = sizeof(Vector) / sizeof(typename Vector::value_type);
+
+    std::vector<T> out;
+    out.reserve( primitives.size() * components );
+
+    for( typename std::vector<Vector>::const_iterator primitive = primitives.begin();
+         primitive != primitives.end(); ++primitive )
+        for( int i = 0; i < components; ++i )
+            out.push_back( (T) (*primitive)[i] );
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+/// spreads the lower 10 bits of value to every third bit
+uint64_t spreadBits( uint64_t value )
+{
+    value &= 0x3ffu;
+    value = ( value | value << 16 ) & 0x030000ffu;
+    value = ( value | value << 8 )  & 0x0300f00fu;
+    value = ( value | value << 4 )  & 0x030c30c3u;
+    value = ( value | value << 2 )  & 0x09249249u;
+    return value;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+MeshDrawable::MeshDrawable( MeshData& data, const MeshVertexFormat& format ) :
+    m_format( format ),
+    m_instanceCount( 0 ),
     m_boundingBox( data.getBoundingBox() ),
+    m_cullFrustum( false ),
+    m_cullBackfaces( false ),
     m_drawSurface( true ),
     m_drawEdges( false ),
     m_alpha( 1.0f )
 {
+    m_clusterStatistics = ClusterStatistics();
+
     prepareShaderProgram();
     prepareVertexArrays( data );
+
+    // everything was uploaded
+    data.clearDirty();
 }
 
+// -------------------------------------------------------------------------
 
+MeshDrawable::~MeshDrawable()
+{
+    BufferPool::getInstance().releaseAll( this );
+    GLState::getInstance().deleteVertexArrays( 1, &m_vertexArray );
+}
 
+// -------------------------------------------------------------------------
 
 /**
  * @brief Returns the addresses of the parameters which should be GUI controllable.
@@ -68,38 +139,621 @@ void MeshDrawable::prepareShaderProgram()
 
 // -------------------------------------------------------------------------
 
+/**
+ * @brief Chooses the index type and the interleaved layout and enables the
+ * shader decoding of quantized positions and octahedral normals.
+ */
+void MeshDrawable::prepareVertexFormat( MeshData& data )
+{
+    m_indexType = m_format.shortIndices
+                  && data.getPointCount() <= std::numeric_limits<GLushort>::max() + 1
+                  ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    m_vertexStride = m_format.interleaved ? getPositionSize() + getNormalSize() : 0;
+    m_normalOffset = m_format.interleaved ? getPositionSize() : 0;
+
+    ModeSet& modes = m_stateSet.getOrCreateModes();
+    modes.setOrClear( "QUANTIZED_POSITIONS", m_format.quantizePositions );
+    modes.setOrClear( "OCTAHEDRAL_NORMALS", m_format.normals == MeshVertexFormat::OCTAHEDRAL_NORMALS );
+
+    m_positionRange = m_boundingBox;
+
+    if( m_format.quantizePositions )
+    {
+        UniformSet& uniforms = m_stateSet.getOrCreateUniforms();
+        uniforms.set( "positionOffset", m_positionRange.getMin() );
+        uniforms.set( "positionScale", m_positionRange.getMax() - m_positionRange.getMin() );
+    }
+}
+
+// -------------------------------------------------------------------------
+
 void MeshDrawable::prepareVertexArrays( MeshData& data )
 {
+    uploadVertexData( data );
+
     // set up the vertex arrays and attribute bindings
     glGenVertexArrays( 1, &m_vertexArray );
-    glBindVertexArray( m_vertexArray );
+    bindVertexBuffers();
+}
 
-    // prepare vertex position buffer
-    m_vertexPositionBuffer = GLHelper::prepareStaticBuffer( data.getPoints() );
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexPositionBuffer );
-    glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
-    glEnableVertexAttribArray( 0u );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
+// -------------------------------------------------------------------------
 
-    // prepare vertex normal buffer
-    m_vertexNormalBuffer = GLHelper::prepareStaticBuffer( data.getVertexNormals() );
-    glBindBuffer( GL_ARRAY_BUFFER, m_vertexNormalBuffer );
-    glVertexAttribPointer( 1u, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
-    glEnableVertexAttribArray( 1u );
-    glBindBuffer( GL_ARRAY_BUFFER, 0u );
+/**
+ * @brief Encodes all vertices and indices and suballocates them from the pool.
+ */
+void MeshDrawable::uploadVertexData( MeshData& data )
+{
+    BufferPool& pool = BufferPool::getInstance();
+
+    prepareVertexFormat( data );
+
+    m_vertexCount = data.getPointCount();
+
+    // encode vertex data
+    std::vector<unsigned char> positions, normals;
+    encodeVertices( data, 0, m_vertexCount, positions, normals );
+
+    m_vertexPositionBuffer = pool.allocate( positions, this );
+    m_vertexNormalBuffer   = m_format.interleaved ? m_vertexPositionBuffer : pool.allocate( normals, this );
+
+    // suballocate index data
+    std::vector<glm::uvec3> triangles = data.getTriangles();
+    buildClusters( data, triangles );
+
+    if( m_indexType == GL_UNSIGNED_SHORT )
+        m_triangleBuffer = pool.allocate( convertIndices<GLushort>( triangles ), this );
+    else
+        m_triangleBuffer = pool.allocate( triangles, this );
 
-    // prepare triangle index buffer
-    m_triangleBuffer    = GLHelper::prepareStaticBuffer( data.getTriangles() );
     m_triangleCount     = data.getTriangleCount() * 3;
 
-    // prepare edge index buffer
-    m_edgeBuffer        = GLHelper::prepareStaticBuffer( data.getEdges() );
-    m_edgeCount         = data.getEdgeCount() * 2;
+    m_edgeBuffer        = BufferPool::INVALID_HANDLE;
+    m_edgeCount         = 0;
+
+    if( m_drawEdges )
+        uploadEdges( data.getEdges() );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Reorders the triangles along a Morton curve of their centroids and
+ * splits them into clusters of the format's cluster size. Each cluster is
+ * drawn in the original order of its triangles to preserve the vertex cache
+ * locality of optimized meshes.
+ */
+void MeshDrawable::buildClusters( MeshData& data, std::vector<glm::uvec3>& triangles )
+{
+    m_clusters.clear();
+    m_clusterTriangles.clear();
+    m_triangleClusters.clear();
+
+    const GLsizei clusterSize = m_format.clusterSize;
+    if( clusterSize <= 0 || (GLsizei) triangles.size() <= clusterSize )
+        return;
+
+    const std::vector<glm::vec3>& points = data.getPoints();
+
+    const glm::vec3 origin = m_boundingBox.getMin();
+    const glm::vec3 extent = glm::max( m_boundingBox.getMax() - origin, glm::vec3( 1e-20f ) );
+
+    std::vector<uint64_t> keys( triangles.size() );
+    m_clusterTriangles.resize( triangles.size() );
+
+    parallelFor( 0, triangles.size(), [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            const glm::uvec3& triangle = triangles[i];
+            const glm::vec3   centroid = ( points[triangle.x] + points[triangle.y] + points[triangle.z] ) / 3.0f;
+            const glm::vec3   cell     = glm::clamp( ( centroid - origin ) / extent, 0.0f, 1.0f ) * 1023.0f;
+
+            keys[i] = spreadBits( (uint64_t) cell.x )
+                    | spreadBits( (uint64_t) cell.y ) << 1
+                    | spreadBits( (uint64_t) cell.z ) << 2;
+            m_clusterTriangles[i] = i;
+        }
+    } );
+
+    parallelRadixSort( keys, m_clusterTriangles );
+
+    for( GLsizei first = 0; first < (GLsizei) triangles.size(); first += clusterSize )
+    {
+        Cluster cluster;
+        cluster.firstIndex = 3 * first;
+        cluster.indexCount = 3 * std::min<GLsizei>( clusterSize, triangles.size() - first );
+        m_clusters.push_back( cluster );
+    }
+
+    std::vector<glm::uvec3> sorted( triangles.size() );
+    m_triangleClusters.resize( triangles.size() );
+
+    parallelFor( 0, m_clusters.size(), [&]( size_t begin, size_t end )
+    {
+        for( size_t c = begin; c < end; ++c )
+        {
+            GLuint* ids = &m_clusterTriangles[m_clusters[c].firstIndex / 3];
+            std::sort( ids, ids + m_clusters[c].indexCount / 3 );
+
+            for( GLsizei i = 0; i < m_clusters[c].indexCount / 3; ++i )
+            {
+                sorted[m_clusters[c].firstIndex / 3 + i] = triangles[ids[i]];
+                m_triangleClusters[ids[i]] = c;
+            }
+        }
+    }, 64 );
+
+    triangles.swap( sorted );
+
+    computeClusterBounds( data );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Computes the bounding box and normal cone of each cluster from the
+ * current points.
+ */
+void MeshDrawable::computeClusterBounds( MeshData& data )
+{
+    std::vector<GLuint> clusterIds( m_clusters.size() );
+    for( size_t c = 0; c < clusterIds.size(); ++c )
+        clusterIds[c] = c;
+
+    computeClusterBounds( data, clusterIds );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Recomputes the bounds of the clusters with triangles at the points
+ * [first, last), found through the triangles of each point.
+ */
+void MeshDrawable::computeClusterBounds( MeshData& data, GLint first, GLint last )
+{
+    std::vector<bool>   dirty( m_clusters.size(), false );
+    std::vector<GLuint> clusterIds;
+
+    for( GLint pointId = first; pointId < last; ++pointId )
+    {
+        const GLuint* pointTriangles = data.getPointTriangles( pointId );
+
+        for( GLsizei i = 0; i < data.getPointTriangleCount( pointId ); ++i )
+        {
+            const GLuint c = m_triangleClusters[pointTriangles[i]];
+
+            if( !dirty[c] )
+            {
+                dirty[c] = true;
+                clusterIds.push_back( c );
+            }
+        }
+    }
+
+    computeClusterBounds( data, clusterIds );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Computes the bounding box and normal cone of the given clusters.
+ */
+void MeshDrawable::computeClusterBounds( MeshData& data, const std::vector<GLuint>& clusterIds )
+{
+    const std::vector<glm::vec3>&  points    = data.getPoints();
+    const std::vector<glm::uvec3>& triangles = data.getTriangles();
+
+    parallelFor( 0, clusterIds.size(), [&]( size_t begin, size_t end )
+    {
+        std::vector<glm::vec3> normals;
+
+        for( size_t c = begin; c < end; ++c )
+        {
+            Cluster& cluster = m_clusters[clusterIds[c]];
+            cluster.box = BoundingBox();
+
+            normals.clear();
+
+            const GLuint* ids = &m_clusterTriangles[cluster.firstIndex / 3];
+            glm::vec3 axis( 0.0f );
+
+            for( GLsizei i = 0; i < cluster.indexCount / 3; ++i )
+            {
+                const glm::uvec3& triangle = triangles[ids[i]];
+                const glm::vec3&  p0       = points[triangle.x];
+                const glm::vec3&  p1       = points[triangle.y];
+                const glm::vec3&  p2       = points[triangle.z];
+
+                cluster.box.add( p0 );
+                cluster.box.add( p1 );
+                cluster.box.add( p2 );
+
+                const glm::vec3 normal = glm::cross( p1 - p0, p2 - p0 );
+                const float     length = glm::length( normal );
+
+                if( length > 0.0f )
+                {
+                    normals.push_back( normal / length );
+                    axis += normals.back();
+                }
+            }
+
+            const float axisLength = glm::length( axis );
+            cluster.coneAxis   = axisLength > 0.0f ? axis / axisLength : glm::vec3( 0.0f, 0.0f, 1.0f );
+            cluster.coneCutoff = 2.0f;
+
+            if( axisLength == 0.0f )
+                continue;
+
+            float minDot = 1.0f;
+            for( std::vector<glm::vec3>::const_iterator normal = normals.begin(); normal != normals.end(); ++normal )
+                minDot = std::min( minDot, glm::dot( *normal, cluster.coneAxis ) );
+
+            // cones of 90 degrees and more face the camera from everywhere
+            if( minDot > 0.0f )
+                cluster.coneCutoff = std::sqrt( 1.0f - minDot * minDot );
+        }
+    }, 64 );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Collects the visible triangle ranges into m_rangeCounts and
+ * m_rangeOffsets, merging adjacent clusters.
+ * @return False if the view is unknown and everything has to be drawn.
+ */
+bool MeshDrawable::cullClusters( const StateSet& state )
+{
+    m_clusterStatistics.clusters       = m_clusters.size();
+    m_clusterStatistics.frustumCulled  = 0;
+    m_clusterStatistics.backfaceCulled = 0;
+    m_clusterStatistics.ranges         = 1;
+
+    Frustum   frustum;
+    glm::mat4 projection, modelview;
+
+    if( !frustum.setFromStateSet( state ) ||
+        !Frustum::getViewMatrices( state, &projection, &modelview ) )
+        return false;
+
+    // camera position (perspective) or view direction (orthographic) in object space
+    const glm::mat4 inverse     = glm::inverse( modelview );
+    const bool      perspective = projection[2][3] != 0.0f;
+    const glm::vec3 eye         = glm::vec3( inverse * glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+    const glm::vec3 direction   = glm::normalize( glm::vec3( inverse * glm::vec4( 0.0f, 0.0f, -1.0f, 0.0f ) ) );
+
+    const BufferPool& pool      = BufferPool::getInstance();
+    const GLintptr    base      = pool.get( m_triangleBuffer ).offset;
+    const GLsizei     indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+    m_rangeCounts.clear();
+    m_rangeOffsets.clear();
+
+    GLuint rangeEnd = ~0u;
+
+    for( std::vector<Cluster>::const_iterator cluster = m_clusters.begin(); cluster != m_clusters.end(); ++cluster )
+    {
+        if( m_cullFrustum && !frustum.intersects( cluster->box ) )
+        {
+            ++m_clusterStatistics.frustumCulled;
+            continue;
+        }
+
+        if( m_cullBackfaces && cluster->coneCutoff <= 1.0f )
+        {
+            const glm::vec3 center = 0.5f * ( cluster->box.getMin() + cluster->box.getMax() );
+            const float     radius = 0.5f * glm::length( cluster->box.getMax() - cluster->box.getMin() );
+
+            bool backfacing;
+            if( perspective )
+            {
+                const glm::vec3 view = center - eye;
+                backfacing = glm::dot( view, cluster->coneAxis ) >= cluster->coneCutoff * glm::length( view ) + radius;
+            }
+            else
+            {
+                backfacing = glm::dot( direction, cluster->coneAxis ) >= cluster->coneCutoff;
+            }
+
+            if( backfacing )
+            {
+                ++m_clusterStatistics.backfaceCulled;
+                continue;
+            }
+        }
+
+        if( cluster->firstIndex == rangeEnd )
+        {
+            m_rangeCounts.back() += cluster->indexCount;
+        }
+        else
+        {
+            m_rangeCounts.push_back( cluster->indexCount );
+            m_rangeOffsets.push_back( (const GLvoid*) ( base + cluster->firstIndex * indexSize ) );
+        }
+
+        rangeEnd = cluster->firstIndex + cluster->indexCount;
+    }
+
+    m_clusterStatistics.ranges = m_rangeCounts.size();
+
+    return true;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Turns the edges on or off; the edges of data are uploaded when they
+ * are first turned on (data must be the MeshData this drawable shows).
+ */
+void MeshDrawable::setDrawEdges( bool drawEdges, MeshData& data )
+{
+    m_drawEdges = drawEdges;
+
+    if( m_drawEdges && m_edgeBuffer == BufferPool::INVALID_HANDLE )
+        uploadEdges( data.getEdges() );
+}
+
+// -------------------------------------------------------------------------
+
+void MeshDrawable::uploadEdges( const std::vector<glm::uvec2>& edges )
+{
+    BufferPool& pool = BufferPool::getInstance();
+
+    if( m_indexType == GL_UNSIGNED_SHORT )
+        m_edgeBuffer = pool.allocate( convertIndices<GLushort>( edges ), this );
+    else
+        m_edgeBuffer = pool.allocate( edges, this );
+
+    m_edgeCount = edges.size() * 2;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Encodes the points [first, last) and their normals; if interleaved,
+ * all goes to positions.
+ */
+void MeshDrawable::encodeVertices( MeshData& data, GLint first, GLint last,
+                                   std::vector<unsigned char>& positions,
+                                   std::vector<unsigned char>& normals ) const
+{
+    const std::vector<glm::vec3>& points        = data.getPoints();
+    const std::vector<glm::vec3>& vertexNormals = data.getVertexNormals();
+
+    const GLsizei positionSize = getPositionSize();
+    const GLsizei normalSize   = getNormalSize();
+
+    if( m_format.interleaved )
+    {
+        positions.resize( (last - first) * m_vertexStride );
+
+        for( GLint i = first; i < last; ++i )
+        {
+            encodePosition( points[i],        &positions[(i - first) * m_vertexStride] );
+            encodeNormal(   vertexNormals[i], &positions[(i - first) * m_vertexStride + m_normalOffset] );
+        }
+    }
+    else
+    {
+        positions.resize( (last - first) * positionSize );
+        normals.resize( (last - first) * normalSize );
+
+        for( GLint i = first; i < last; ++i )
+        {
+            encodePosition( points[i],        &positions[(i - first) * positionSize] );
+            encodeNormal(   vertexNormals[i], &normals[(i - first) * normalSize] );
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Brings the GPU copy up to date with the changes tracked by data and
+ * clears them.
+ *
+ * Moved points only re-upload the dirty range of vertices (all vertices if
+ * quantized positions left the bounding box) and recompute the bounds of the
+ * clusters around them; topology changes rebuild all buffers. Edges which
+ * were turned on since the last upload are built from data.
+ */
+void MeshDrawable::update( MeshData& data )
+{
+    BufferPool& pool = BufferPool::getInstance();
+
+    const GLint first = data.getDirtyPointsFirst();
+    const GLint last  = data.getDirtyPointsLast();
+
+    if( data.isTopologyDirty() || data.getPointCount() != m_vertexCount )
+    {
+        m_boundingBox = data.getBoundingBox();
+
+        pool.releaseAll( this );
+        uploadVertexData( data );
+        bindVertexBuffers();
+    }
+    else if( first < last )
+    {
+        GLint uploadFirst = first, uploadLast = last;
+
+        m_boundingBox = data.getBoundingBox();
+
+        // quantized positions are relative to the range they were encoded for
+        if( m_format.quantizePositions && !m_positionRange.contains( m_boundingBox ) )
+        {
+            prepareVertexFormat( data );
+
+            uploadFirst = 0;
+            uploadLast  = m_vertexCount;
+        }
+
+        std::vector<unsigned char> positions, normals;
+        encodeVertices( data, uploadFirst, uploadLast, positions, normals );
+
+        if( m_format.interleaved )
+        {
+            pool.upload( m_vertexPositionBuffer, uploadFirst * m_vertexStride, positions.size(), positions.data() );
+        }
+        else
+        {
+            pool.upload( m_vertexPositionBuffer, uploadFirst * getPositionSize(), positions.size(), positions.data() );
+            pool.upload( m_vertexNormalBuffer,   uploadFirst * getNormalSize(),   normals.size(),   normals.data() );
+        }
+
+        if( !m_clusters.empty() )
+            computeClusterBounds( data, first, last );
+    }
+
+    // edges turned on through the tweakable parameters
+    if( m_drawEdges && m_edgeBuffer == BufferPool::INVALID_HANDLE )
+        uploadEdges( data.getEdges() );
+
+    data.clearDirty();
+}
+
+// -------------------------------------------------------------------------
+
+GLsizei MeshDrawable::getPositionSize() const
+{
+    // quantized positions are padded to 4 shorts for alignment
+    return m_format.quantizePositions ? 4 * sizeof(GLushort) : 3 * sizeof(GLfloat);
+}
+
+// -------------------------------------------------------------------------
+
+GLsizei MeshDrawable::getNormalSize() const
+{
+    return m_format.normals == MeshVertexFormat::FLOAT_NORMALS ? 3 * sizeof(GLfloat) : 4;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshDrawable::encodePosition( const glm::vec3& position, unsigned char* out ) const
+{
+    if( !m_format.quantizePositions )
+    {
+        std::memcpy( out, &position[0], 3 * sizeof(GLfloat) );
+        return;
+    }
+
+    const glm::vec3 extent = m_positionRange.getMax() - m_positionRange.getMin();
+
+    GLushort quantized[4] = { 0u, 0u, 0u, 0u };
+    for( int i = 0; i < 3; ++i )
+    {
+        const float t = extent[i] > 0.0f ? (position[i] - m_positionRange.getMin()[i]) / extent[i] : 0.0f;
+        quantized[i] = (GLushort) std::floor( glm::clamp( t, 0.0f, 1.0f ) * 65535.0f + 0.5f );
+    }
+
+    std::memcpy( out, quantized, sizeof(quantized) );
+}
+
+// -------------------------------------------------------------------------
+
+void MeshDrawable::encodeNormal( const glm::vec3& normal, unsigned char* out ) const
+{
+    switch( m_format.normals )
+    {
+    case MeshVertexFormat::FLOAT_NORMALS:
+        std::memcpy( out, &normal[0], 3 * sizeof(GLfloat) );
+        break;
+
+    case MeshVertexFormat::PACKED_NORMALS:
+    {
+        // w = 0 in the upper two bits
+        const GLuint packed = ( (GLuint) toSnorm( normal.x, 511.0f ) & 0x3ffu )
+                            | ( (GLuint) toSnorm( normal.y, 511.0f ) & 0x3ffu ) << 10
+                            | ( (GLuint) toSnorm( normal.z, 511.0f ) & 0x3ffu ) << 20;
+        std::memcpy( out, &packed, sizeof(packed) );
+        break;
+    }
+
+    case MeshVertexFormat::OCTAHEDRAL_NORMALS:
+    {
+        // project onto the octahedron and fold the lower hemisphere
+        const float l1 = std::abs( normal.x ) + std::abs( normal.y ) + std::abs( normal.z );
+        glm::vec2 e = l1 > 0.0f ? glm::vec2( normal.x, normal.y ) / l1 : glm::vec2( 0.0f );
+
+        if( normal.z < 0.0f )
+            e = ( 1.0f - glm::abs( glm::vec2( e.y, e.x ) ) )
+                * glm::vec2( e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f );
+
+        const GLshort encoded[2] = { (GLshort) toSnorm( e.x, 32767.0f ),
+                                     (GLshort) toSnorm( e.y, 32767.0f ) };
+        std::memcpy( out, encoded, sizeof(encoded) );
+        break;
+    }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Specifies the attribute pointers at the current offsets of the
+ * vertex data in the pool; repeated when the pool was compacted.
+ */
+void MeshDrawable::bindVertexBuffers()
+{
+    const BufferPool& pool = BufferPool::getInstance();
+
+    GLState::getInstance().bindVertexArray( m_vertexArray );
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, pool.get( m_vertexPositionBuffer ).buffer );
+    if( m_format.quantizePositions )
+        glVertexAttribPointer( 0u, 4, GL_UNSIGNED_SHORT, GL_TRUE, m_vertexStride,
+                               pool.getOffsetPointer( m_vertexPositionBuffer ) );
+    else
+        glVertexAttribPointer( 0u, 3, GL_FLOAT, GL_FALSE, m_vertexStride,
+                               pool.getOffsetPointer( m_vertexPositionBuffer ) );
+    glEnableVertexAttribArray( 0u );
+
+    // the shader reads xyz of packed normals and decodes xy of octahedral ones
+    const GLvoid* normalPointer = (const GLvoid*) ( pool.get( m_vertexNormalBuffer ).offset + m_normalOffset );
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, pool.get( m_vertexNormalBuffer ).buffer );
+    switch( m_format.normals )
+    {
+    case MeshVertexFormat::FLOAT_NORMALS:
+        glVertexAttribPointer( 1u, 3, GL_FLOAT, GL_FALSE, m_vertexStride, normalPointer );
+        break;
+    case MeshVertexFormat::PACKED_NORMALS:
+        glVertexAttribPointer( 1u, 4, GL_INT_2_10_10_10_REV, GL_TRUE, m_vertexStride, normalPointer );
+        break;
+    case MeshVertexFormat::OCTAHEDRAL_NORMALS:
+        glVertexAttribPointer( 1u, 2, GL_SHORT, GL_TRUE, m_vertexStride, normalPointer );
+        break;
+    }
+    glEnableVertexAttribArray( 1u );
+
+    GLState::getInstance().bindBuffer( GL_ARRAY_BUFFER, 0u );
 
     // NOTE: we do not bind an ELEMENT_ARRAY here, since we will switch
     // on the fly between triangle and edge indices depending on render mode
 
-    glBindVertexArray( 0u );
+    GLState::getInstance().bindVertexArray( 0u );
+
+    m_bufferGeneration = pool.getGeneration();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Issues an indexed draw of the given pool allocation, instanced if
+ * m_instanceCount is set. Expects the vertex array to be bound.
+ */
+void MeshDrawable::drawElements( GLenum mode, GLsizei count, BufferPool::Handle indices )
+{
+    const BufferPool& pool = BufferPool::getInstance();
+
+    GLState::getInstance().bindBuffer( GL_ELEMENT_ARRAY_BUFFER, pool.get( indices ).buffer );
+
+    if( m_instanceCount > 0 )
+        glDrawElementsInstanced( mode, count, m_indexType, pool.getOffsetPointer( indices ), m_instanceCount );
+    else
+        glDrawElements( mode, count, m_indexType, pool.getOffsetPointer( indices ) );
 }
 
 // -------------------------------------------------------------------------
@@ -112,8 +766,11 @@ void MeshDrawable::draw( const StateSet& state )
 
     uniforms.set( "alpha", m_alpha );
 
+    if( m_bufferGeneration != BufferPool::getInstance().getGeneration() )
+        bindVertexBuffers();
+
     // set render modes and issue draw calls
-    glBindVertexArray( m_vertexArray );
+    GLState::getInstance().bindVertexArray( m_vertexArray );
 
     if( m_drawSurface )
     {
@@ -122,24 +779,83 @@ void MeshDrawable::draw( const StateSet& state )
         // bind program and add uniforms
         m_stateSet.apply( m_program );
 
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_triangleBuffer );
-        glDrawElements( GL_TRIANGLES, m_triangleCount, GL_UNSIGNED_INT,
-                        nullptr );
+        if( isClusterCulling() && m_instanceCount == 0 && cullClusters( state ) )
+        {
+            if( !m_rangeCounts.empty() )
+            {
+                GLState::getInstance().bindBuffer( GL_ELEMENT_ARRAY_BUFFER, BufferPool::getInstance().get( m_triangleBuffer ).buffer );
+                glMultiDrawElements( GL_TRIANGLES, m_rangeCounts.data(), m_indexType,
+                                     m_rangeOffsets.data(), m_rangeCounts.size() );
+            }
+        }
+        else
+        {
+            drawElements( GL_TRIANGLES, m_triangleCount, m_triangleBuffer );
+        }
     }
 
-    if( m_drawEdges )
+    // edges turned on through the tweakable parameters wait for update()
+    if( m_drawEdges && m_edgeBuffer != BufferPool::INVALID_HANDLE )
     {
         modes.set( "LINE_MODE", 1 );
 
         // bind program and add uniforms
         m_stateSet.apply( m_program );
 
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_edgeBuffer );
-        glDrawElements( GL_LINES, m_edgeCount, GL_UNSIGNED_INT, nullptr );
+        drawElements( GL_LINES, m_edgeCount, m_edgeBuffer );
     }
 
-    glBindVertexArray( 0u );
+    GLState::getInstance().bindVertexArray( 0u );
     // done drawing
 }
 
+// -------------------------------------------------------------------------
+
+bool MeshDrawable::record( const StateSet& state, RenderQueue& queue )
+{
+    m_stateSet.setParent(state);
+    UniformSet& uniforms = m_stateSet.getOrCreateUniforms();
+    ModeSet&    modes    = m_stateSet.getOrCreateModes();
+
+    uniforms.set( "alpha", m_alpha );
+
+    const BufferPool& pool = BufferPool::getInstance();
+    if( m_bufferGeneration != pool.getGeneration() )
+        bindVertexBuffers();
+
+    // the program variant is resolved when recording, so the modes may
+    // change between the packets
+    if( m_drawSurface )
+    {
+        modes.clear( "LINE_MODE" );
+
+        // one packet per visible range, the queue has no multi-draw packets
+        if( isClusterCulling() && m_instanceCount == 0 && cullClusters( state ) )
+        {
+            for( size_t range = 0; range < m_rangeCounts.size(); ++range )
+                queue.drawElements( m_stateSet, m_program, m_vertexArray, pool.get( m_triangleBuffer ).buffer,
+                                    GL_TRIANGLES, m_rangeCounts[range], m_indexType,
+                                    m_rangeOffsets[range] );
+        }
+        else
+        {
+            queue.drawElements( m_stateSet, m_program, m_vertexArray, pool.get( m_triangleBuffer ).buffer,
+                                GL_TRIANGLES, m_triangleCount, m_indexType,
+                                pool.getOffsetPointer( m_triangleBuffer ),
+                                m_instanceCount );
+        }
+    }
+
+    if( m_drawEdges && m_edgeBuffer != BufferPool::INVALID_HANDLE )
+    {
+        modes.set( "LINE_MODE", 1 );
+        queue.drawElements( m_stateSet, m_program, m_vertexArray, pool.get( m_edgeBuffer ).buffer,
+                            GL_LINES, m_edgeCount, m_indexType,
+                            pool.getOffsetPointer( m_edgeBuffer ),
+                            m_instanceCount );
+    }
+
+    return true;
+}
+
 } // namespace ugl
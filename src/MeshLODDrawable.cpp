@@ -0,0 +1,156 @@
+/** @file MeshLODDrawable.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/Frustum.hpp"
+#include "ugl/MeshLODDrawable.hpp"
+#include "ugl/ViewController.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+namespace ugl
+{
+
+MeshLODDrawable::MeshLODDrawable( MeshData& data, const MeshVertexFormat& format ) :
+    m_format( format ),
+    m_boundingBox( data.getBoundingBox() ),
+    m_currentLevel( 0 ),
+    m_forcedLevel( -1 ),
+    m_detailSize( 0.5f ),
+    m_viewController( nullptr ),
+    m_interactionBias( 1 ),
+    m_drawSurface( true ),
+    m_drawEdges( false ),
+    m_alpha( 1.0f )
+{
+    m_levels.push_back( new MeshDrawable( data, format ) );
+}
+
+// -------------------------------------------------------------------------
+
+MeshLODDrawable::~MeshLODDrawable()
+{
+    for( std::vector<MeshDrawable*>::iterator level = m_levels.begin(); level != m_levels.end(); ++level )
+        delete *level;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshLODDrawable::addLevel( MeshData& data )
+{
+    m_levels.push_back( new MeshDrawable( data, m_format ) );
+}
+
+// -------------------------------------------------------------------------
+
+void MeshLODDrawable::getTweakableParameters(bool** drawSurface, bool** drawEdges, float** alpha)
+{
+    *drawSurface = &this->m_drawSurface;
+    *drawEdges = &this->m_drawEdges;
+    *alpha = &this->m_alpha;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Returns the diameter of the bounding sphere projected to the
+ * viewport as fraction of its height, or a negative value if the matrices are
+ * unknown or the camera is inside the sphere.
+ */
+float MeshLODDrawable::computeProjectedSize( const StateSet& state ) const
+{
+    glm::mat4 projection, modelview;
+
+    if( !Frustum::getViewMatrices( state, &projection, &modelview ) )
+        return -1.0f;
+
+    const glm::vec3 center = 0.5f * (m_boundingBox.getMin() + m_boundingBox.getMax());
+    const float     scale  = glm::length( glm::vec3( modelview[0] ) );
+    const float     radius = 0.5f * scale * glm::length( m_boundingBox.getMax() - m_boundingBox.getMin() );
+
+    // orthographic projections do not depend on the distance
+    if( projection[2][3] == 0.0f )
+        return radius * projection[1][1];
+
+    const glm::vec4 viewCenter = modelview * glm::vec4( center.x, center.y, center.z, 1.0f );
+    const float     distance   = -viewCenter.z;
+
+    if( distance <= radius )
+        return -1.0f;
+
+    return radius * projection[1][1] / distance;
+}
+
+// -------------------------------------------------------------------------
+
+MeshDrawable* MeshLODDrawable::selectLevel( const StateSet& state )
+{
+    const GLsizei last = m_levels.size() - 1;
+
+    if( m_forcedLevel >= 0 )
+    {
+        m_currentLevel = std::min<GLsizei>( m_forcedLevel, last );
+    }
+    else
+    {
+        m_currentLevel = 0;
+
+        const float size = computeProjectedSize( state );
+        if( size >= 0.0f )
+        {
+            for( float threshold = m_detailSize; m_currentLevel < last && size < threshold; threshold *= 0.5f )
+                ++m_currentLevel;
+        }
+
+        if( m_viewController && m_viewController->isInteracting() )
+            m_currentLevel = std::min( m_currentLevel + m_interactionBias, last );
+    }
+
+    MeshDrawable* level = m_levels[m_currentLevel];
+
+    bool* drawSurface;
+    bool* drawEdges;
+    float* alpha;
+    level->getTweakableParameters( &drawSurface, &drawEdges, &alpha );
+
+    *drawSurface = m_drawSurface;
+    *drawEdges   = m_drawEdges;
+    *alpha       = m_alpha;
+
+    return level;
+}
+
+// -------------------------------------------------------------------------
+
+void MeshLODDrawable::draw( const StateSet& state )
+{
+    selectLevel( state )->draw( state );
+}
+
+// -------------------------------------------------------------------------
+
+bool MeshLODDrawable::record( const StateSet& state, RenderQueue& queue )
+{
+    return selectLevel( state )->record( state, queue );
+}
+
+} // namespace ugl
@@ -0,0 +1,382 @@
+/** @file MeshOptimizer.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace ugl
+{
+
+namespace
+{
+
+/// "invalid" marker for point and triangle indices
+const GLuint NONE = ~0u;
+
+/**
+ * @brief Forsyth's vertex score: recently used vertices (except those of the
+ * last triangle) and vertices with few remaining triangles score high.
+ */
+float vertexScore(GLint cachePosition, GLuint remainingValence, GLsizei cacheSize)
+{
+    if (remainingValence == 0u)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (float) (cachePosition - 3) / (cacheSize - 3), 1.5f);
+    }
+
+    return score + 2.0f / std::sqrt((float) remainingValence);
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+MeshOptimizer::Statistics MeshOptimizer::optimize(MeshData& data,
+                                                  const std::vector<ScalarData*>& scalars)
+{
+    Statistics out;
+    out.acmrBefore = computeACMR(data.getTriangles(), data.getPointCount(), m_cacheSize);
+
+    std::vector<glm::uvec3> triangles = optimizeVertexCache(data.getTriangles(), data.getPointCount());
+
+    if (m_optimizeOverdraw)
+        triangles = optimizeOverdraw(triangles, data.getPoints());
+
+    data.setTriangles(triangles);
+    optimizeVertexFetch(data, scalars);
+
+    // reordering the points does not change the cache behaviour
+    out.acmrAfter = computeACMR(data.getTriangles(), data.getPointCount(), m_cacheSize);
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+float MeshOptimizer::computeACMR(const std::vector<glm::uvec3>& triangles,
+                                 GLsizei pointCount, GLsizei cacheSize)
+{
+    if (triangles.empty())
+        return 0.0f;
+
+    // a point is cached if less than cacheSize misses happened since it was loaded
+    std::vector<size_t> loaded(pointCount, 0u);
+    size_t misses = 0u;
+
+    for (std::vector<glm::uvec3>::const_iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            const GLuint pointId = (*triangle)[i];
+
+            if (loaded[pointId] == 0u || misses - loaded[pointId] >= (size_t) cacheSize)
+                loaded[pointId] = ++misses;
+        }
+    }
+
+    return (float) misses / triangles.size();
+}
+
+// -------------------------------------------------------------------------
+
+std::vector<glm::uvec3> MeshOptimizer::optimizeVertexCache(const std::vector<glm::uvec3>& triangles,
+                                                           GLsizei pointCount) const
+{
+    // triangles adjacent to each point, the first valence[p] of them not yet emitted
+    std::vector<GLuint> adjacencyOffsets(pointCount + 1, 0u);
+    for (std::vector<glm::uvec3>::const_iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+        for (int i = 0; i < 3; ++i)
+            ++adjacencyOffsets[(*triangle)[i] + 1];
+
+    for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+        adjacencyOffsets[pointId + 1] += adjacencyOffsets[pointId];
+
+    std::vector<GLuint> adjacency(triangles.size() * 3);
+    std::vector<GLuint> valence(pointCount, 0u);
+    for (GLuint triangleId = 0; triangleId < triangles.size(); ++triangleId)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            const GLuint pointId = triangles[triangleId][i];
+            adjacency[adjacencyOffsets[pointId] + valence[pointId]++] = triangleId;
+        }
+    }
+
+    std::vector<GLint> cachePosition(pointCount, -1);
+    std::vector<float> score(pointCount);
+    for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+        score[pointId] = vertexScore(-1, valence[pointId], m_cacheSize);
+
+    std::vector<bool> emitted(triangles.size(), false);
+
+    // LRU cache, with room for the points of the next triangle
+    std::vector<GLuint> cache, nextCache;
+    cache.reserve(m_cacheSize + 3);
+    nextCache.reserve(m_cacheSize + 3);
+
+    std::vector<glm::uvec3> out;
+    out.reserve(triangles.size());
+
+    GLuint best = NONE;
+    size_t cursor = 0u;
+
+    while (out.size() < triangles.size())
+    {
+        // if no cached point has triangles left, continue with the next one
+        // in input order
+        if (best == NONE)
+        {
+            while (emitted[cursor])
+                ++cursor;
+            best = cursor;
+        }
+
+        const glm::uvec3& triangle = triangles[best];
+        out.push_back(triangle);
+        emitted[best] = true;
+
+        // remove the triangle from the adjacency of its points
+        for (int i = 0; i < 3; ++i)
+        {
+            const GLuint pointId = triangle[i];
+            GLuint* begin = &adjacency[adjacencyOffsets[pointId]];
+            GLuint* end   = begin + valence[pointId];
+            GLuint* found = std::find(begin, end, best);
+
+            if (found != end)
+            {
+                *found = *(end - 1);
+                --valence[pointId];
+            }
+        }
+
+        // move the points of the triangle to the front of the cache
+        nextCache.assign(&triangle[0], &triangle[0] + 3);
+        for (std::vector<GLuint>::const_iterator pointId = cache.begin(); pointId != cache.end(); ++pointId)
+            if (*pointId != triangle[0] && *pointId != triangle[1] && *pointId != triangle[2])
+                nextCache.push_back(*pointId);
+
+        for (size_t position = 0u; position < nextCache.size(); ++position)
+        {
+            const GLuint pointId = nextCache[position];
+            cachePosition[pointId] = position < (size_t) m_cacheSize ? (GLint) position : -1;
+            score[pointId] = vertexScore(cachePosition[pointId], valence[pointId], m_cacheSize);
+        }
+
+        if (nextCache.size() > (size_t) m_cacheSize)
+            nextCache.resize(m_cacheSize);
+        cache.swap(nextCache);
+
+        // pick the best triangle adjacent to the cache
+        best = NONE;
+        float bestScore = -1.0f;
+
+        for (std::vector<GLuint>::const_iterator pointId = cache.begin(); pointId != cache.end(); ++pointId)
+        {
+            const GLuint* adjacent = &adjacency[adjacencyOffsets[*pointId]];
+
+            for (GLuint i = 0u; i < valence[*pointId]; ++i)
+            {
+                const glm::uvec3& candidate = triangles[adjacent[i]];
+                const float candidateScore = score[candidate[0]] + score[candidate[1]] + score[candidate[2]];
+
+                if (candidateScore > bestScore)
+                {
+                    best      = adjacent[i];
+                    bestScore = candidateScore;
+                }
+            }
+        }
+    }
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+std::vector<glm::uvec3> MeshOptimizer::optimizeOverdraw(const std::vector<glm::uvec3>& triangles,
+                                                        const std::vector<glm::vec3>& points) const
+{
+    if (triangles.empty())
+        return triangles;
+
+    // split into clusters where a triangle misses the FIFO cache for all of
+    // its points, so that reordering the clusters hardly changes the ACMR
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<size_t> loaded(points.size(), 0u);
+        size_t misses = 0u;
+
+        for (size_t triangleId = 0u; triangleId < triangles.size(); ++triangleId)
+        {
+            int triangleMisses = 0;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const GLuint pointId = triangles[triangleId][i];
+
+                if (loaded[pointId] == 0u || misses - loaded[pointId] >= (size_t) m_cacheSize)
+                {
+                    loaded[pointId] = ++misses;
+                    ++triangleMisses;
+                }
+            }
+
+            if (triangleMisses == 3 || triangleId == 0u)
+                clusterStarts.push_back(triangleId);
+        }
+    }
+    clusterStarts.push_back(triangles.size());
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+
+    // area weighted centroid and normal of the clusters and the mesh
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    std::vector<float>     areas(clusterCount, 0.0f);
+
+    glm::vec3 meshCentroid(0.0f);
+    float     meshArea = 0.0f;
+
+    for (size_t cluster = 0u; cluster < clusterCount; ++cluster)
+    {
+        for (size_t triangleId = clusterStarts[cluster]; triangleId < clusterStarts[cluster + 1]; ++triangleId)
+        {
+            const glm::vec3& p0 = points[triangles[triangleId][0]];
+            const glm::vec3& p1 = points[triangles[triangleId][1]];
+            const glm::vec3& p2 = points[triangles[triangleId][2]];
+
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float     area   = glm::length(normal);
+
+            centroids[cluster] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[cluster]   += normal;
+            areas[cluster]     += area;
+        }
+
+        meshCentroid += centroids[cluster];
+        meshArea     += areas[cluster];
+    }
+
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // clusters facing away from the centroid occlude the others, draw them first
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (size_t cluster = 0u; cluster < clusterCount; ++cluster)
+    {
+        if (areas[cluster] <= 0.0f || glm::length(normals[cluster]) <= 0.0f)
+            continue;
+
+        const glm::vec3 centroid = centroids[cluster] / areas[cluster];
+        sortKeys[cluster] = glm::dot(centroid - meshCentroid, glm::normalize(normals[cluster]));
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t cluster = 0u; cluster < clusterCount; ++cluster)
+        order[cluster] = cluster;
+
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<glm::uvec3> out;
+    out.reserve(triangles.size());
+    for (std::vector<size_t>::const_iterator cluster = order.begin(); cluster != order.end(); ++cluster)
+        out.insert(out.end(), triangles.begin() + clusterStarts[*cluster],
+                   triangles.begin() + clusterStarts[*cluster + 1]);
+
+    const float acmrBefore = computeACMR(triangles, points.size(), m_cacheSize);
+    const float acmrAfter  = computeACMR(out, points.size(), m_cacheSize);
+
+    if (acmrAfter > acmrBefore * m_overdrawThreshold)
+        return triangles;
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Renumbers the points in order of their first use by a triangle;
+ * unused points are moved to the end.
+ */
+void MeshOptimizer::optimizeVertexFetch(MeshData& data, const std::vector<ScalarData*>& scalars)
+{
+    const GLsizei pointCount = data.getPointCount();
+
+    m_vertexRemap.assign(pointCount, NONE);
+    GLuint next = 0u;
+
+    std::vector<glm::uvec3> triangles = data.getTriangles();
+    for (std::vector<glm::uvec3>::iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            GLuint& remapped = m_vertexRemap[(*triangle)[i]];
+
+            if (remapped == NONE)
+                remapped = next++;
+
+            (*triangle)[i] = remapped;
+        }
+    }
+
+    for (std::vector<GLuint>::iterator remapped = m_vertexRemap.begin(); remapped != m_vertexRemap.end(); ++remapped)
+        if (*remapped == NONE)
+            *remapped = next++;
+
+    std::vector<glm::vec3> points(pointCount);
+    for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+        points[m_vertexRemap[pointId]] = data.getPoint(pointId);
+
+    data.setPoints(points);
+    data.setTriangles(triangles);
+
+    for (std::vector<ScalarData*>::const_iterator scalar = scalars.begin(); scalar != scalars.end(); ++scalar)
+    {
+        if ((*scalar)->getScalarCount() != pointCount)
+        {
+            std::cerr << "MeshOptimizer: scalar count does not match the point count, not remapped" << std::endl;
+            continue;
+        }
+
+        std::vector<GLfloat> values(pointCount);
+        for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+            values[m_vertexRemap[pointId]] = (*scalar)->getScalar(pointId);
+
+        (*scalar)->setAllScalars(values);
+    }
+}
+
+} // namespace ugl
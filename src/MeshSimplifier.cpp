@@ -0,0 +1,655 @@
+/** @file MeshSimplifier.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/MeshSimplifier.hpp"
+#include "ugl/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+
+namespace ugl
+{
+
+namespace
+{
+
+/// "invalid" marker for point and triangle indices
+const GLuint NONE = ~0u;
+
+/// meshes below this size are simplified as a single cell
+const GLsizei PARTITION_THRESHOLD = 50000;
+
+/**
+ * @brief Symmetric 4x4 error quadric, upper triangle stored row by row.
+ */
+struct Quadric
+{
+    double m[10];
+
+    Quadric()
+    {
+        std::fill(m, m + 10, 0.0);
+    }
+
+    void addPlane(double nx, double ny, double nz, double d, double weight)
+    {
+        m[0] += weight * nx * nx;  m[1] += weight * nx * ny;  m[2] += weight * nx * nz;  m[3] += weight * nx * d;
+        m[4] += weight * ny * ny;  m[5] += weight * ny * nz;  m[6] += weight * ny * d;
+        m[7] += weight * nz * nz;  m[8] += weight * nz * d;
+        m[9] += weight * d * d;
+    }
+
+    Quadric operator+(const Quadric& other) const
+    {
+        Quadric out;
+        for (int i = 0; i < 10; ++i)
+            out.m[i] = m[i] + other.m[i];
+        return out;
+    }
+
+    double evaluate(const glm::vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+
+        return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x
+             + m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y
+             + m[7] * z * z + 2.0 * m[8] * z
+             + m[9];
+    }
+};
+
+// -------------------------------------------------------------------------
+
+/// where the surviving point of a collapse is placed
+enum Placement
+{
+    PLACE_A,
+    PLACE_B,
+    PLACE_MIDPOINT
+};
+
+struct Collapse
+{
+    double    cost;
+    GLuint    a;        ///< surviving point
+    GLuint    b;        ///< removed point
+    GLuint    stampA;
+    GLuint    stampB;
+    Placement placement;
+
+    bool operator<(const Collapse& other) const
+    {
+        // std::priority_queue is a max heap
+        return cost > other.cost;
+    }
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Shared state of all cells. Cells only write triangles they own and
+ * points which are not locked (and thus referenced by their triangles only).
+ */
+struct SimplifyState
+{
+    std::vector<glm::vec3>              points;
+    std::vector<glm::uvec3>             triangles;
+    std::vector<Quadric>                quadrics;
+    std::vector< std::vector<GLfloat> > scalars;
+    std::vector<char>                   locked;
+    std::vector<char>                   removed;
+};
+
+// -------------------------------------------------------------------------
+
+glm::vec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Greedy edge collapse on the triangles of one cell.
+ */
+class CellSimplifier
+{
+public:
+    CellSimplifier(SimplifyState& state, const GLuint* triangles, GLsizei triangleCount) :
+        m_state(state),
+        m_triangleCount(triangleCount)
+    {
+        for (GLsizei i = 0; i < triangleCount; ++i)
+        {
+            const glm::uvec3& triangle = m_state.triangles[triangles[i]];
+            for (int corner = 0; corner < 3; ++corner)
+                m_adjacency[localPoint(triangle[corner])].push_back(triangles[i]);
+        }
+    }
+
+    void run(GLsizei targetCount, const GLuint* triangles)
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(3 * m_triangleCount);
+
+        for (GLsizei i = 0; i < m_triangleCount; ++i)
+        {
+            const glm::uvec3& triangle = m_state.triangles[triangles[i]];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const GLuint a = triangle[corner];
+                const GLuint b = triangle[(corner + 1) % 3];
+                edges.push_back((uint64_t) std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        for (std::vector<uint64_t>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge)
+            push((GLuint) (*edge >> 32), (GLuint) (*edge & 0xffffffffu));
+
+        while (m_triangleCount > targetCount && !m_heap.empty())
+        {
+            const Collapse collapse = m_heap.top();
+            m_heap.pop();
+
+            const GLuint a = m_localIds[collapse.a];
+            const GLuint b = m_localIds[collapse.b];
+
+            if (m_dead[b] || m_dead[a] || m_stamps[a] != collapse.stampA || m_stamps[b] != collapse.stampB)
+                continue;
+
+            const glm::vec3 position = placement(collapse);
+
+            if (!isValid(collapse.a, collapse.b, position))
+                continue;
+
+            apply(collapse, position);
+        }
+    }
+
+private:
+    GLuint localPoint(GLuint point)
+    {
+        std::unordered_map<GLuint, GLuint>::const_iterator found = m_localIds.find(point);
+        if (found != m_localIds.end())
+            return found->second;
+
+        const GLuint local = m_adjacency.size();
+        m_localIds[point] = local;
+        m_adjacency.push_back(std::vector<GLuint>());
+        m_stamps.push_back(0u);
+        m_dead.push_back(0);
+        return local;
+    }
+
+    glm::vec3 placement(const Collapse& collapse) const
+    {
+        const glm::vec3& a = m_state.points[collapse.a];
+        const glm::vec3& b = m_state.points[collapse.b];
+
+        switch (collapse.placement)
+        {
+            case PLACE_A: return a;
+            case PLACE_B: return b;
+            default:      return 0.5f * (a + b);
+        }
+    }
+
+    /**
+     * @brief Queues the cheapest placement for collapsing the edge (a, b);
+     * the removed point must not be locked.
+     */
+    void push(GLuint a, GLuint b)
+    {
+        const std::vector<char>& locked = m_state.locked;
+
+        if (locked[a] && locked[b])
+            return;
+
+        if (locked[b])
+            std::swap(a, b);
+
+        const Quadric quadric = m_state.quadrics[a] + m_state.quadrics[b];
+
+        Collapse collapse;
+        collapse.a         = a;
+        collapse.b         = b;
+        collapse.stampA    = m_stamps[m_localIds[a]];
+        collapse.stampB    = m_stamps[m_localIds[b]];
+        collapse.placement = PLACE_A;
+        collapse.cost      = quadric.evaluate(m_state.points[a]);
+
+        if (!locked[a])
+        {
+            const double costB = quadric.evaluate(m_state.points[b]);
+            if (costB < collapse.cost)
+            {
+                collapse.cost      = costB;
+                collapse.placement = PLACE_B;
+            }
+
+            const double costMidpoint = quadric.evaluate(0.5f * (m_state.points[a] + m_state.points[b]));
+            if (costMidpoint < collapse.cost)
+            {
+                collapse.cost      = costMidpoint;
+                collapse.placement = PLACE_MIDPOINT;
+            }
+        }
+
+        m_heap.push(collapse);
+    }
+
+    void collectNeighbours(GLuint point, GLuint exclude, std::vector<GLuint>& out) const
+    {
+        out.clear();
+
+        const std::vector<GLuint>& adjacency = m_adjacency[m_localIds.find(point)->second];
+        for (std::vector<GLuint>::const_iterator t = adjacency.begin(); t != adjacency.end(); ++t)
+        {
+            if (m_state.removed[*t])
+                continue;
+
+            const glm::uvec3& triangle = m_state.triangles[*t];
+            for (int corner = 0; corner < 3; ++corner)
+                if (triangle[corner] != point && triangle[corner] != exclude)
+                    out.push_back(triangle[corner]);
+        }
+
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    /**
+     * @brief Checks the link condition (the collapse keeps the surface
+     * manifold) and that no remaining triangle flips.
+     *
+     * A locked a may have neighbours through triangles of other cells, which
+     * this cell cannot see. Such a neighbour shared with b is locked as well
+     * (it belongs to triangles of both cells), so collapses which would
+     * connect a to a locked point it is not connected to locally are
+     * rejected. Hence no cell creates edges between locked points and the
+     * check stays exact across the seams.
+     */
+    bool isValid(GLuint a, GLuint b, const glm::vec3& position)
+    {
+        collectNeighbours(a, b, m_neighboursA);
+        collectNeighbours(b, a, m_neighboursB);
+
+        if (m_state.locked[a])
+        {
+            for (std::vector<GLuint>::const_iterator c = m_neighboursB.begin(); c != m_neighboursB.end(); ++c)
+                if (m_state.locked[*c] && !std::binary_search(m_neighboursA.begin(), m_neighboursA.end(), *c))
+                    return false;
+        }
+
+        m_common.clear();
+        std::set_intersection(m_neighboursA.begin(), m_neighboursA.end(),
+                              m_neighboursB.begin(), m_neighboursB.end(),
+                              std::back_inserter(m_common));
+
+        GLsizei shared = 0;
+
+        const GLuint ends[2] = { a, b };
+        for (int end = 0; end < 2; ++end)
+        {
+            const std::vector<GLuint>& adjacency = m_adjacency[m_localIds[ends[end]]];
+            for (std::vector<GLuint>::const_iterator t = adjacency.begin(); t != adjacency.end(); ++t)
+            {
+                if (m_state.removed[*t])
+                    continue;
+
+                const glm::uvec3& triangle = m_state.triangles[*t];
+                const bool hasA = triangle.x == a || triangle.y == a || triangle.z == a;
+                const bool hasB = triangle.x == b || triangle.y == b || triangle.z == b;
+
+                if (hasA && hasB)
+                {
+                    if (end == 0)
+                        ++shared;
+                    continue;
+                }
+
+                glm::vec3 moved[3];
+                for (int corner = 0; corner < 3; ++corner)
+                    moved[corner] = triangle[corner] == ends[end] ? position : m_state.points[triangle[corner]];
+
+                const glm::vec3 before = triangleNormal(m_state.points[triangle.x],
+                                                        m_state.points[triangle.y],
+                                                        m_state.points[triangle.z]);
+                const glm::vec3 after  = triangleNormal(moved[0], moved[1], moved[2]);
+
+                if (glm::dot(before, after) <= 0.0f)
+                    return false;
+            }
+        }
+
+        return shared > 0 && (GLsizei) m_common.size() == shared;
+    }
+
+    void apply(const Collapse& collapse, const glm::vec3& position)
+    {
+        const GLuint a = collapse.a;
+        const GLuint b = collapse.b;
+
+        std::vector<GLuint>& adjacencyA = m_adjacency[m_localIds[a]];
+        std::vector<GLuint>& adjacencyB = m_adjacency[m_localIds[b]];
+
+        for (std::vector<GLuint>::const_iterator t = adjacencyB.begin(); t != adjacencyB.end(); ++t)
+        {
+            if (m_state.removed[*t])
+                continue;
+
+            glm::uvec3& triangle = m_state.triangles[*t];
+
+            if (triangle.x == a || triangle.y == a || triangle.z == a)
+            {
+                m_state.removed[*t] = 1;
+                --m_triangleCount;
+                continue;
+            }
+
+            for (int corner = 0; corner < 3; ++corner)
+                if (triangle[corner] == b)
+                    triangle[corner] = a;
+
+            adjacencyA.push_back(*t);
+        }
+
+        adjacencyB.clear();
+        m_dead[m_localIds[b]] = 1;
+
+        if (!m_state.locked[a])
+        {
+            m_state.points[a]   = position;
+            m_state.quadrics[a] = m_state.quadrics[a] + m_state.quadrics[b];
+
+            for (std::vector< std::vector<GLfloat> >::iterator scalars = m_state.scalars.begin(); scalars != m_state.scalars.end(); ++scalars)
+            {
+                if (collapse.placement == PLACE_B)
+                    (*scalars)[a] = (*scalars)[b];
+                else if (collapse.placement == PLACE_MIDPOINT)
+                    (*scalars)[a] = 0.5f * ((*scalars)[a] + (*scalars)[b]);
+            }
+        }
+
+        ++m_stamps[m_localIds[a]];
+
+        collectNeighbours(a, NONE, m_neighboursA);
+        for (std::vector<GLuint>::const_iterator neighbour = m_neighboursA.begin(); neighbour != m_neighboursA.end(); ++neighbour)
+            push(a, *neighbour);
+    }
+
+    SimplifyState&                      m_state;
+    GLsizei                             m_triangleCount;
+
+    std::unordered_map<GLuint, GLuint>  m_localIds;
+    std::vector< std::vector<GLuint> >  m_adjacency;  ///< triangles per local point
+    std::vector<GLuint>                 m_stamps;     ///< incremented when a point changes
+    std::vector<char>                   m_dead;
+
+    std::priority_queue<Collapse>       m_heap;
+
+    std::vector<GLuint>                 m_neighboursA;
+    std::vector<GLuint>                 m_neighboursB;
+    std::vector<GLuint>                 m_common;
+};
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Simplifies data to about ratio times its triangle count.
+ * @param scalars Per-point scalars, interpolated along; others are dropped.
+ * @param out Receives the simplified mesh and scalars, compacted.
+ * @param gridOffset Shift of the cell grid in cells (0 to 1), which moves the
+ * locked seams between the cells.
+ */
+void MeshSimplifier::simplify(MeshData& data, const std::vector<ScalarData*>& scalars,
+                              float ratio, Level& out, float gridOffset) const
+{
+    const GLsizei pointCount    = data.getPointCount();
+    const GLsizei triangleCount = data.getTriangleCount();
+
+    SimplifyState state;
+    state.points    = data.getPoints();
+    state.triangles = data.getTriangles();
+    state.quadrics.resize(pointCount);
+    state.locked.assign(pointCount, 0);
+    state.removed.assign(triangleCount, 0);
+
+    std::vector<bool> hasScalars(scalars.size(), false);
+    for (size_t i = 0; i < scalars.size(); ++i)
+    {
+        if (scalars[i]->getScalarCount() != pointCount)
+        {
+            std::cerr << "MeshSimplifier: scalar count does not match point count, dropping scalars" << std::endl;
+            continue;
+        }
+
+        hasScalars[i] = true;
+        state.scalars.push_back(scalars[i]->getAllScalars());
+    }
+
+    // quadrics of the planes around each point, weighted by area; the
+    // adjacency is built up front as the lazy update is not thread-safe
+    if (pointCount > 0)
+        data.getPointTriangleCount(0);
+
+    parallelFor(0, pointCount, [&](size_t begin, size_t end)
+    {
+        for (size_t point = begin; point < end; ++point)
+        {
+            const GLsizei count    = data.getPointTriangleCount(point);
+            const GLuint* adjacent = data.getPointTriangles(point);
+
+            for (GLsizei i = 0; i < count; ++i)
+            {
+                const glm::uvec3& triangle = state.triangles[adjacent[i]];
+                const glm::vec3&  p0       = state.points[triangle.x];
+
+                const glm::vec3 normal = triangleNormal(p0, state.points[triangle.y], state.points[triangle.z]);
+                const float     length = glm::length(normal);
+
+                if (length == 0.0f)
+                    continue;
+
+                const glm::vec3 n = normal / length;
+                state.quadrics[point].addPlane(n.x, n.y, n.z, -glm::dot(n, p0), 0.5 * length);
+            }
+        }
+    }, 4096);
+
+    // keep the boundary (and non-manifold edges)
+    for (GLint edge = 0; edge < data.getEdgeCount(); ++edge)
+    {
+        if (data.getEdgeTriangleCount(edge) != 2)
+        {
+            state.locked[data.getEdge(edge).x] = 1;
+            state.locked[data.getEdge(edge).y] = 1;
+        }
+    }
+
+    // partition the triangles by centroid and lock the points between cells
+    GLsizei cellsPerAxis = m_partitionCount;
+    if (cellsPerAxis <= 0)
+        cellsPerAxis = triangleCount < PARTITION_THRESHOLD ? 1 : (GLsizei) std::ceil(std::cbrt(4.0 * getThreadCount()));
+
+    // a shifted grid has a partial cell at both ends of each axis
+    const GLint   firstCell = gridOffset > 0.0f && cellsPerAxis > 1 ? 1 : 0;
+    if (firstCell == 0)
+        gridOffset = 0.0f;
+    cellsPerAxis += firstCell;
+
+    const GLsizei cellCount = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+
+    const BoundingBox& box    = data.getBoundingBox();
+    const glm::vec3    extent = glm::max(box.getMax() - box.getMin(), glm::vec3(1e-20f));
+
+    std::vector<GLuint> triangleCells(triangleCount);
+    std::vector<GLuint> cellOffsets(cellCount + 1, 0u);
+
+    for (GLsizei t = 0; t < triangleCount; ++t)
+    {
+        const glm::uvec3& triangle = state.triangles[t];
+        const glm::vec3 centroid   = (state.points[triangle.x] + state.points[triangle.y] + state.points[triangle.z]) / 3.0f;
+        const glm::vec3 relative   = (centroid - box.getMin()) / extent * (float) (cellsPerAxis - firstCell)
+                                   + glm::vec3(gridOffset);
+
+        GLint cell[3];
+        for (int axis = 0; axis < 3; ++axis)
+            cell[axis] = std::min(std::max((GLint) relative[axis], 0), cellsPerAxis - 1);
+
+        triangleCells[t] = (cell[2] * cellsPerAxis + cell[1]) * cellsPerAxis + cell[0];
+        ++cellOffsets[triangleCells[t] + 1];
+    }
+
+    if (cellCount > 1)
+    {
+        std::vector<GLuint> pointCells(pointCount, NONE);
+
+        for (GLsizei t = 0; t < triangleCount; ++t)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                GLuint& cell = pointCells[state.triangles[t][corner]];
+                if (cell == NONE)
+                    cell = triangleCells[t];
+                else if (cell != triangleCells[t])
+                    state.locked[state.triangles[t][corner]] = 1;
+            }
+        }
+    }
+
+    for (GLsizei cell = 0; cell < cellCount; ++cell)
+        cellOffsets[cell + 1] += cellOffsets[cell];
+
+    std::vector<GLuint> cellTriangles(triangleCount);
+    {
+        std::vector<GLuint> cursor(cellOffsets.begin(), cellOffsets.end() - 1);
+        for (GLsizei t = 0; t < triangleCount; ++t)
+            cellTriangles[cursor[triangleCells[t]]++] = t;
+    }
+
+    parallelFor(0, cellCount, [&](size_t begin, size_t end)
+    {
+        for (size_t cell = begin; cell < end; ++cell)
+        {
+            const GLuint* triangles = cellTriangles.data() + cellOffsets[cell];
+            const GLsizei count     = cellOffsets[cell + 1] - cellOffsets[cell];
+
+            if (count == 0)
+                continue;
+
+            CellSimplifier simplifier(state, triangles, count);
+            simplifier.run((GLsizei) std::ceil(count * ratio), triangles);
+        }
+    }, 1);
+
+    // compact the surviving points in order of first use
+    std::vector<GLuint>     remap(pointCount, NONE);
+    std::vector<glm::vec3>  points;
+    std::vector<glm::uvec3> triangles;
+
+    triangles.reserve(triangleCount * ratio + 1);
+
+    for (GLsizei t = 0; t < triangleCount; ++t)
+    {
+        if (state.removed[t])
+            continue;
+
+        glm::uvec3 triangle = state.triangles[t];
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint& index = remap[triangle[corner]];
+            if (index == NONE)
+            {
+                index = points.size();
+                points.push_back(state.points[triangle[corner]]);
+            }
+            triangle[corner] = index;
+        }
+
+        triangles.push_back(triangle);
+    }
+
+    out.data = MeshData();
+    out.data.setPoints(points);
+    out.data.setTriangles(triangles);
+
+    out.scalars.assign(scalars.size(), ScalarData());
+
+    for (size_t i = 0, source = 0; i < scalars.size(); ++i)
+    {
+        if (!hasScalars[i])
+            continue;
+
+        std::vector<GLfloat> values(points.size());
+        for (GLsizei point = 0; point < pointCount; ++point)
+            if (remap[point] != NONE)
+                values[remap[point]] = state.scalars[source][point];
+
+        out.scalars[i].setAllScalars(values);
+        ++source;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Builds up to levelCount successively coarser levels, each with about
+ * ratio times the triangles of the previous one. Stops early when a level
+ * cannot be simplified further.
+ */
+std::vector<MeshSimplifier::Level> MeshSimplifier::buildChain(MeshData& data, const std::vector<ScalarData*>& scalars,
+                                                              int levelCount, float ratio) const
+{
+    std::vector<Level> out(std::max(levelCount, 0));
+
+    for (int level = 0; level < levelCount; ++level)
+    {
+        MeshData& source = level == 0 ? data : out[level - 1].data;
+
+        std::vector<ScalarData*> sourceScalars = scalars;
+        if (level > 0)
+            for (size_t i = 0; i < sourceScalars.size(); ++i)
+                sourceScalars[i] = &out[level - 1].scalars[i];
+
+        // shift the grid on odd levels to release the seams of the previous one
+        simplify(source, sourceScalars, ratio, out[level], level % 2 == 1 ? 0.5f : 0.0f);
+
+        if (out[level].data.getTriangleCount() >= source.getTriangleCount())
+        {
+            out.resize(level);
+            break;
+        }
+    }
+
+    return out;
+}
+
+} // namespace ugl
@@ -0,0 +1,294 @@
+/** @file MeshWelder.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/MeshWelder.hpp"
+#include "ugl/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace ugl
+{
+
+namespace
+{
+
+/// "invalid" marker for point indices
+const GLuint NONE = ~0u;
+
+uint64_t mix(uint64_t key)
+{
+    // splitmix64 finalizer
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+// -------------------------------------------------------------------------
+
+uint64_t hashCell(int64_t x, int64_t y, int64_t z)
+{
+    return mix((uint64_t) x * 73856093ull ^ (uint64_t) y * 19349663ull ^ (uint64_t) z * 83492791ull);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Hash of the exact position; adding 0 turns -0 into +0.
+ */
+uint64_t hashPosition(const glm::vec3& point)
+{
+    uint32_t bits[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        const float value = point[i] + 0.0f;
+        std::memcpy(&bits[i], &value, sizeof(float));
+    }
+
+    return hashCell(bits[0], bits[1], bits[2]);
+}
+
+// -------------------------------------------------------------------------
+
+size_t meshBytes(GLsizei points, GLsizei triangles, const std::vector<ScalarData*>& scalars)
+{
+    size_t out = points * sizeof(glm::vec3) + triangles * sizeof(glm::uvec3);
+
+    for (std::vector<ScalarData*>::const_iterator scalar = scalars.begin(); scalar != scalars.end(); ++scalar)
+        out += (*scalar)->getScalarCount() * sizeof(GLfloat);
+
+    return out;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Maps each point to the point with the lowest index within epsilon;
+ * chains are resolved, so the result maps to points which map to themselves.
+ */
+void MeshWelder::findRepresentatives(const std::vector<glm::vec3>& points,
+                                     std::vector<GLuint>& representatives) const
+{
+    const size_t count = points.size();
+
+    std::vector<uint64_t> keys(count);
+    std::vector<uint32_t> ids(count);
+
+    const double scale = m_epsilon > 0.0f ? 1.0 / m_epsilon : 0.0;
+
+    parallelFor(0, count, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            ids[i] = i;
+
+            if (m_epsilon > 0.0f)
+                keys[i] = hashCell((int64_t) std::floor(points[i].x * scale),
+                                   (int64_t) std::floor(points[i].y * scale),
+                                   (int64_t) std::floor(points[i].z * scale));
+            else
+                keys[i] = hashPosition(points[i]);
+        }
+    });
+
+    parallelRadixSort(keys, ids);
+
+    const float epsilon2 = m_epsilon * m_epsilon;
+    const int   reach    = m_epsilon > 0.0f ? 1 : 0;
+
+    representatives.resize(count);
+
+    parallelFor(0, count, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::vec3& point = points[i];
+            GLuint best = i;
+
+            for (int dz = -reach; dz <= reach; ++dz)
+            for (int dy = -reach; dy <= reach; ++dy)
+            for (int dx = -reach; dx <= reach; ++dx)
+            {
+                const uint64_t key = m_epsilon > 0.0f
+                        ? hashCell((int64_t) std::floor(point.x * scale) + dx,
+                                   (int64_t) std::floor(point.y * scale) + dy,
+                                   (int64_t) std::floor(point.z * scale) + dz)
+                        : hashPosition(point);
+
+                // hash collisions only add candidates, the distance decides
+                const std::pair<std::vector<uint64_t>::const_iterator, std::vector<uint64_t>::const_iterator> range =
+                        std::equal_range(keys.begin(), keys.end(), key);
+
+                for (std::vector<uint64_t>::const_iterator candidate = range.first; candidate != range.second; ++candidate)
+                {
+                    const GLuint other = ids[candidate - keys.begin()];
+                    if (other >= best)
+                        continue;
+
+                    const glm::vec3 delta = points[other] - point;
+                    if (glm::dot(delta, delta) <= epsilon2)
+                        best = other;
+                }
+            }
+
+            representatives[i] = best;
+        }
+    }, 4096);
+
+    // representatives have lower indices, so one pass resolves all chains
+    for (size_t i = 0; i < count; ++i)
+        representatives[i] = representatives[representatives[i]];
+}
+
+// -------------------------------------------------------------------------
+
+MeshWelder::Statistics MeshWelder::weld(MeshData& data, const std::vector<ScalarData*>& scalars)
+{
+    const GLsizei pointCount = data.getPointCount();
+
+    Statistics out;
+    out.pointsBefore    = pointCount;
+    out.trianglesBefore = data.getTriangleCount();
+    out.bytesBefore     = meshBytes(out.pointsBefore, out.trianglesBefore, scalars);
+
+    const std::vector<glm::vec3>& points = data.getPoints();
+
+    std::vector<GLuint> representatives;
+    findRepresentatives(points, representatives);
+
+    // drop degenerate triangles
+    std::vector<glm::uvec3> triangles;
+    triangles.reserve(data.getTriangleCount());
+
+    for (GLsizei triangleId = 0; triangleId < data.getTriangleCount(); ++triangleId)
+    {
+        const glm::uvec3& source = data.getTriangle(triangleId);
+        const glm::uvec3  triangle(representatives[source.x], representatives[source.y], representatives[source.z]);
+
+        if (triangle.x == triangle.y || triangle.y == triangle.z || triangle.z == triangle.x)
+            continue;
+
+        const glm::vec3 normal = glm::cross(points[triangle.y] - points[triangle.x],
+                                            points[triangle.z] - points[triangle.x]);
+        if (normal == glm::vec3(0.0f))
+            continue;
+
+        triangles.push_back(triangle);
+    }
+
+    // drop duplicates, comparing triangles rotated to start at their lowest index
+    {
+        std::vector<uint64_t> keys(triangles.size());
+        std::vector<uint32_t> order(triangles.size());
+        std::vector<glm::uvec3> rotated(triangles.size());
+
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            glm::uvec3 triangle = triangles[i];
+            while (triangle.x > triangle.y || triangle.x > triangle.z)
+                triangle = glm::uvec3(triangle.y, triangle.z, triangle.x);
+
+            rotated[i] = triangle;
+            keys[i]    = mix((uint64_t) triangle.x << 32 | triangle.y) ^ triangle.z;
+            order[i]   = i;
+        }
+
+        // stable, so the first of equal triangles comes first
+        parallelRadixSort(keys, order);
+
+        std::vector<char> duplicate(triangles.size(), 0);
+        for (size_t begin = 0, end = 0; begin < keys.size(); begin = end)
+        {
+            while (end < keys.size() && keys[end] == keys[begin])
+                ++end;
+
+            for (size_t i = begin; i < end; ++i)
+                for (size_t j = begin; j < i && !duplicate[order[i]]; ++j)
+                    if (!duplicate[order[j]] && rotated[order[i]] == rotated[order[j]])
+                        duplicate[order[i]] = 1;
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < triangles.size(); ++i)
+            if (!duplicate[i])
+                triangles[kept++] = triangles[i];
+
+        triangles.resize(kept);
+    }
+
+    // drop unreferenced points
+    std::vector<char> used(pointCount, 0);
+    for (std::vector<glm::uvec3>::const_iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+        used[triangle->x] = used[triangle->y] = used[triangle->z] = 1;
+
+    m_vertexRemap.assign(pointCount, NONE);
+
+    std::vector<glm::vec3> welded;
+    for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+    {
+        if (!used[pointId])
+            continue;
+
+        m_vertexRemap[pointId] = welded.size();
+        welded.push_back(points[pointId]);
+    }
+
+    for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+        m_vertexRemap[pointId] = m_vertexRemap[representatives[pointId]];
+
+    for (std::vector<glm::uvec3>::iterator triangle = triangles.begin(); triangle != triangles.end(); ++triangle)
+        *triangle = glm::uvec3(m_vertexRemap[triangle->x], m_vertexRemap[triangle->y], m_vertexRemap[triangle->z]);
+
+    for (std::vector<ScalarData*>::const_iterator scalar = scalars.begin(); scalar != scalars.end(); ++scalar)
+    {
+        if ((*scalar)->getScalarCount() != pointCount)
+        {
+            std::cerr << "MeshWelder: scalar count does not match the point count, not remapped" << std::endl;
+            continue;
+        }
+
+        std::vector<GLfloat> values(welded.size());
+        for (GLsizei pointId = 0; pointId < pointCount; ++pointId)
+            if (used[pointId])
+                values[m_vertexRemap[pointId]] = (*scalar)->getScalar(pointId);
+
+        (*scalar)->setAllScalars(values);
+    }
+
+    data.setPoints(welded);
+    data.setTriangles(triangles);
+
+    out.pointsAfter    = data.getPointCount();
+    out.trianglesAfter = data.getTriangleCount();
+    out.bytesAfter     = meshBytes(out.pointsAfter, out.trianglesAfter, scalars);
+
+    return out;
+}
+
+} // namespace ugl
@@ -0,0 +1,105 @@
+/** @file Parallel.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/Parallel.hpp"
+
+namespace ugl
+{
+
+/**
+ * @brief Sorts keys ascending and permutes values alongside (stable LSD radix
+ * sort with 8-bit digits).
+ *
+ * Each pass counts the digits per chunk in parallel and scatters the chunks
+ * in parallel to their prefix-summed offsets. Digits which are the same for
+ * all keys are skipped, so small keys take fewer passes.
+ */
+void parallelRadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+{
+    const size_t count = keys.size();
+    if (count < 2u)
+        return;
+
+    const size_t grain     = 65536u;
+    const size_t chunks    = std::max<size_t>(1u, std::min<size_t>(getThreadCount(), count / grain));
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+
+    // bits which differ between any two keys
+    std::vector<uint64_t> chunkOr(chunks, 0u), chunkAnd(chunks, ~uint64_t(0));
+    parallelFor(0u, chunks, [&](size_t chunkBegin, size_t chunkEnd)
+    {
+        for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+            for (size_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); ++i)
+            {
+                chunkOr[chunk]  |= keys[i];
+                chunkAnd[chunk] &= keys[i];
+            }
+    }, 1u);
+
+    uint64_t varying = 0u;
+    for (size_t chunk = 0u; chunk < chunks; ++chunk)
+        varying |= chunkOr[chunk] ^ chunkAnd[chunk];
+
+    std::vector<uint64_t> keyBuffer(count);
+    std::vector<uint32_t> valueBuffer(count);
+    std::vector<size_t>   offsets(chunks * 256u);
+
+    for (unsigned int shift = 0u; shift < 64u; shift += 8u)
+    {
+        if (((varying >> shift) & 0xffu) == 0u)
+            continue;
+
+        // count digits per chunk
+        std::fill(offsets.begin(), offsets.end(), 0u);
+        parallelFor(0u, chunks, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+                for (size_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); ++i)
+                    ++offsets[chunk * 256u + ((keys[i] >> shift) & 0xffu)];
+        }, 1u);
+
+        // exclusive prefix sum over (digit, chunk), which keeps the sort stable
+        size_t sum = 0u;
+        for (size_t digit = 0u; digit < 256u; ++digit)
+            for (size_t chunk = 0u; chunk < chunks; ++chunk)
+            {
+                const size_t digitCount = offsets[chunk * 256u + digit];
+                offsets[chunk * 256u + digit] = sum;
+                sum += digitCount;
+            }
+
+        parallelFor(0u, chunks, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+                for (size_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); ++i)
+                {
+                    const size_t target = offsets[chunk * 256u + ((keys[i] >> shift) & 0xffu)]++;
+                    keyBuffer[target]   = keys[i];
+                    valueBuffer[target] = values[i];
+                }
+        }, 1u);
+
+        keys.swap(keyBuffer);
+        values.swap(valueBuffer);
+    }
+}
+
+} // namespace ugl
@@ -0,0 +1,133 @@
+/** @file Picker.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/Picker.hpp"
+
+#include <limits>
+
+namespace ugl
+{
+
+void Picker::add(const Drawable* drawable, const MeshData& data)
+{
+    Entry entry;
+    entry.drawable = drawable;
+    entry.data     = &data;
+    entry.bvh.build(data);
+
+    m_entries.push_back(entry);
+}
+
+// -------------------------------------------------------------------------
+
+void Picker::remove(const Drawable* drawable)
+{
+    for (std::vector<Entry>::iterator entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+    {
+        if (entry->drawable == drawable)
+        {
+            m_entries.erase(entry);
+            return;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void Picker::refit(const Drawable* drawable)
+{
+    for (std::vector<Entry>::iterator entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+        if (entry->drawable == drawable)
+            entry->bvh.refit(*entry->data);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Picks at a position in normalized device coordinates ([-1,1]^2, as
+ * the mouse coordinates of the view controllers).
+ */
+bool Picker::pick(const ViewController& view, const glm::vec2& position, Result* result) const
+{
+    return pick(view.projection(), view.transform(), position, result);
+}
+
+// -------------------------------------------------------------------------
+
+bool Picker::pick(const glm::mat4& projection, const glm::mat4& modelview,
+                  const glm::vec2& position, Result* result) const
+{
+    glm::vec3 origin, direction;
+    computeRay(projection, modelview, position, &origin, &direction);
+
+    return intersect(origin, direction, result);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Finds the closest hit of all registered meshes; direction should be
+ * normalized for the distance to be in world units.
+ */
+bool Picker::intersect(const glm::vec3& origin, const glm::vec3& direction, Result* result) const
+{
+    bool found = false;
+    float closest = std::numeric_limits<float>::max();
+
+    for (std::vector<Entry>::const_iterator entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+    {
+        TriangleBVH::Hit hit;
+
+        if (entry->drawable->isVisible() && entry->bvh.intersect(*entry->data, origin, direction, &hit, closest))
+        {
+            closest = hit.distance;
+            found   = true;
+
+            result->drawable     = entry->drawable;
+            result->triangle     = hit.triangle;
+            result->barycentrics = hit.barycentrics;
+            result->distance     = hit.distance;
+            result->position     = origin + hit.distance * direction;
+        }
+    }
+
+    return found;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Unprojects a position in normalized device coordinates to a ray in
+ * world coordinates starting at the near plane.
+ */
+void Picker::computeRay(const glm::mat4& projection, const glm::mat4& modelview,
+                        const glm::vec2& position, glm::vec3* origin, glm::vec3* direction)
+{
+    const glm::mat4 inverse = glm::inverse(projection * modelview);
+
+    const glm::vec4 nearPoint = inverse * glm::vec4(position.x, position.y, -1.0f, 1.0f);
+    const glm::vec4 farPoint  = inverse * glm::vec4(position.x, position.y,  1.0f, 1.0f);
+
+    *origin    = glm::vec3(nearPoint) / nearPoint.w;
+    *direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - *origin);
+}
+
+} // namespace ugl
@@ -0,0 +1,234 @@
+/** @file RenderQueue.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/RenderQueue.hpp"
+#include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ugl
+{
+
+namespace
+{
+
+/// orders packets by program, then vertex array, then textures
+bool comparePackets(const DrawPacket* a, const DrawPacket* b)
+{
+    if (a->program->programId() != b->program->programId())
+        return a->program->programId() < b->program->programId();
+
+    if (a->vertexArray != b->vertexArray)
+        return a->vertexArray < b->vertexArray;
+
+    return a->textureHash < b->textureHash;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+RenderQueue::RenderQueue() :
+    m_sorting(true)
+{
+    std::memset(&m_recorded, 0, sizeof(m_recorded));
+    std::memset(&m_executed, 0, sizeof(m_executed));
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Resolves program variant, uniforms and texture state of a StateSet
+ * into a packet without draw arguments.
+ */
+DrawPacket RenderQueue::makePacket(const StateSet& state, VariantProgram& program,
+                                   GLuint vertexArray) const
+{
+    DrawPacket packet;
+    std::memset(&packet, 0, sizeof(packet));
+
+    packet.program     = &state.getProgram(program);
+    packet.uniforms    = state.getUniforms();
+    packet.vertexArray = vertexArray;
+
+    if (packet.uniforms)
+        packet.textureHash = packet.uniforms->getTextureHash(*packet.program);
+
+    return packet;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Records a glDrawArrays() call with the program variant and uniforms
+ * of the given StateSet.
+ */
+void RenderQueue::drawArrays(const StateSet& state, VariantProgram& program,
+                             GLuint vertexArray, GLenum mode, GLint first, GLsizei count)
+{
+    DrawPacket packet = makePacket(state, program, vertexArray);
+    packet.mode  = mode;
+    packet.first = first;
+    packet.count = count;
+
+    add(packet);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Records a glDrawElements() call (glDrawElementsInstanced() if
+ * instanceCount > 0) with the program variant and uniforms of the given
+ * StateSet.
+ */
+void RenderQueue::drawElements(const StateSet& state, VariantProgram& program,
+                               GLuint vertexArray, GLuint elementBuffer, GLenum mode,
+                               GLsizei count, GLenum type, const GLvoid* indices,
+                               GLsizei instanceCount)
+{
+    DrawPacket packet = makePacket(state, program, vertexArray);
+    packet.elementBuffer = elementBuffer;
+    packet.mode          = mode;
+    packet.count         = count;
+    packet.indexType     = type;
+    packet.indices       = indices;
+    packet.instanceCount = instanceCount;
+
+    add(packet);
+}
+
+// -------------------------------------------------------------------------
+
+void RenderQueue::add(const DrawPacket& packet)
+{
+    m_packets.push_back(packet);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Counts how often program, vertex array and textures change when
+ * drawing the packets in the given order.
+ */
+RenderQueue::Statistics RenderQueue::countChanges(const std::vector<const DrawPacket*>& packets)
+{
+    Statistics out;
+    std::memset(&out, 0, sizeof(out));
+
+    const DrawPacket* previous = nullptr;
+    for (std::vector<const DrawPacket*>::const_iterator it = packets.begin(); it != packets.end(); ++it)
+    {
+        const DrawPacket* packet = *it;
+
+        if (!previous || previous->program != packet->program)
+            ++out.programChanges;
+        if (!previous || previous->vertexArray != packet->vertexArray)
+            ++out.vertexArrayChanges;
+        if (!previous || previous->textureHash != packet->textureHash)
+            ++out.textureChanges;
+
+        previous = packet;
+    }
+
+    out.packets = packets.size();
+
+    return out;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Sorts (if enabled) and issues all recorded packets, then clears the
+ * queue.
+ */
+void RenderQueue::execute()
+{
+    m_order.clear();
+    for (std::vector<DrawPacket>::const_iterator packet = m_packets.begin(); packet != m_packets.end(); ++packet)
+        m_order.push_back(&*packet);
+
+    m_recorded = countChanges(m_order);
+
+    // stable, so packets with equal state keep their recording order
+    if (m_sorting)
+        std::stable_sort(m_order.begin(), m_order.end(), comparePackets);
+
+    m_executed = countChanges(m_order);
+
+    GLState& state = GLState::getInstance();
+
+    const ShaderProgram* currentProgram  = nullptr;
+    const UniformSet*    currentUniforms = nullptr;
+
+    for (std::vector<const DrawPacket*>::const_iterator it = m_order.begin(); it != m_order.end(); ++it)
+    {
+        const DrawPacket& packet = **it;
+
+        if (packet.program != currentProgram)
+        {
+            packet.program->bind();
+            currentProgram  = packet.program;
+            currentUniforms = nullptr;
+        }
+
+        // uniforms do not change while the queue executes, so consecutive
+        // packets sharing program and uniforms need no upload
+        if (packet.uniforms && packet.uniforms != currentUniforms)
+        {
+            packet.uniforms->apply(*packet.program);
+            currentUniforms = packet.uniforms;
+        }
+
+        state.bindVertexArray(packet.vertexArray);
+
+        if (packet.elementBuffer != 0u)
+        {
+            state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, packet.elementBuffer);
+
+            if (packet.instanceCount > 0)
+                glDrawElementsInstanced(packet.mode, packet.count, packet.indexType,
+                                        packet.indices, packet.instanceCount);
+            else
+                glDrawElements(packet.mode, packet.count, packet.indexType, packet.indices);
+        }
+        else
+        {
+            glDrawArrays(packet.mode, packet.first, packet.count);
+        }
+    }
+
+    state.bindVertexArray(0u);
+    checkGLError();
+
+    clear();
+}
+
+// -------------------------------------------------------------------------
+
+void RenderQueue::clear()
+{
+    m_packets.clear();
+    m_order.clear();
+}
+
+} // namespace ugl
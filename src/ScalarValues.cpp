@@ -20,38 +20,55 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/ScalarValues.hpp"
-#include "ugl/GLHelper.hpp"
+#include "ugl/GLState.hpp"
 #include "ugl/ModeSet.hpp"
 
+#include <iostream>
+
 namespace ugl
 {
 
 // -------------------------------------------------------------------------
 
 ScalarValues::ScalarValues(ScalarData& data) :
-    m_vertexScalarBuffer(GLHelper::prepareStaticBuffer(data.getAllScalars())),
+    m_vertexScalarBuffer(BufferPool::getInstance().allocate(data.getAllScalars(), this)),
+    m_vertexScalarLocation(-1),
+    m_scalarCount(data.getScalarCount()),
     m_min(data.getMin()),
     m_max(data.getMax()),
     m_showScalars(false),
     m_minColor(1.0f, 0.0f, 0.0f),
     m_maxColor(0.0f, 1.0f, 0.0f)
 {
+    data.clearDirty();
+}
+
+// -------------------------------------------------------------------------
+
+ScalarValues::~ScalarValues()
+{
+    BufferPool::getInstance().releaseAll(this);
 }
 
 // -------------------------------------------------------------------------
 
 void ScalarValues::initialize(StateSet& stateSet, VariantProgram& program)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexScalarBuffer);
+    const BufferPool& pool = BufferPool::getInstance();
+
+    GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, pool.get(m_vertexScalarBuffer).buffer);
 
-    const GLuint vertexScalarLocation = program.getUnusedAttributeLocation();
-    program.addAttributeLocation("vertexScalar", vertexScalarLocation);
+    if (m_vertexScalarLocation < 0)
+    {
+        m_vertexScalarLocation = program.getUnusedAttributeLocation();
+        program.addAttributeLocation("vertexScalar", m_vertexScalarLocation);
+    }
 
-    glVertexAttribPointer(vertexScalarLocation, 1, GL_FLOAT,
-                          GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(vertexScalarLocation);
+    glVertexAttribPointer(m_vertexScalarLocation, 1, GL_FLOAT,
+                          GL_FALSE, 0, pool.getOffsetPointer(m_vertexScalarBuffer));
+    glEnableVertexAttribArray(m_vertexScalarLocation);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0u);
+    GLState::getInstance().bindBuffer(GL_ARRAY_BUFFER, 0u);
 
     UniformSet& uniforms = stateSet.getOrCreateUniforms();
     uniforms.set("scalarsMin", m_min);
@@ -80,6 +97,38 @@ void ScalarValues::extendDraw(StateSet& stateSet)
 
     uniforms.set("minColor", m_minColor);
     uniforms.set("maxColor", m_maxColor);
+    uniforms.set("scalarsMin", m_min);
+    uniforms.set("scalarsMax", m_max);
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Uploads the scalars changed since the last update and adapts the
+ * value range. The number of scalars must not change.
+ */
+void ScalarValues::update(ScalarData& data)
+{
+    if (data.getScalarCount() != m_scalarCount)
+    {
+        std::cerr << "ScalarValues: the number of scalars changed, not updated" << std::endl;
+        return;
+    }
+
+    const GLint first = data.getDirtyFirst();
+    const GLint last  = data.getDirtyLast();
+
+    if (first < last)
+    {
+        BufferPool::getInstance().upload(m_vertexScalarBuffer, first * sizeof(GLfloat),
+                                         (last - first) * sizeof(GLfloat),
+                                         &data.getAllScalars()[first]);
+
+        m_min = data.getMin();
+        m_max = data.getMax();
+    }
+
+    data.clearDirty();
 }
 
 } // namespace ugl
@@ -20,6 +20,9 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 */
 
 #include "ugl/ShaderProgram.hpp"
+#include "ugl/GlobalUniformBlock.hpp"
+#include "ugl/UniformHandle.hpp"
+#include "ugl/Utils.hpp"
 
 #include <iostream>
 
@@ -53,9 +56,125 @@ bool ShaderProgram::link()
 {
     glLinkProgram(m_program);
 
-    return checkStatus(m_program, GL_LINK_STATUS,
+    bool success = checkStatus(m_program, GL_LINK_STATUS,
            "Could not link shader program",
            glGetProgramiv, glGetProgramInfoLog);
+
+    // all programs read the globals from the same uniform buffer
+    if (success)
+        GlobalUniformBlock::bindProgram(m_program);
+
+    queryActiveUniforms();
+    m_generation = nextGeneration();
+
+    return success;
+}
+
+// -------------------------------------------------------------------------
+
+void ShaderProgram::queryActiveUniforms()
+{
+    m_activeUniforms.clear();
+    m_bindlessTextures = GLState::getInstance().isBindlessTexturesEnabled();
+
+    GLint status;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+        return;
+
+    GLint nuniform;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &nuniform);
+
+    GLint maxlen;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen);
+
+    std::vector<GLchar> name(maxlen + 1);
+    GLint nextUnit = 0;
+
+    for (GLint index = 0; index < nuniform; ++index)
+    {
+        ActiveUniform uniform;
+
+        glGetActiveUniform(m_program, index, maxlen, nullptr,
+                           &uniform.size, &uniform.type, name.data());
+
+        // members of uniform blocks (e.g. the globals) have no location
+        uniform.location = glGetUniformLocation(m_program, name.data());
+        if (uniform.location < 0)
+            continue;
+
+        // samplers keep their texture units for the lifetime of the program,
+        // so that applying a UniformSet only has to bind textures
+        uniform.unit = -1;
+        if (isSamplerType(uniform.type) && !m_bindlessTextures)
+        {
+            std::vector<GLint> units(uniform.size);
+            for (GLsizei i = 0; i < uniform.size; ++i)
+                units[i] = nextUnit + i;
+
+            glProgramUniform1iv(m_program, uniform.location, uniform.size, units.data());
+
+            uniform.unit = nextUnit;
+            nextUnit += uniform.size;
+        }
+
+        uniform.name = internUniformName(name.data());
+        m_activeUniforms.push_back(uniform);
+    }
+
+    m_textureHandles.assign(m_activeUniforms.size(), 0u);
+}
+
+// -------------------------------------------------------------------------
+
+bool ShaderProgram::isSamplerType(GLenum type)
+{
+    switch (type)
+    {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+    case GL_INT_SAMPLER_1D:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_SAMPLER_1D_ARRAY:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D_RECT:
+    case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_1D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+        return true;
+    default:
+        return false;
+    }
 }
 
 // -------------------------------------------------------------------------
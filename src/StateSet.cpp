@@ -22,15 +22,30 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 #include "ugl/StateSet.hpp"
 #include "ugl/ErrorCheck.hpp"
 
+#include <algorithm>
+
 namespace ugl
 {
 
 StateSet::StateSet() :
-    m_parent(nullptr)
+    m_parent(nullptr),
+    m_generation(nextGeneration()),
+    m_resolvedUniforms(nullptr),
+    m_resolvedModes(nullptr),
+    m_resolvedViewport(nullptr),
+    m_resolvedGeneration(0u),
+    m_resolvedOwner(nullptr)
 {
 }
 
-StateSet::StateSet(const StateSet& parent)
+StateSet::StateSet(const StateSet& parent) :
+    m_parent(nullptr),
+    m_generation(nextGeneration()),
+    m_resolvedUniforms(nullptr),
+    m_resolvedModes(nullptr),
+    m_resolvedViewport(nullptr),
+    m_resolvedGeneration(0u),
+    m_resolvedOwner(nullptr)
 {
     this->setParent(parent);
 }
@@ -38,21 +53,51 @@ StateSet::StateSet(const StateSet& parent)
 
 // ------------------------------------------------------------------------
 
-template <typename T>
-const T* StateSet::getMember(
-        std::function<const boost::optional<T>& (const StateSet*)> member) const
+/**
+ * @brief Returns the newest generation of this StateSet and its parents.
+ */
+unsigned long StateSet::getGeneration() const
+{
+    unsigned long out = 0u;
+
+    for (const StateSet* stateSet = this; stateSet; stateSet = stateSet->m_parent)
+        out = std::max(out, stateSet->m_generation);
+
+    return out;
+}
+
+// ------------------------------------------------------------------------
+
+/**
+ * @brief Looks up the closest uniforms, modes and viewport in the hierarchy,
+ * unless the cached result is still valid.
+ */
+void StateSet::resolve() const
 {
-    const StateSet* stateSet = this;
+    const unsigned long generation = getGeneration();
+
+    // the owner check catches caches copied along with the StateSet
+    if (m_resolvedOwner == this && m_resolvedGeneration == generation)
+        return;
+
+    m_resolvedUniforms = nullptr;
+    m_resolvedModes    = nullptr;
+    m_resolvedViewport = nullptr;
 
-    do
+    for (const StateSet* stateSet = this; stateSet; stateSet = stateSet->m_parent)
     {
-        if (member(stateSet))
-            return member(stateSet).get_ptr();
+        if (!m_resolvedUniforms && stateSet->m_uniforms)
+            m_resolvedUniforms = stateSet->m_uniforms.get_ptr();
 
-        stateSet = stateSet->m_parent;
-    } while (stateSet);
+        if (!m_resolvedModes && stateSet->m_modes)
+            m_resolvedModes = stateSet->m_modes.get_ptr();
 
-    return nullptr;
+        if (!m_resolvedViewport && stateSet->m_viewport)
+            m_resolvedViewport = stateSet->m_viewport.get_ptr();
+    }
+
+    m_resolvedGeneration = generation;
+    m_resolvedOwner      = this;
 }
 
 // ------------------------------------------------------------------------
@@ -68,7 +113,7 @@ ShaderProgram& StateSet::apply(VariantProgram& program) const
 
     const UniformSet* uniforms = getUniforms();
     if (uniforms)
-        uniforms->apply(compiled_program->programId());
+        uniforms->apply(*compiled_program);
 
     checkGLError();
 
@@ -77,29 +122,41 @@ ShaderProgram& StateSet::apply(VariantProgram& program) const
 
 // ------------------------------------------------------------------------
 
+/**
+ * @brief Returns the variant of the program selected by the modes of this
+ * StateSet, without binding it or applying uniforms.
+ */
+ShaderProgram& StateSet::getProgram(VariantProgram& program) const
+{
+    const ModeSet* modes = getModes();
+    if (modes)
+        return modes->getProgram(program);
+    else
+        return program.getProgram(VariantProgram::DefineMap());
+}
+
+// ------------------------------------------------------------------------
+
 const UniformSet* StateSet::getUniforms() const
 {
-    return getMember<UniformSet>(
-            [](const StateSet* stateSet) -> const boost::optional<UniformSet>&
-            {return stateSet->m_uniforms;});
+    resolve();
+    return m_resolvedUniforms;
 }
 
 // ------------------------------------------------------------------------
 
 const ModeSet* StateSet::getModes() const
 {
-    return getMember<ModeSet>(
-            [](const StateSet* stateSet) -> const boost::optional<ModeSet>&
-            {return stateSet->m_modes;});
+    resolve();
+    return m_resolvedModes;
 }
 
 // ------------------------------------------------------------------------
 
 const glm::uvec4* StateSet::getViewport() const
 {
-    return getMember<glm::uvec4>(
-            [](const StateSet* stateSet) -> const boost::optional<glm::uvec4>&
-            {return stateSet->m_viewport;});
+    resolve();
+    return m_resolvedViewport;
 }
 
 } // namespace ugl
@@ -21,6 +21,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/TransparentRenderStage.hpp"
 #include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -33,7 +34,7 @@ namespace ugl
  * @brief Constructor.
  * @param numSamples
  */
-TransparentRenderStage::TransparentRenderStage(unsigned int numSamples, unsigned int maxPasses, unsigned int samplesThreshold) : volume(0), samplesThreshold(samplesThreshold)
+TransparentRenderStage::TransparentRenderStage(unsigned int numSamples, unsigned int maxPasses, unsigned int samplesThreshold) : volume(0), samplesThreshold(samplesThreshold), recording(false), culling(true), hasCamera(false)
 {
     this->setNumSamples(numSamples);
     this->setMaxPasses(maxPasses);
@@ -78,8 +79,8 @@ void TransparentRenderStage::resize( unsigned int width, unsigned int height )
     }
 
     // Restore state
-    glBindTexture(this->textureTarget, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::getInstance().bindTexture(this->textureTarget, 0);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // Remember values
     this->width  = width;
@@ -115,12 +116,12 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
     for (unsigned int i = 0; i < 2; ++i)
     {
         // Target buffer
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->targetBuffers[i].getFramebuffer());
+        GLState::getInstance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, this->targetBuffers[i].getFramebuffer());
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Peel buffer
-        glBindFramebuffer(GL_FRAMEBUFFER, this->peelBuffers[i].getFramebuffer());
+        GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, this->peelBuffers[i].getFramebuffer());
         glClearDepth(0.0);
         glClear(GL_DEPTH_BUFFER_BIT);
     }
@@ -133,14 +134,23 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
 
     if (this->numSamples > 0)
     {
-        glEnable(GL_SAMPLE_SHADING);
+        GLState::getInstance().enable(GL_SAMPLE_SHADING);
         glMinSampleShading(1.0f);
     }
     else
     {
-        glDisable(GL_SAMPLE_SHADING);
+        GLState::getInstance().disable(GL_SAMPLE_SHADING);
     }
 
+    // Cull once for all peel passes
+    Frustum frustum;
+    if (this->culling && this->hasCamera)
+        frustum = this->camera;
+    else if (this->culling)
+        frustum.setFromStateSet(this->stateSet);
+
+    this->hierarchy.cull(this->drawables, frustum, this->visibleDrawables);
+
     // Perform peeling
     Framebuffer* resultBuffer = 0;
     for(unsigned int peelPass = 0; peelPass < this->maxPasses; ++peelPass)
@@ -151,12 +161,13 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
         /*
          * Render to peel target
          */
-        glDisable(GL_BLEND);
-        glDisable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
+        pushGLDebugGroup("Depth peeling: peel");
+        GLState::getInstance().disable(GL_BLEND);
+        GLState::getInstance().disable(GL_CULL_FACE);
+        GLState::getInstance().enable(GL_DEPTH_TEST);
 
         // Render target
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->peelBuffers[peelPass % 2].getFramebuffer());
+        GLState::getInstance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, this->peelBuffers[peelPass % 2].getFramebuffer());
 
         // Discard source
         this->stateSet.getOrCreateUniforms().setTexture("depthPeeling.discardDepth", this->textureTarget, this->peelBuffers[(peelPass + 1) % 2].getDepthTexture());
@@ -168,9 +179,23 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
         glBeginQuery(GL_SAMPLES_PASSED, query);
 
         // Drawables
-        for(std::vector<Drawable*>::iterator drawable = this->drawables.begin(); drawable != this->drawables.end(); ++drawable)
-            if ((*drawable)->isVisible())
+        if (this->recording)
+        {
+            std::vector<Drawable*> immediate;
+            for(std::vector<Drawable*>::iterator drawable = this->visibleDrawables.begin(); drawable != this->visibleDrawables.end(); ++drawable)
+                if (!(*drawable)->record(this->stateSet, this->renderQueue))
+                    immediate.push_back(*drawable);
+
+            this->renderQueue.execute();
+
+            for(std::vector<Drawable*>::iterator drawable = immediate.begin(); drawable != immediate.end(); ++drawable)
                 (*drawable)->draw(this->stateSet);
+        }
+        else
+        {
+            for(std::vector<Drawable*>::iterator drawable = this->visibleDrawables.begin(); drawable != this->visibleDrawables.end(); ++drawable)
+                (*drawable)->draw(this->stateSet);
+        }
 
         // Volume rendering bounding box (depth only)
         if (this->volume != 0 && this->volume->isVisible() && this->volume->getRenderBoundingBoxDepthCube())
@@ -187,16 +212,19 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
 
         lastPass = (peelPass == (this->maxPasses - 1)) || (samples < this->samplesThreshold);
 
+        popGLDebugGroup();
+
 
         /*
          * Blend the peel color buffer into the target framebuffer
          */
+        pushGLDebugGroup("Depth peeling: blend");
         resultBuffer = &this->targetBuffers[peelPass % 2];
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resultBuffer->getFramebuffer());
+        GLState::getInstance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, resultBuffer->getFramebuffer());
         glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
 
-        glDisable(GL_BLEND);
-        glDisable(GL_DEPTH_TEST);
+        GLState::getInstance().disable(GL_BLEND);
+        GLState::getInstance().disable(GL_DEPTH_TEST);
 
         ModeSet& modes = this->stateSet.getOrCreateModes();
         UniformSet& uniforms = this->stateSet.getOrCreateUniforms();
@@ -249,21 +277,23 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
 
         checkGLError();
 
-        glBindVertexArray(this->fullScreenQuadVAO);
+        GLState::getInstance().bindVertexArray(this->fullScreenQuadVAO);
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        glBindVertexArray(0);
+        GLState::getInstance().bindVertexArray(0);
 
         checkGLError();
 
+        popGLDebugGroup();
+
         if(lastPass)
             break;
     }
 
     if (this->numSamples > 0)
-        glDisable(GL_SAMPLE_SHADING);
+        GLState::getInstance().disable(GL_SAMPLE_SHADING);
 
     glDeleteQueries(1, &query);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // Return target buffer
     return *resultBuffer;
@@ -277,6 +307,7 @@ Framebuffer& TransparentRenderStage::drawOffscreen(const StateSet& state)
 void TransparentRenderStage::addDrawable(Drawable* drawable)
 {
     this->drawables.push_back(drawable);
+    this->hierarchy.invalidate();
 }
 
 /**
@@ -286,6 +317,7 @@ void TransparentRenderStage::addDrawable(Drawable* drawable)
 void TransparentRenderStage::removeDrawable(Drawable* drawable)
 {
     this->drawables.erase(std::remove(this->drawables.begin(), this->drawables.end(), drawable), this->drawables.end());
+    this->hierarchy.invalidate();
 }
 
 /**
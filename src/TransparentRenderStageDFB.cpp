@@ -21,6 +21,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/TransparentRenderStageDFB.hpp"
 #include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -50,9 +51,9 @@ TransparentRenderStageDFB::TransparentRenderStageDFB() : width(0), height(0)
     glGenBuffers(1, &this->fragmentBuffer);
 
     glGenBuffers(1, &this->numFragmentsBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->numFragmentsBuffer);
+    GLState::getInstance().bindBuffer(GL_SHADER_STORAGE_BUFFER, this->numFragmentsBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint), 0, GL_DYNAMIC_READ);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GLState::getInstance().bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
     // Initialize full screen quad
     glGenVertexArrays(1, &this->fullScreenQuadVAO);
@@ -76,11 +77,11 @@ TransparentRenderStageDFB::TransparentRenderStageDFB() : width(0), height(0)
  */
 TransparentRenderStageDFB::~TransparentRenderStageDFB()
 {
-    glDeleteVertexArrays(1, &this->fullScreenQuadVAO);
-    glDeleteBuffers(1, &this->fragmentBuffer);
-    glDeleteBuffers(1, &this->numFragmentsBuffer);
-    glDeleteTextures(1, &this->offsetBuffer);
-    glDeleteTextures(1, &this->countingBuffer);
+    GLState::getInstance().deleteVertexArrays(1, &this->fullScreenQuadVAO);
+    GLState::getInstance().deleteBuffers(1, &this->fragmentBuffer);
+    GLState::getInstance().deleteBuffers(1, &this->numFragmentsBuffer);
+    GLState::getInstance().deleteTextures(1, &this->offsetBuffer);
+    GLState::getInstance().deleteTextures(1, &this->countingBuffer);
 }
 
 
@@ -119,7 +120,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
     modes.set("DYNAMIC_FRAGMENT_BUFFER", 1);
 
 
-    glDisable(GL_DEPTH_TEST);
+    GLState::getInstance().disable(GL_DEPTH_TEST);
 
 
     // Resize buffers if necessary
@@ -138,9 +139,9 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
 
         this->stateSet.apply(this->clearProgram);
 
-        glBindVertexArray(this->fullScreenQuadVAO);
+        GLState::getInstance().bindVertexArray(this->fullScreenQuadVAO);
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        glBindVertexArray(0);
+        GLState::getInstance().bindVertexArray(0);
     }
 
     /*
@@ -162,7 +163,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
     /*
      * Compute prefix sum using compute shader.
      */
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->numFragmentsBuffer);
+    GLState::getInstance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->numFragmentsBuffer);
 
     uniforms.setImageTexture(0, this->countingBuffer, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
     uniforms.setImageTexture(1, this->offsetBuffer, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
@@ -173,7 +174,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
     // Read number of fragments
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->numFragmentsBuffer);
+    GLState::getInstance().bindBuffer(GL_SHADER_STORAGE_BUFFER, this->numFragmentsBuffer);
     GLvoid* p = glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY);
     uint numFragments;
     memcpy(&numFragments, p, sizeof(uint));
@@ -185,7 +186,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
     GLuint* countData = new GLuint[width * height];
     GLuint* offsetData = new GLuint[width * height];
 
-    glBindTexture(GL_TEXTURE_2D, this->countingBuffer);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, this->countingBuffer);
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, countData);
 
     // Compute prefix sum
@@ -200,10 +201,10 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, countData);
 
-    glBindTexture(GL_TEXTURE_2D, this->offsetBuffer);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, this->offsetBuffer);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, offsetData);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, 0);
 
     delete[] countData;
     delete[] offsetData;
@@ -214,7 +215,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
      * Render all drawables into dynamic fragment buffer
      */
     // Resize buffer
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->fragmentBuffer);
+    GLState::getInstance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->fragmentBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, numFragments * 8 * sizeof(GLfloat), 0, GL_DYNAMIC_DRAW);  // 8 floats: RGBA + depth + padding
 
     uniforms.setImageTexture(0, this->countingBuffer, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
@@ -233,7 +234,7 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
      * Sort and display fragments in dynamic fragment buffer.
      */
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->fragmentBuffer);
+    GLState::getInstance().bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->fragmentBuffer);
 
     uniforms.setImageTexture(0, this->countingBuffer, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
     uniforms.setImageTexture(1, this->offsetBuffer, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
@@ -242,12 +243,12 @@ Framebuffer& TransparentRenderStageDFB::drawOffscreen(const StateSet& state)
 
     this->stateSet.apply(this->displayProgram);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->framebuffer.getFramebuffer());
+    GLState::getInstance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, this->framebuffer.getFramebuffer());
 
-    glBindVertexArray(this->fullScreenQuadVAO);
+    GLState::getInstance().bindVertexArray(this->fullScreenQuadVAO);
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    GLState::getInstance().bindVertexArray(0);
 
     return this->framebuffer;
 }
@@ -263,22 +264,22 @@ bool TransparentRenderStageDFB::resize(unsigned int width, unsigned int height)
         return false;
 
     // Resize counting buffer
-    glBindTexture(GL_TEXTURE_2D, this->countingBuffer);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, this->countingBuffer);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, 0);
 
     // Resize offset buffer
-    glBindTexture(GL_TEXTURE_2D, this->offsetBuffer);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, this->offsetBuffer);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::getInstance().bindTexture(GL_TEXTURE_2D, 0);
 
     // Resize framebuffer
     this->framebuffer.resize(width, height, 0, GL_TEXTURE_RECTANGLE, GL_RGBA8, GL_TEXTURE_RECTANGLE, GL_DEPTH_COMPONENT32);
@@ -0,0 +1,427 @@
+/** @file TriangleBVH.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/TriangleBVH.hpp"
+#include "ugl/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ugl
+{
+
+const int TriangleBVH::BIN_COUNT;
+const int TriangleBVH::LEAF_SIZE;
+
+namespace
+{
+
+/// nodes with more triangles are binned in parallel
+const GLuint PARALLEL_BINNING = 65536u;
+
+/// relative cost of traversing a node compared to intersecting a triangle
+const float TRAVERSAL_COST = 1.0f;
+
+float surfaceArea(const BoundingBox& box)
+{
+    if (box.isEmpty())
+        return 0.0f;
+
+    const glm::vec3 extent = box.getMax() - box.getMin();
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// -------------------------------------------------------------------------
+
+struct Bin
+{
+    BoundingBox box;
+    GLuint      count;
+
+    Bin() : count(0u) {}
+};
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Slab test; returns the entry distance or a negative value on a miss.
+ */
+float intersectBox(const BoundingBox& box, const glm::vec3& origin, const glm::vec3& inverseDirection,
+                   float maxDistance)
+{
+    const glm::vec3 t0 = (box.getMin() - origin) * inverseDirection;
+    const glm::vec3 t1 = (box.getMax() - origin) * inverseDirection;
+
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar  = glm::max(t0, t1);
+
+    const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    const float exit  = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+    return entry <= exit ? entry : -1.0f;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Moller-Trumbore ray/triangle intersection.
+ */
+bool intersectTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
+                       const glm::vec3& origin, const glm::vec3& direction,
+                       float* distance, glm::vec2* barycentrics)
+{
+    const glm::vec3 e1 = p1 - p0;
+    const glm::vec3 e2 = p2 - p0;
+    const glm::vec3 p  = glm::cross(direction, e2);
+    const float determinant = glm::dot(e1, p);
+
+    if (std::abs(determinant) < std::numeric_limits<float>::epsilon() * glm::dot(e1, e1))
+        return false;
+
+    const float inverse = 1.0f / determinant;
+    const glm::vec3 s = origin - p0;
+
+    const float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    const glm::vec3 q = glm::cross(s, e1);
+    const float v = glm::dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    *distance     = glm::dot(e2, q) * inverse;
+    *barycentrics = glm::vec2(u, v);
+
+    return *distance >= 0.0f;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+void TriangleBVH::build(const MeshData& data)
+{
+    const std::vector<glm::vec3>&  points    = data.getPoints();
+    const std::vector<glm::uvec3>& triangles = data.getTriangles();
+
+    m_nodes.clear();
+    m_triangles.resize(triangles.size());
+    m_boxes.resize(triangles.size());
+    m_centroids.resize(triangles.size());
+
+    parallelFor(0u, triangles.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t triangleId = begin; triangleId < end; ++triangleId)
+        {
+            BoundingBox box;
+            for (int corner = 0; corner < 3; ++corner)
+                box.add(points[triangles[triangleId][corner]]);
+
+            m_triangles[triangleId] = triangleId;
+            m_boxes[triangleId]     = box;
+            m_centroids[triangleId] = 0.5f * (box.getMin() + box.getMax());
+        }
+    });
+
+    if (!triangles.empty())
+    {
+        m_nodes.reserve(2 * triangles.size() / LEAF_SIZE + 1);
+        buildNode(0u, triangles.size());
+    }
+
+    std::vector<BoundingBox>().swap(m_boxes);
+    std::vector<glm::vec3>().swap(m_centroids);
+}
+
+// -------------------------------------------------------------------------
+
+void TriangleBVH::computeBounds(GLuint first, GLuint count, BoundingBox* box, BoundingBox* centroidBox) const
+{
+    for (GLuint slot = first; slot < first + count; ++slot)
+    {
+        box->add(m_boxes[m_triangles[slot]]);
+        centroidBox->add(m_centroids[m_triangles[slot]]);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+GLuint TriangleBVH::buildNode(GLuint first, GLuint count)
+{
+    const GLuint index = m_nodes.size();
+    m_nodes.push_back(Node());
+
+    BoundingBox box, centroidBox;
+    computeBounds(first, count, &box, &centroidBox);
+
+    m_nodes[index].box   = box;
+    m_nodes[index].first = first;
+    m_nodes[index].count = count;
+    m_nodes[index].right = 0u;
+
+    if (count <= (GLuint) LEAF_SIZE)
+        return index;
+
+    // bin the centroids along all axes
+    const glm::vec3 extent = centroidBox.getMax() - centroidBox.getMin();
+    std::vector<Bin> bins(3 * BIN_COUNT);
+
+    const auto binOf = [&](GLuint triangleId, int axis) -> int
+    {
+        if (extent[axis] <= 0.0f)
+            return 0;
+
+        const float t = (m_centroids[triangleId][axis] - centroidBox.getMin()[axis]) / extent[axis];
+        return std::min((int) (t * BIN_COUNT), BIN_COUNT - 1);
+    };
+
+    const auto binRange = [&](size_t begin, size_t end, std::vector<Bin>& out)
+    {
+        for (size_t slot = begin; slot < end; ++slot)
+        {
+            const GLuint triangleId = m_triangles[slot];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                Bin& bin = out[axis * BIN_COUNT + binOf(triangleId, axis)];
+                bin.box.add(m_boxes[triangleId]);
+                ++bin.count;
+            }
+        }
+    };
+
+    if (count >= PARALLEL_BINNING)
+    {
+        const size_t chunks = getThreadCount();
+        std::vector< std::vector<Bin> > chunkBins(chunks, std::vector<Bin>(3 * BIN_COUNT));
+        const size_t chunkSize = (count + chunks - 1) / chunks;
+
+        parallelFor(0u, chunks, [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t chunk = chunkBegin; chunk < chunkEnd; ++chunk)
+                binRange(first + std::min<size_t>(count, chunk * chunkSize),
+                         first + std::min<size_t>(count, (chunk + 1) * chunkSize),
+                         chunkBins[chunk]);
+        }, 1u);
+
+        for (size_t chunk = 0u; chunk < chunks; ++chunk)
+            for (int bin = 0; bin < 3 * BIN_COUNT; ++bin)
+            {
+                bins[bin].box.add(chunkBins[chunk][bin].box);
+                bins[bin].count += chunkBins[chunk][bin].count;
+            }
+    }
+    else
+    {
+        binRange(first, first + count, bins);
+    }
+
+    // evaluate the SAH cost of the splits between the bins
+    float bestCost  = std::numeric_limits<float>::max();
+    int   bestAxis  = -1;
+    int   bestSplit = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.0f)
+            continue;
+
+        const Bin* axisBins = &bins[axis * BIN_COUNT];
+
+        // areas and counts of everything right of each split
+        float  rightAreas[BIN_COUNT];
+        GLuint rightCounts[BIN_COUNT];
+        BoundingBox rightBox;
+        GLuint rightCount = 0u;
+
+        for (int bin = BIN_COUNT - 1; bin > 0; --bin)
+        {
+            rightBox.add(axisBins[bin].box);
+            rightCount += axisBins[bin].count;
+            rightAreas[bin]  = surfaceArea(rightBox);
+            rightCounts[bin] = rightCount;
+        }
+
+        BoundingBox leftBox;
+        GLuint leftCount = 0u;
+
+        for (int split = 1; split < BIN_COUNT; ++split)
+        {
+            leftBox.add(axisBins[split - 1].box);
+            leftCount += axisBins[split - 1].count;
+
+            if (leftCount == 0u || rightCounts[split] == 0u)
+                continue;
+
+            const float cost = surfaceArea(leftBox) * leftCount + rightAreas[split] * rightCounts[split];
+            if (cost < bestCost)
+            {
+                bestCost  = cost;
+                bestAxis  = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    const float leafCost = surfaceArea(box) * count;
+    const float splitCost = surfaceArea(box) * TRAVERSAL_COST + bestCost;
+
+    GLuint middle = first;
+
+    if (bestAxis >= 0 && (splitCost < leafCost || count > 4u * LEAF_SIZE))
+    {
+        middle = std::partition(m_triangles.begin() + first, m_triangles.begin() + first + count,
+                                [&](GLuint triangleId) { return binOf(triangleId, bestAxis) < bestSplit; })
+                 - m_triangles.begin();
+    }
+    else if (count > 4u * LEAF_SIZE)
+    {
+        // all centroids coincide, split in the middle
+        middle = first + count / 2;
+    }
+    else
+    {
+        return index;
+    }
+
+    m_nodes[index].count = 0u;
+
+    buildNode(first, middle - first);
+    const GLuint right = buildNode(middle, first + count - middle);
+    m_nodes[index].right = right;
+
+    return index;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Updates all boxes for moved points; children follow their parents
+ * in the node array, so a backwards pass visits them first.
+ */
+void TriangleBVH::refit(const MeshData& data)
+{
+    const std::vector<glm::vec3>&  points    = data.getPoints();
+    const std::vector<glm::uvec3>& triangles = data.getTriangles();
+
+    parallelFor(0u, m_nodes.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t index = begin; index < end; ++index)
+        {
+            Node& node = m_nodes[index];
+            if (node.count == 0u)
+                continue;
+
+            node.box = BoundingBox();
+            for (GLuint slot = node.first; slot < node.first + node.count; ++slot)
+                for (int corner = 0; corner < 3; ++corner)
+                    node.box.add(points[triangles[m_triangles[slot]][corner]]);
+        }
+    });
+
+    for (size_t index = m_nodes.size(); index-- > 0u; )
+    {
+        Node& node = m_nodes[index];
+        if (node.count > 0u)
+            continue;
+
+        node.box = m_nodes[index + 1].box;
+        node.box.add(m_nodes[node.right].box);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Finds the closest triangle hit by the ray origin + t * direction
+ * with 0 <= t <= maxDistance (unbounded if negative).
+ */
+bool TriangleBVH::intersect(const MeshData& data, const glm::vec3& origin, const glm::vec3& direction,
+                            Hit* hit, float maxDistance) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    const std::vector<glm::vec3>&  points    = data.getPoints();
+    const std::vector<glm::uvec3>& triangles = data.getTriangles();
+
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = maxDistance < 0.0f ? std::numeric_limits<float>::max() : maxDistance;
+    bool found = false;
+
+    std::vector<GLuint> stack;
+    stack.reserve(64);
+
+    if (intersectBox(m_nodes.front().box, origin, inverseDirection, closest) >= 0.0f)
+        stack.push_back(0u);
+
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        const GLuint index = stack.back();
+        stack.pop_back();
+
+        if (node.count > 0u)
+        {
+            for (GLuint slot = node.first; slot < node.first + node.count; ++slot)
+            {
+                const glm::uvec3& triangle = triangles[m_triangles[slot]];
+
+                float distance;
+                glm::vec2 barycentrics;
+
+                if (intersectTriangle(points[triangle[0]], points[triangle[1]], points[triangle[2]],
+                                      origin, direction, &distance, &barycentrics)
+                    && distance < closest)
+                {
+                    closest = distance;
+                    found   = true;
+
+                    hit->triangle     = m_triangles[slot];
+                    hit->barycentrics = barycentrics;
+                    hit->distance     = distance;
+                }
+            }
+            continue;
+        }
+
+        // visit the nearer child first
+        const GLuint left  = index + 1;
+        const GLuint right = node.right;
+        const float leftEntry  = intersectBox(m_nodes[left].box,  origin, inverseDirection, closest);
+        const float rightEntry = intersectBox(m_nodes[right].box, origin, inverseDirection, closest);
+
+        if (leftEntry >= 0.0f && rightEntry >= 0.0f)
+        {
+            stack.push_back(leftEntry < rightEntry ? right : left);
+            stack.push_back(leftEntry < rightEntry ? left : right);
+        }
+        else if (leftEntry >= 0.0f)
+            stack.push_back(left);
+        else if (rightEntry >= 0.0f)
+            stack.push_back(right);
+    }
+
+    return found;
+}
+
+} // namespace ugl
@@ -0,0 +1,88 @@
+/** @file UniformHandle.cpp
+
+
+
+Copyright 2016 Computational Topology Group, University of Kaiserslautern
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+    Author(s): C.Garth, T.Biedert
+*/
+
+#include "ugl/UniformHandle.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ugl
+{
+
+namespace
+{
+
+struct UniformNameRegistry
+{
+    std::unordered_map<std::string, GLuint> ids;
+    std::vector<std::string>                names;
+};
+
+UniformNameRegistry& getRegistry()
+{
+    static UniformNameRegistry registry;
+    return registry;
+}
+
+} // anonymous namespace
+
+// -------------------------------------------------------------------------
+
+GLuint internUniformName(const std::string& name)
+{
+    UniformNameRegistry& registry = getRegistry();
+
+    std::unordered_map<std::string, GLuint>::const_iterator it =
+            registry.ids.find(name);
+    if (it != registry.ids.end())
+        return it->second;
+
+    const GLuint id = registry.names.size();
+    registry.ids.insert(std::make_pair(name, id));
+    registry.names.push_back(name);
+
+    return id;
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Looks up a name for read-only access, so that probing for names
+ * which were never set does not grow the registry.
+ */
+GLuint findUniformName(const std::string& name)
+{
+    const UniformNameRegistry& registry = getRegistry();
+
+    std::unordered_map<std::string, GLuint>::const_iterator it =
+            registry.ids.find(name);
+
+    return it != registry.ids.end() ? it->second : UNKNOWN_UNIFORM_NAME;
+}
+
+// -------------------------------------------------------------------------
+
+const std::string& getUniformName(GLuint id)
+{
+    return getRegistry().names[id];
+}
+
+} // namespace ugl
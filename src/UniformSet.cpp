@@ -21,7 +21,11 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/UniformSet.hpp"
 #include "ugl/ErrorCheck.hpp"
+#include "ugl/GLState.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
 
 namespace ugl
@@ -29,170 +33,143 @@ namespace ugl
 
 // -------------------------------------------------------------------------
 
-size_t uniformTypeSize( GLenum type )
+void UniformSet::apply( const ShaderProgram& program ) const
 {
-    switch( type )
+    for( const ResolvedUniform& uniform : resolve(program) )
     {
-    case GL_FLOAT:              return 1*sizeof(GLfloat);
-    case GL_FLOAT_VEC2:         return 2*sizeof(GLfloat);
-    case GL_FLOAT_VEC3:         return 3*sizeof(GLfloat);
-    case GL_FLOAT_VEC4:         return 4*sizeof(GLfloat);
-    case GL_DOUBLE:             return 1*sizeof(GLdouble);
-    case GL_DOUBLE_VEC2:        return 2*sizeof(GLdouble);
-    case GL_DOUBLE_VEC3:        return 3*sizeof(GLdouble);
-    case GL_DOUBLE_VEC4:        return 4*sizeof(GLdouble);
-    case GL_INT:                return 1*sizeof(GLint);
-    case GL_INT_VEC2:           return 2*sizeof(GLint);
-    case GL_INT_VEC3:           return 3*sizeof(GLint);
-    case GL_INT_VEC4:           return 4*sizeof(GLint);
-    case GL_UNSIGNED_INT:       return 1*sizeof(GLuint);
-    case GL_UNSIGNED_INT_VEC2:  return 2*sizeof(GLuint);
-    case GL_UNSIGNED_INT_VEC3:  return 3*sizeof(GLuint);
-    case GL_UNSIGNED_INT_VEC4:  return 4*sizeof(GLuint);
-    case GL_BOOL:               return 1*sizeof(GLuint);
-    case GL_BOOL_VEC2:          return 2*sizeof(GLuint);
-    case GL_BOOL_VEC3:          return 3*sizeof(GLuint);
-    case GL_BOOL_VEC4:          return 4*sizeof(GLuint);
-    case GL_FLOAT_MAT2:         return  4*sizeof(GLfloat);
-    case GL_FLOAT_MAT3:         return  9*sizeof(GLfloat);
-    case GL_FLOAT_MAT4:         return 16*sizeof(GLfloat);
-    case GL_FLOAT_MAT2x3:       return  6*sizeof(GLfloat);
-    case GL_FLOAT_MAT3x2:       return  6*sizeof(GLfloat);
-    case GL_FLOAT_MAT2x4:       return  8*sizeof(GLfloat);
-    case GL_FLOAT_MAT4x2:       return  8*sizeof(GLfloat);
-    case GL_FLOAT_MAT3x4:       return 12*sizeof(GLfloat);
-    case GL_FLOAT_MAT4x3:       return 12*sizeof(GLfloat);
-    case GL_DOUBLE_MAT2:        return  4*sizeof(GLdouble);
-    case GL_DOUBLE_MAT3:        return  9*sizeof(GLdouble);
-    case GL_DOUBLE_MAT4:        return 16*sizeof(GLdouble);
-    case GL_DOUBLE_MAT2x3:      return  6*sizeof(GLdouble);
-    case GL_DOUBLE_MAT3x2:      return  6*sizeof(GLdouble);
-    case GL_DOUBLE_MAT2x4:      return  8*sizeof(GLdouble);
-    case GL_DOUBLE_MAT4x2:      return  8*sizeof(GLdouble);
-    case GL_DOUBLE_MAT3x4:      return 12*sizeof(GLdouble);
-    case GL_DOUBLE_MAT4x3:      return 12*sizeof(GLdouble);
-    case GL_TEXTURE_1D:
-    case GL_TEXTURE_2D:
-    case GL_TEXTURE_3D:
-    case GL_TEXTURE_1D_ARRAY:
-    case GL_TEXTURE_2D_ARRAY:
-    case GL_TEXTURE_RECTANGLE:
-    case GL_TEXTURE_CUBE_MAP:
-    case GL_TEXTURE_BUFFER:
-    case GL_TEXTURE_2D_MULTISAMPLE:
-    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
-        return sizeof(GLuint);
-    default:
-        return 0;
+        const uniform_wrapper* w = uniform.value;
+        const GLubyte* data = uniform.owner->getData( *w );
+
+        if (w->upload)
+        {
+            w->upload( uniform.location, w->size, data );
+        }
+        else if (program.usesBindlessTextures())
+        {
+            const GLuint texture = *( (const GLuint*) data );
+            program.setTextureHandle( uniform.index,
+                                      GLState::getInstance().getTextureHandle(texture) );
+        }
+        else if (uniform.unit >= 0)
+        {
+            // the unit is fixed per program, only the texture may change
+            GLState::getInstance().bindTexture( uniform.unit, w->type, *( (const GLuint*) data ) );
+        }
+
+        checkGLErrorLabel(getUniformName(uniform.name));
     }
+
+	this->applyImageTextures();
+
+    // upload the globals block (if changed) and bind it to its binding point
+    const GlobalUniformBlock* globals = this->updateGlobals();
+    if (globals)
+        globals->bind();
 }
 
 // -------------------------------------------------------------------------
 
-void applyUniform( GLint location, GLenum type, GLsizei size, GLvoid* ptr,
-                   GLint& textureUnit )
+/**
+ * @brief Hashes the textures the samplers of a program resolve to, e.g. to
+ * sort draw calls by texture state (see RenderQueue).
+ */
+size_t UniformSet::getTextureHash( const ShaderProgram& program ) const
 {
-    switch( type )
+    size_t out = 0u;
+
+    for( const ResolvedUniform& uniform : resolve(program) )
     {
-    case GL_FLOAT:              glUniform1fv( location, size, (GLfloat*)ptr ); break;
-    case GL_FLOAT_VEC2:         glUniform2fv( location, size, (GLfloat*)ptr ); break;
-    case GL_FLOAT_VEC3:         glUniform3fv( location, size, (GLfloat*)ptr ); break;
-    case GL_FLOAT_VEC4:         glUniform4fv( location, size, (GLfloat*)ptr ); break;
-    case GL_DOUBLE:             glUniform1dv( location, size, (GLdouble*)ptr ); break;
-    case GL_DOUBLE_VEC2:        glUniform2dv( location, size, (GLdouble*)ptr ); break;
-    case GL_DOUBLE_VEC3:        glUniform3dv( location, size, (GLdouble*)ptr ); break;
-    case GL_DOUBLE_VEC4:        glUniform4dv( location, size, (GLdouble*)ptr ); break;
-    case GL_INT:                glUniform1iv( location, size, (GLint*)ptr ); break;
-    case GL_INT_VEC2:           glUniform2iv( location, size, (GLint*)ptr ); break;
-    case GL_INT_VEC3:           glUniform3iv( location, size, (GLint*)ptr ); break;
-    case GL_INT_VEC4:           glUniform4iv( location, size, (GLint*)ptr ); break;
-    case GL_UNSIGNED_INT:       glUniform1uiv( location, size, (GLuint*)ptr ); break;
-    case GL_UNSIGNED_INT_VEC2:  glUniform2uiv( location, size, (GLuint*)ptr ); break;
-    case GL_UNSIGNED_INT_VEC3:  glUniform3uiv( location, size, (GLuint*)ptr ); break;
-    case GL_UNSIGNED_INT_VEC4:  glUniform4uiv( location, size, (GLuint*)ptr ); break;
-    case GL_BOOL:               glUniform1uiv( location, size, (GLuint*)ptr ); break;
-    case GL_BOOL_VEC2:          glUniform2uiv( location, size, (GLuint*)ptr ); break;
-    case GL_BOOL_VEC3:          glUniform3uiv( location, size, (GLuint*)ptr ); break;
-    case GL_BOOL_VEC4:          glUniform4uiv( location, size, (GLuint*)ptr ); break;
-    case GL_FLOAT_MAT2:         glUniformMatrix2fv( location, size, GL_FALSE, (GLfloat*)ptr ); break;
-    case GL_FLOAT_MAT3:         glUniformMatrix3fv( location, size, GL_FALSE, (GLfloat*)ptr ); break;
-    case GL_FLOAT_MAT4:         glUniformMatrix4fv( location, size, GL_FALSE, (GLfloat*)ptr ); break;
-        //    case GL_FLOAT_MAT2x3:       return  6*sizeof(GLfloat);
-        //    case GL_FLOAT_MAT3x2:       return  6*sizeof(GLfloat);
-        //    case GL_FLOAT_MAT2x4:       return  8*sizeof(GLfloat);
-        //    case GL_FLOAT_MAT4x2:       return  8*sizeof(GLfloat);
-        //    case GL_FLOAT_MAT3x4:       return 12*sizeof(GLfloat);
-        //    case GL_FLOAT_MAT4x3:       return 12*sizeof(GLfloat);
-        //    case GL_DOUBLE_MAT2:        return  4*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT3:        return  9*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT4:        return 16*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT2x3:      return  6*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT3x2:      return  6*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT2x4:      return  8*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT4x2:      return  8*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT3x4:      return 12*sizeof(GLdouble);
-        //    case GL_DOUBLE_MAT4x3:      return 12*sizeof(GLdouble);
-    case GL_TEXTURE_1D:
-    case GL_TEXTURE_2D:
-    case GL_TEXTURE_3D:
-    case GL_TEXTURE_1D_ARRAY:
-    case GL_TEXTURE_2D_ARRAY:
-    case GL_TEXTURE_RECTANGLE:
-    case GL_TEXTURE_CUBE_MAP:
-    case GL_TEXTURE_BUFFER:
-    case GL_TEXTURE_2D_MULTISAMPLE:
-    case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
-        glUniform1i( location, textureUnit );
-        glActiveTexture( GL_TEXTURE0 + textureUnit );
-        glBindTexture( type, *( (GLuint*)ptr ) );
-        ++textureUnit;
-        break;
-    default:
-        std::cerr << "uniform type not implemented" << std::endl;
-        break;
+        const uniform_wrapper* w = uniform.value;
+        if( w->upload )
+            continue;
+
+        const GLuint texture = *( (const GLuint*) uniform.owner->getData( *w ) );
+        out = hashCombine( out, std::hash<GLuint>()( texture ) );
     }
+
+    return out;
 }
 
 // -------------------------------------------------------------------------
 
-void UniformSet::apply( GLuint program ) const
+/**
+ * @brief Returns the values the active uniforms of a program resolve to in
+ * this hierarchy. Uniforms without a value are left out.
+ */
+const std::vector<UniformSet::ResolvedUniform>&
+        UniformSet::resolve( const ShaderProgram& program ) const
 {
-    GLint nuniform;
-    glGetProgramiv( program, GL_ACTIVE_UNIFORMS, &nuniform );
-
-    GLint maxlen;
-    glGetProgramiv( program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen );
+    const unsigned long generation = getGeneration();
 
-    GLchar* name = new GLchar[maxlen];
+    ResolvedProgram* entry = nullptr;
+    for( ResolvedProgram& resolved : m_resolved )
+    {
+        if( resolved.program == &program )
+        {
+            entry = &resolved;
+            break;
+        }
+    }
 
-    GLint textureUnit = 0;
+    // the resolver check catches caches copied along with the set
+    if( entry && entry->resolver == this &&
+        entry->generation == generation &&
+        entry->programGeneration == program.getGeneration() )
+        return entry->uniforms;
 
-    for( int index=0; index<nuniform; ++index )
+    if( !entry )
     {
-        GLint  size;
-        GLenum type;
+        // a set is usually applied to a handful of programs only
+        if( m_resolved.size() >= 16u )
+            m_resolved.clear();
 
-        glGetActiveUniform( program, index, maxlen, NULL,
-                            &size,
-                            &type,
-                            name );
+        m_resolved.push_back( ResolvedProgram() );
+        entry = &m_resolved.back();
+        entry->program = &program;
+    }
 
-        const uniform_wrapper* w = AbstractValueSet::get(name);
+    entry->programGeneration = program.getGeneration();
+    entry->generation        = generation;
+    entry->resolver          = this;
+    entry->uniforms.clear();
 
-        if (!w)
-            continue;
+    const std::vector<ShaderProgram::ActiveUniform>& active = program.getActiveUniforms();
 
-        if( type == GL_DOUBLE )
-            std::cerr << *((GLdouble*)w->data) << std::endl;
+    for( GLuint index = 0; index < active.size(); ++index )
+    {
+        const ShaderProgram::ActiveUniform& uniform = active[index];
+
+        ResolvedUniform resolved;
+        resolved.name     = uniform.name;
+        resolved.index    = index;
+        resolved.location = uniform.location;
+        resolved.unit     = uniform.unit;
+        resolved.value    = find( uniform.name, &resolved.owner );
 
-        GLuint location = glGetUniformLocation( program, name );
-        applyUniform( location, w->type, w->size, w->data, textureUnit );
-        checkGLErrorLabel("Set uniform " + std::string(name));
+        if( resolved.value )
+            entry->uniforms.push_back( resolved );
     }
 
-    delete[] name;
+    return entry->uniforms;
+}
+
 
-	this->applyImageTextures();
+/**
+ * @brief Updates the globals blocks from the top of the hierarchy down to
+ * this set.
+ * @return The block of the closest set holding global values or null.
+ */
+const GlobalUniformBlock* UniformSet::updateGlobals() const
+{
+    const GlobalUniformBlock* base = nullptr;
+    if (this->m_parent)
+        base = this->m_parent->updateGlobals();
+
+    if (this->m_globals.isEmpty())
+        return base;
+
+    this->m_globals.update(base);
+    return &this->m_globals;
 }
 
 
@@ -200,64 +177,187 @@ void UniformSet::applyImageTextures() const
 {
 	// Apply parent image textures first
 	if (this->m_parent)
-		((UniformSet*) this->m_parent)->applyImageTextures();
+		this->m_parent->applyImageTextures();
 
 	for (auto& it : this->imageTextures)
-		glBindImageTexture(it.second.unit, it.second.texture, it.second.level, it.second.layered, it.second.layer, it.second.access, it.second.format);
+		GLState::getInstance().bindImageTexture(it.second.unit, it.second.texture, it.second.level, it.second.layered, it.second.layer, it.second.access, it.second.format);
 
 }
 
 // -------------------------------------------------------------------------
 
-void UniformSet::set( const std::string& name,
-                      GLenum type, GLsizei size, const GLvoid *data )
+/**
+ * @brief Returns the slot of a name in this set, creating an empty one if
+ * necessary.
+ */
+GLint UniformSet::getOrCreateSlot( const std::string& name )
 {
-    const size_t bytes = size * uniformTypeSize(type);
+    const GLuint id = internUniformName( name );
 
-    named_value_map::iterator ui = m_values.find( name );
-    uniform_wrapper* w;
+    if( id >= m_index.size() )
+        m_index.resize( id + 1, -1 );
 
-    if( ui == m_values.end() )
+    if( m_index[id] < 0 )
     {
-        ui = m_values.insert( make_pair(name, uniform_wrapper()) ).first;
-        w = &(ui->second);
-        w->type = type;
-        w->size = size;
-        w->data = new unsigned char[bytes];
+        uniform_wrapper w;
+        w.type   = 0;
+        w.size   = 0;
+        w.bytes  = 0;
+        w.upload = nullptr;
+        w.global = GlobalUniformBlock::findMember( name );
+        w.spill  = -1;
+        w.spillCapacity = 0;
+
+        m_index[id] = m_slots.size();
+        m_slots.push_back( w );
+
+        // resolved pointers into m_slots are invalidated
+        m_generation = nextGeneration();
     }
-    else
-    {
-        w = &(ui->second);
 
-        if( bytes != w->size * uniformTypeSize(w->type) )
-        {
-            delete[] w->data;
-            w->data = new unsigned char[bytes];
-        }
+    return m_index[id];
+}
 
-        w->type = type;
-        w->size = size;
-    }
+// -------------------------------------------------------------------------
+
+void UniformSet::set( GLint slot, GLenum type, GLsizei size, size_t bytes,
+                      const GLvoid *data, uniform_upload_function upload )
+{
+    uniform_wrapper* w = &m_slots[slot];
+
+    if( bytes > UNIFORM_INLINE_BYTES && bytes > w->spillCapacity )
+        reserveSpill( *w, bytes );
+
+    if( w->type == 0 )
+        m_generation = nextGeneration();
+
+    w->type   = type;
+    w->size   = size;
+    w->bytes  = bytes;
+    w->upload = upload;
+
+    GLubyte* target = getData( *w );
 
     if( type != GL_BOOL )
-        memcpy( (void*)w->data, data, bytes );
+        memcpy( target, data, bytes );
     else
         // cast boolean input to unsigned int
-        *((GLuint*) w->data) = *((GLboolean*) data);
+        *((GLuint*) target) = *((GLboolean*) data);
 
     // vector<bool> not supported
+
+    // stage members of the globals block for the uniform buffer
+    if( w->global >= 0 )
+        m_globals.set( w->global, type, size, data );
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Gives a slot an arena region of at least the given size. The last
+ * region of the arena grows in place, others are abandoned and the arena is
+ * compacted once half of it is abandoned.
+ */
+void UniformSet::reserveSpill( uniform_wrapper& w, size_t bytes )
+{
+    const size_t capacity = (bytes + 7u) & ~size_t(7u);
+
+    if( w.spill >= 0 && w.spill + w.spillCapacity == m_arena.size() )
+    {
+        m_arena.resize( w.spill + capacity );
+        w.spillCapacity = capacity;
+        return;
+    }
+
+    if( w.spill >= 0 )
+        m_arenaWaste += w.spillCapacity;
+
+    w.spill         = m_arena.size();
+    w.spillCapacity = capacity;
+    m_arena.resize( m_arena.size() + capacity );
+
+    if( m_arenaWaste > m_arena.size() / 2u )
+        compactArena();
+}
+
+// -------------------------------------------------------------------------
+
+/**
+ * @brief Moves the regions of all slots to the front of a new arena, dropping
+ * the abandoned ones.
+ */
+void UniformSet::compactArena()
+{
+    std::vector<GLubyte> arena;
+    arena.reserve( m_arena.size() - m_arenaWaste );
+
+    for( uniform_wrapper& w : m_slots )
+    {
+        if( w.spill < 0 )
+            continue;
+
+        const GLint spill = arena.size();
+        arena.insert( arena.end(), m_arena.begin() + w.spill, m_arena.begin() + w.spill + w.spillCapacity );
+        w.spill = spill;
+    }
+
+    m_arena.swap( arena );
+    m_arenaWaste = 0u;
 }
 
 // -------------------------------------------------------------------------
 
-void UniformSet::get( const std::string& name, GLenum type, GLsizei size, GLvoid* data )
+void UniformSet::clear( const std::string& name )
 {
-    const uniform_wrapper* w = AbstractValueSet::get(name);
+    const GLuint id = findUniformName( name );
+
+    if( id >= m_index.size() || m_index[id] < 0 )
+        return;
+
+    // keep the slot (and its storage) so that handles stay valid
+    uniform_wrapper& w = m_slots[m_index[id]];
+    if( w.type != 0 )
+    {
+        w.type = 0;
+        m_generation = nextGeneration();
+    }
+
+    if( w.global >= 0 )
+        m_globals.clear( w.global );
+}
+
+// -------------------------------------------------------------------------
+
+void UniformSet::clear()
+{
+    for( uniform_wrapper& w : m_slots )
+    {
+        w.type          = 0;
+        w.spill         = -1;
+        w.spillCapacity = 0;
+    }
+    m_arena.clear();
+    m_arenaWaste = 0u;
+
+    m_generation = nextGeneration();
+    m_globals.clear();
+}
+
+// -------------------------------------------------------------------------
+
+void UniformSet::get( const std::string& name, GLenum type, size_t bytes, GLvoid* data ) const
+{
+    const UniformSet* owner;
+    const uniform_wrapper* w = find( findUniformName(name), &owner );
 
     if (w)
     {
-        const size_t bytes = size * uniformTypeSize(type);
-        memcpy(data, w->data, bytes);
+        const GLubyte* source = owner->getData( *w );
+
+        if( type != GL_BOOL )
+            memcpy(data, source, std::min(bytes, w->bytes));
+        else
+            *((bool*) data) = *((const GLuint*) source) != 0u;
     }
 }
 
@@ -45,4 +45,16 @@ std::string getBaseDir()
         return ".";
     }
 }
+
+/**
+ * @brief Returns a new value of a process-wide, monotonically increasing
+ * counter. Used to version hierarchical sets (see AbstractValueSet, UniformSet
+ * and StateSet): a cached view of a chain of sets is valid as long as no set
+ * in the chain carries a generation newer than the cache.
+ */
+unsigned long nextGeneration()
+{
+    static unsigned long generation = 0u;
+    return ++generation;
+}
 }
@@ -21,6 +21,7 @@ Copyright 2016 Computational Topology Group, University of Kaiserslautern
 
 #include "ugl/VariantProgram.hpp"
 #include "ugl/GLSLPreprocessor.hpp"
+#include "ugl/GLState.hpp"
 #include "ugl/SourceSplitter.hpp"
 
 #include <algorithm>
@@ -188,6 +189,23 @@ ShaderProgram& VariantProgram::bind(const DefineMap& defineMap)
     FileSystemWatcher::getInstance().update();
 
     // Bind
+    ShaderProgram& program = getProgram(defineMap);
+    program.bind();
+
+    return program;
+}
+
+// ------------------------------------------------------------------------
+
+/**
+ * @brief Returns the variant for the given defines, compiling it if needed,
+ * without binding it.
+ *
+ * Unlike bind() this does not poll the file watcher, so the returned program
+ * stays alive until the next bind() (see RenderQueue).
+ */
+ShaderProgram& VariantProgram::getProgram(const DefineMap& defineMap)
+{
     CompiledProgramMap::iterator it = m_compiledProgramMap.find(defineMap);
     ShaderProgram* program;
 
@@ -206,6 +224,10 @@ ShaderProgram& VariantProgram::bind(const DefineMap& defineMap)
         for (std::vector<std::string>::const_iterator path = m_importPaths.begin(); path != m_importPaths.end(); ++path)
             preprocessor.add_import_path(*path);
 
+        // sampler uniforms take texture handles, see ShaderProgram
+        if (GLState::getInstance().isBindlessTexturesEnabled())
+            preprocessor.define("UGL_BINDLESS_TEXTURES", 1L);
+
         // add define statements from defineMap
         for (DefineMap::const_iterator defineToken = defineMap.begin();
              defineToken != defineMap.end(); ++defineToken)
@@ -253,9 +275,6 @@ ShaderProgram& VariantProgram::bind(const DefineMap& defineMap)
         program->link();
     }
 
-    // bind the program
-    program->bind();
-
     return *program;
 }
 